@@ -9,7 +9,7 @@ ExternalProject_Add(
   PATCH_COMMAND ""
 
   SOURCE_DIR "${CMAKE_SOURCE_DIR}/ext/re2-2017-07-01"
-  CMAKE_ARGS -BUILD_SHARED_LIBS=OFF -DCMAKE_BUILD_TYPE=Release -DCMAKE_POSITION_INDEPENDENT_CODE=True -DCMAKE_INSTALL_PREFIX=${GLOBAL_OUTPUT_PATH}/re2
+  CMAKE_ARGS -DBUILD_SHARED_LIBS=OFF -DCMAKE_BUILD_TYPE=Release -DCMAKE_POSITION_INDEPENDENT_CODE=True -DCMAKE_INSTALL_PREFIX=${GLOBAL_OUTPUT_PATH}/re2
 
   TEST_COMMAND ""
 )
@@ -122,6 +122,13 @@ int main(int argc, char **argv) {
           benchmark.registerFixture("no_join_order_permutation", config);
         }
 
+        {
+          // not using dynamic programming in join order optimization
+          QueryConfig config;
+          config.dp_join_order_max_nodes = 0;
+          benchmark.registerFixture("no_join_order_dp", config);
+        }
+
 
         // add different parallel configurations for threads and SIMD (+thread)
         unsigned int numOfCPUs = std::thread::hardware_concurrency();
@@ -39,6 +39,24 @@ bool BufferedEstimatedSearch::next(Match &m)
   return false;
 }
 
+bool BufferedEstimatedSearch::nextBatch(MatchBatch& batch)
+{
+  batch.clear();
+  while(!batch.full() && (!currentMatchBuffer.empty() || nextMatchBuffer(currentMatchBuffer)))
+  {
+    // move as many matches of the current buffer as fit into the batch
+    while(!currentMatchBuffer.empty() && !batch.full())
+    {
+      if(acceptedByOutputFilter(currentMatchBuffer.front()))
+      {
+        batch.add(currentMatchBuffer.front());
+      }
+      currentMatchBuffer.pop_front();
+    }
+  }
+  return !batch.empty();
+}
+
 void BufferedEstimatedSearch::reset()
 {
   currentMatchBuffer.clear();
@@ -16,11 +16,15 @@
 
 #pragma once
 
-#include <annis/iterators.h>  // for AnnoIt
+#include <annis/iterators.h>  // for AnnoIt, MatchBatch
+#include <stddef.h>           // for size_t
 #include <stdint.h>           // for int64_t
+#include <functional>         // for function
 #include <set>                // for set
 #include <string>             // for string
 #include <unordered_set>      // for unordered_set
+#include <utility>            // for pair
+#include <vector>             // for vector
 
 #include <boost/optional.hpp>
 
@@ -34,10 +38,40 @@ namespace annis
 class EstimatedSearch : public AnnoIt
 {
 public:
+  /**
+   * @brief A part of the search which adds its matches to a batch.
+   *
+   * Morsels don't change the state of the search they were created from and can be executed concurrently.
+   */
+  using Morsel = std::function<void(MatchBatch&)>;
+
   virtual std::int64_t guessMaxCount() const {return -1;}
 
   virtual std::string debugString() const {return "";}
 
+  /**
+   * @brief Split the complete search into morsels of about the given number of entries.
+   *
+   * The morsels apply the output filter and the constant annotation value which are set at the time of this call.
+   * @return An empty list if the search can't be split.
+   */
+  virtual std::vector<Morsel> createMorsels(size_t /*morselSize*/) {return std::vector<Morsel>();}
+
+  /**
+   * @brief The number of matches if it can be taken directly from the index without iterating over the matches.
+   */
+  virtual boost::optional<std::uint64_t> countFromIndex() {return boost::optional<std::uint64_t>();}
+
+  virtual std::uint64_t count() override
+  {
+    boost::optional<std::uint64_t> result = countFromIndex();
+    if(result)
+    {
+      return *result;
+    }
+    return AnnoIt::count();
+  }
+
 
   /**
    * @brief Set a constant annotation value that is returned in a match instead of the actual matched annotation.
@@ -58,6 +92,63 @@ public:
   {
     return _constAnno;
   }
+protected:
+  /**
+   * @brief Create morsels for ranges of the inverse annotation index.
+   *
+   * The ranges must not contain the same node twice if a constant annotation value is set.
+   *
+   * @param annoFilter If set, only entries where the annotation is accepted by this function are included.
+   * The function is called once for each distinct annotation of a morsel.
+   */
+  template<typename ItType>
+  std::vector<Morsel> createRangeMorsels(const std::vector<std::pair<ItType, ItType>>& ranges, size_t morselSize,
+                                         std::function<bool(const Annotation&)> annoFilter = nullptr)
+  {
+    std::vector<Morsel> result;
+    const MatchFilter filter = getOutputFilter();
+    const boost::optional<Annotation> constAnno = getConstAnnoValue();
+    for(const auto& r : ranges)
+    {
+      ItType it = r.first;
+      while(it != r.second)
+      {
+        // only iterate over the index to find the borders of the morsel
+        ItType morselBegin = it;
+        for(size_t i=0; i < morselSize && it != r.second; i++)
+        {
+          it++;
+        }
+        ItType morselEnd = it;
+
+        result.push_back([morselBegin, morselEnd, filter, constAnno, annoFilter](MatchBatch& batch)
+        {
+          boost::optional<std::pair<Annotation, bool>> lastAnno;
+          for(ItType itMorsel = morselBegin; itMorsel != morselEnd; itMorsel++)
+          {
+            if(annoFilter)
+            {
+              if(!lastAnno || !(lastAnno->first == itMorsel->first))
+              {
+                lastAnno = std::pair<Annotation, bool>(itMorsel->first, annoFilter(itMorsel->first));
+              }
+              if(!lastAnno->second)
+              {
+                continue;
+              }
+            }
+            Match m = {itMorsel->second, constAnno ? *constAnno : itMorsel->first};
+            if(filter(m))
+            {
+              batch.add(m);
+            }
+          }
+        });
+      }
+    }
+    return result;
+  }
+
 private:
   boost::optional<Annotation> _constAnno;
 };
@@ -69,6 +160,7 @@ public:
   BufferedEstimatedSearch(bool maximalOneNodeAnno, bool returnsNothing);
 
   virtual bool next(Match& m) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
   virtual void reset() override;
 
   virtual std::function<std::list<Annotation> (nodeid_t)> getNodeAnnoMatchGenerator() = 0;
@@ -20,6 +20,7 @@
 #include <boost/container/flat_map.hpp>  // for flat_multimap
 #include <boost/container/vector.hpp>    // for operator!=, vec_iterator
 #include <cstdint>                       // for uint32_t, int64_t
+#include <iterator>                      // for next
 #include <limits>                        // for numeric_limits
 #include <utility>                       // for pair
 #include "annis/annostorage.h"           // for AnnoStorage
@@ -38,7 +39,7 @@ ExactAnnoKeySearch::ExactAnnoKeySearch(const DB &db)
   it = itBegin;
 
   itKeyBegin = db.nodeAnnos.annoKeys.begin();
-  itKeyBegin = db.nodeAnnos.annoKeys.end();
+  itKeyEnd = db.nodeAnnos.annoKeys.end();
 }
 
 ExactAnnoKeySearch::ExactAnnoKeySearch(const DB& db, const string& annoName)
@@ -165,6 +166,32 @@ std::int64_t ExactAnnoKeySearch::guessMaxCount() const
 }
 
 
+std::vector<EstimatedSearch::Morsel> ExactAnnoKeySearch::createMorsels(size_t morselSize)
+{
+  if(getConstAnnoValue() && itKeyBegin != itKeyEnd && std::next(itKeyBegin) != itKeyEnd)
+  {
+    // the same node might have annotations for several of the keys
+    return std::vector<Morsel>();
+  }
+  return createRangeMorsels(std::vector<std::pair<ItAnnoNode, ItAnnoNode>>{{itBegin, itEnd}}, morselSize);
+}
+
+boost::optional<std::uint64_t> ExactAnnoKeySearch::countFromIndex()
+{
+  if(hasOutputFilter() || (getConstAnnoValue() && itKeyBegin != itKeyEnd && std::next(itKeyBegin) != itKeyEnd))
+  {
+    return boost::optional<std::uint64_t>();
+  }
+
+  std::uint64_t result = 0;
+  for(ItAnnoKey itKey = itKeyBegin; itKey != itKeyEnd; itKey++)
+  {
+    const AnnotationKey& key = itKey->first;
+    result += db.nodeAnnos.inverseAnnotations.count({key.name, key.ns, 0}, {key.name, key.ns, uintmax});
+  }
+  return result;
+}
+
 ExactAnnoKeySearch::~ExactAnnoKeySearch()
 {
 
@@ -24,6 +24,7 @@
 #include <stdint.h>                             // for int64_t, uint64_t
 #include <set>                                  // for set
 #include <string>                               // for string
+#include <vector>                               // for vector
 #include <annis/types.h>                        // for AnnotationKey, Match ...
 namespace annis { class DB; }
 
@@ -33,7 +34,7 @@ namespace annis
 
 class ExactAnnoKeySearch : public EstimatedSearch
 {
-  using ItAnnoNode = AnnoStorage<nodeid_t>::InverseAnnoMap_t::const_iterator;
+  using ItAnnoNode = NodeAnnoStorage::InverseAnnoMap_t::const_iterator;
   using ItAnnoKey = btree::btree_map<AnnotationKey, std::uint64_t>::const_iterator;
 
 public:
@@ -68,6 +69,9 @@ public:
 
   virtual std::string debugString() const override {return debugDescription;}
 
+  virtual std::vector<Morsel> createMorsels(size_t morselSize) override;
+  virtual boost::optional<std::uint64_t> countFromIndex() override;
+
 private:
   const DB& db;
 
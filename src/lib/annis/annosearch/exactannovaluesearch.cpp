@@ -172,6 +172,34 @@ std::int64_t ExactAnnoValueSearch::guessMaxCount() const
   return sum;
 }
 
+std::vector<EstimatedSearch::Morsel> ExactAnnoValueSearch::createMorsels(size_t morselSize)
+{
+  if(getConstAnnoValue() && searchRanges.size() > 1)
+  {
+    // the same node might be included in the ranges of different annotation keys
+    return std::vector<Morsel>();
+  }
+  return createRangeMorsels(std::vector<Range>(searchRanges.begin(), searchRanges.end()), morselSize);
+}
+
+boost::optional<std::uint64_t> ExactAnnoValueSearch::countFromIndex()
+{
+  if(hasOutputFilter() || (getConstAnnoValue() && searchRanges.size() > 1))
+  {
+    return boost::optional<std::uint64_t>();
+  }
+
+  std::uint64_t result = 0;
+  for(const Range& range : searchRanges)
+  {
+    if(range.first != range.second)
+    {
+      result += db.nodeAnnos.inverseAnnotations.count(range.first->first);
+    }
+  }
+  return result;
+}
+
 ExactAnnoValueSearch::~ExactAnnoValueSearch()
 {
 
@@ -21,6 +21,7 @@
 #include <string>               // for string
 #include <unordered_set>        // for unordered_set
 #include <utility>              // for pair
+#include <vector>               // for vector
 #include <annis/annostorage.h>  // for AnnoStorage, AnnoStorage<>::InverseAn...
 #include <annis/types.h>        // for Annotation (ptr only), Match (ptr only)
 #include <annis/annosearch/estimatedsearch.h>   // for EstimatedSearch
@@ -32,7 +33,7 @@ namespace annis
 
 class ExactAnnoValueSearch : public EstimatedSearch
 {
-  using ItType = AnnoStorage<nodeid_t>::InverseAnnoMap_t::const_iterator;
+  using ItType = NodeAnnoStorage::InverseAnnoMap_t::const_iterator;
   using Range = std::pair<ItType, ItType>;
 
 public:
@@ -64,6 +65,9 @@ public:
 
   virtual std::string debugString() const override {return debugDescription;}
 
+  virtual std::vector<Morsel> createMorsels(size_t morselSize) override;
+  virtual boost::optional<std::uint64_t> countFromIndex() override;
+
 
 private:
   const DB& db;
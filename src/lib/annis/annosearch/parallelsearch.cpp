@@ -0,0 +1,112 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "parallelsearch.h"
+
+#include <algorithm>  // for move
+
+using namespace annis;
+
+ParallelSearch::ParallelSearch(std::shared_ptr<EstimatedSearch> search, size_t morselSize,
+                               size_t numOfTasks, std::shared_ptr<ThreadPool> threadPool)
+  : search(search), morselSize(morselSize), numOfTasks(numOfTasks),
+    initialized(false), nextMorsel(0),
+    currentBatchPos(0),
+    tasks([this](std::shared_ptr<MorselTaskState> state) {processMorsel(state);}, numOfTasks, threadPool)
+{
+}
+
+void ParallelSearch::processMorsel(std::shared_ptr<MorselTaskState> state)
+{
+  if(!state)
+  {
+    const size_t idx = nextMorsel++;
+    if(!tasks.isRunning() || idx >= morsels.size())
+    {
+      tasks.finishTask();
+      return;
+    }
+
+    MatchBatch output;
+    morsels[idx](output);
+    if(!output.empty())
+    {
+      state = std::make_shared<MorselTaskState>();
+      state->pending.emplace_back(std::move(output));
+    }
+  }
+
+  // park the task instead of waiting until the consumer has fetched enough results
+  if(state && !tasks.flushOrPark(state))
+  {
+    return;
+  }
+
+  // give other tasks the chance to run before the next morsel is processed
+  tasks.continueWithNextMorsel();
+}
+
+bool ParallelSearch::next(Match& m)
+{
+  if(currentBatchPos >= currentBatch.size())
+  {
+    currentBatchPos = 0;
+    if(!nextBatch(currentBatch))
+    {
+      return false;
+    }
+  }
+  m = currentBatch.get(currentBatchPos++, 0);
+  return true;
+}
+
+bool ParallelSearch::nextBatch(MatchBatch& batch)
+{
+  batch.clear();
+
+  if(!initialized)
+  {
+    morsels = search->createMorsels(morselSize);
+    initialized = true;
+  }
+
+  if(morsels.empty() || numOfTasks == 0)
+  {
+    return search->nextBatch(batch);
+  }
+
+  if(!tasks.isRunning())
+  {
+    tasks.start();
+  }
+
+  return tasks.pop(batch);
+}
+
+void ParallelSearch::reset()
+{
+  tasks.stop();
+
+  search->reset();
+  nextMorsel = 0;
+  currentBatch.clear();
+  currentBatchPos = 0;
+}
+
+ParallelSearch::~ParallelSearch()
+{
+  tasks.stop();
+}
@@ -0,0 +1,89 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/annosearch/estimatedsearch.h>  // for EstimatedSearch
+#include <annis/iterators.h>                    // for MatchBatch
+#include <annis/types.h>                        // for Match
+#include <annis/util/morseltasks.h>             // for MorselTasks, MorselTaskState
+#include <stddef.h>                             // for size_t
+#include <stdint.h>                             // for int64_t, uint64_t
+#include <boost/optional.hpp>                   // for optional
+#include <atomic>                               // for atomic
+#include <memory>                               // for shared_ptr
+#include <string>                               // for string
+#include <vector>                               // for vector
+
+namespace annis { class ThreadPool; }
+
+namespace annis
+{
+
+/**
+ * @brief Executes the morsels of another search in parallel.
+ *
+ * Each task of the thread pool executes one morsel and enqueues a task for the next morsel when it is finished.
+ * The results are returned in batches, their order is not deterministic.
+ * If the wrapped search can't be split into morsels it is executed sequentially.
+ */
+class ParallelSearch : public EstimatedSearch
+{
+public:
+  ParallelSearch(std::shared_ptr<EstimatedSearch> search, size_t morselSize,
+                 size_t numOfTasks, std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>());
+
+  virtual bool next(Match& m) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
+  virtual void reset() override;
+
+  virtual std::int64_t guessMaxCount() const override
+  {
+    return search->guessMaxCount();
+  }
+
+  virtual std::string debugString() const override
+  {
+    return search->debugString();
+  }
+
+  virtual boost::optional<std::uint64_t> countFromIndex() override
+  {
+    return search->countFromIndex();
+  }
+
+  virtual ~ParallelSearch();
+
+private:
+  std::shared_ptr<EstimatedSearch> search;
+  const size_t morselSize;
+  const size_t numOfTasks;
+
+  bool initialized;
+  std::vector<Morsel> morsels;
+  std::atomic<size_t> nextMorsel;
+
+  /** Buffer for the match-wise next() function */
+  MatchBatch currentBatch;
+  size_t currentBatchPos;
+
+  MorselTasks<> tasks;
+
+private:
+  void processMorsel(std::shared_ptr<MorselTaskState> state);
+};
+
+} // end namespace annis
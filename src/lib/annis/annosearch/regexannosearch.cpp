@@ -20,6 +20,7 @@
 #include <google/btree_map.h>            // for btree_map
 #include <boost/container/flat_map.hpp>  // for flat_multimap
 #include <boost/container/vector.hpp>    // for vec_iterator, operator!=
+#include <algorithm>                     // for binary_search
 #include <cstdint>                       // for uint32_t, int64_t
 #include "annis/annostorage.h"           // for AnnoStorage
 #include "annis/db.h"                    // for DB
@@ -30,11 +31,13 @@
 using namespace annis;
 
 RegexAnnoSearch::RegexAnnoSearch(const DB &db, const std::string& ns,
-                                 const std::string& name, const std::string& valRegex)
+                                 const std::string& name, const std::string& valRegex,
+                                 std::shared_ptr<ThreadPool> threadPool, size_t numOfTasks)
   : db(db),
     annoKeyNamespace(ns), annoKeyName(name),
     valRegex(valRegex),
     compiledValRegex(valRegex, RE2::Quiet),
+    valuesFromDictionary(false),
     debugDescription(ns + ":" + name + "=/" + valRegex + "/")
 {
   auto nameID = db.strings.findID(name);
@@ -51,6 +54,8 @@ RegexAnnoSearch::RegexAnnoSearch(const DB &db, const std::string& ns,
     }
   }
 
+  initDictionarySearch(threadPool, numOfTasks);
+
   currentRange = searchRanges.begin();
   if(currentRange != searchRanges.end())
   {
@@ -58,6 +63,62 @@ RegexAnnoSearch::RegexAnnoSearch(const DB &db, const std::string& ns,
   }
 }
 
+bool RegexAnnoSearch::valueMatches(uint32_t valueID)
+{
+  if(valuesFromDictionary)
+  {
+    return std::binary_search(matchingValues.begin(), matchingValues.end(), valueID);
+  }
+  else if(compiledValRegex.ok())
+  {
+    boost::string_ref val = db.strings.strRef(valueID);
+    return RE2::FullMatch(re2::StringPiece(val.data(), val.size()), compiledValRegex);
+  }
+  return false;
+}
+
+void RegexAnnoSearch::initDictionarySearch(std::shared_ptr<ThreadPool> threadPool, size_t numOfTasks)
+{
+  if(!compiledValRegex.ok() || searchRanges.empty())
+  {
+    return;
+  }
+
+  size_t numOfEntries = 0;
+  for(const AnnotationKey& key : annoKeys)
+  {
+    auto itKey = db.nodeAnnos.annoKeys.find(key);
+    if(itKey != db.nodeAnnos.annoKeys.end())
+    {
+      numOfEntries += itKey->second;
+    }
+  }
+
+  // Only evaluate the regex on the string storage if there are less candidate strings than annotation entries.
+  // Otherwise iterating over the distinct values of the annotation keys is cheaper.
+  if(db.strings.countRegexCandidates(compiledValRegex, numOfEntries) >= numOfEntries)
+  {
+    return;
+  }
+
+  matchingValues = db.strings.findRegexIDs(compiledValRegex, threadPool, numOfTasks);
+  valuesFromDictionary = true;
+
+  // replace the search ranges with the ranges of the matching values
+  searchRanges.clear();
+  for(const AnnotationKey& key : annoKeys)
+  {
+    for(std::uint32_t val : matchingValues)
+    {
+      auto range = db.nodeAnnos.inverseAnnotations.equal_range({key.name, key.ns, val});
+      if(range.first != range.second)
+      {
+        searchRanges.push_back(Range(range.first, range.second));
+      }
+    }
+  }
+}
+
 bool RegexAnnoSearch::valueMatchesAllStrings() const
 {
   if(compiledValRegex.ok())
@@ -72,11 +133,13 @@ bool RegexAnnoSearch::valueMatchesAllStrings() const
 
 
 RegexAnnoSearch::RegexAnnoSearch(const DB &db,
-                                 const std::string& name, const std::string& valRegex)
+                                 const std::string& name, const std::string& valRegex,
+                                 std::shared_ptr<ThreadPool> threadPool, size_t numOfTasks)
   : db(db),
     annoKeyName(name),
     valRegex(valRegex),
     compiledValRegex(valRegex, RE2::Quiet),
+    valuesFromDictionary(false),
     debugDescription(name + "=/" + valRegex + "/")
 {
   if(compiledValRegex.ok())
@@ -96,6 +159,9 @@ RegexAnnoSearch::RegexAnnoSearch(const DB &db,
       }
     }
   } // end if the regex is ok
+
+  initDictionarySearch(threadPool, numOfTasks);
+
   currentRange = searchRanges.begin();
 
   if(currentRange != searchRanges.end())
@@ -112,7 +178,7 @@ bool RegexAnnoSearch::next(Match& result)
     {
       while(it != currentRange->second)
       {
-        if(RE2::FullMatch(db.strings.str(it->first.val), compiledValRegex))
+        if(valuesFromDictionary || valueMatches(it->first.val))
         {
           result = {it->second, it->first};
           it++;
@@ -164,6 +230,22 @@ void RegexAnnoSearch::reset()
 }
 
 
+std::vector<EstimatedSearch::Morsel> RegexAnnoSearch::createMorsels(size_t morselSize)
+{
+  if(!compiledValRegex.ok() || (getConstAnnoValue() && annoKeys.size() > 1))
+  {
+    return std::vector<Morsel>();
+  }
+
+  std::function<bool(const Annotation&)> annoFilter;
+  if(!valuesFromDictionary)
+  {
+    // RE2 can be used from several threads at once
+    annoFilter = [this](const Annotation& anno) -> bool {return valueMatches(anno.val);};
+  }
+  return createRangeMorsels(std::vector<Range>(searchRanges.begin(), searchRanges.end()), morselSize, annoFilter);
+}
+
 RegexAnnoSearch::~RegexAnnoSearch()
 {
 
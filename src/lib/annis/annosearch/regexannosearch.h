@@ -20,6 +20,7 @@
 #include <re2/re2.h>            // for RE2
 #include <stdint.h>             // for int64_t
 #include <list>                 // for list, list<>::const_iterator
+#include <memory>               // for shared_ptr
 #include <set>                  // for set
 #include <string>               // for string
 #include <unordered_set>        // for unordered_set
@@ -28,6 +29,7 @@
 #include <annis/types.h>        // for Annotation, AnnotationKey, Match (ptr...
 #include <annis/annosearch/estimatedsearch.h>   // for EstimatedSearch
 namespace annis { class DB; }
+namespace annis { class ThreadPool; }
 
 
 
@@ -36,12 +38,14 @@ namespace annis
 
   class RegexAnnoSearch : public EstimatedSearch
   {
-    using AnnoItType = AnnoStorage<nodeid_t>::InverseAnnoMap_t::const_iterator;
+    using AnnoItType = NodeAnnoStorage::InverseAnnoMap_t::const_iterator;
     using Range = std::pair<AnnoItType, AnnoItType>;
 
   public:
-    RegexAnnoSearch(const DB& db, const std::string &name, const std::string &valRegex);
-    RegexAnnoSearch(const DB& db, const std::string &ns, const std::string &name, const std::string &valRegex);
+    RegexAnnoSearch(const DB& db, const std::string &name, const std::string &valRegex,
+                    std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>(), size_t numOfTasks = 0);
+    RegexAnnoSearch(const DB& db, const std::string &ns, const std::string &name, const std::string &valRegex,
+                    std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>(), size_t numOfTasks = 0);
 
 
     const std::set<AnnotationKey>& getValidAnnotationKeys() const
@@ -49,15 +53,22 @@ namespace annis
       return annoKeys;
     }
 
-    bool valueMatches(const std::string& str)
+    bool valueMatches(boost::string_ref str)
     {
       if(compiledValRegex.ok())
       {
-        return RE2::FullMatch(str, compiledValRegex);
+        return RE2::FullMatch(re2::StringPiece(str.data(), str.size()), compiledValRegex);
       }
       return false;
     }
 
+    /**
+     * @brief Check if the string with the given ID matches the regular expression.
+     *
+     * If the matching values were already calculated from the string storage this is only a lookup.
+     */
+    bool valueMatches(std::uint32_t valueID);
+
     bool valueMatchesAllStrings() const;
 
     boost::optional<std::string> getAnnoKeyNamespace() const
@@ -78,6 +89,8 @@ namespace annis
 
     virtual std::string debugString() const override {return debugDescription;}
 
+    virtual std::vector<Morsel> createMorsels(size_t morselSize) override;
+
     virtual ~RegexAnnoSearch();
   private:
     const DB& db;
@@ -93,12 +106,21 @@ namespace annis
     std::list<Range>::const_iterator currentRange;
     AnnoItType it;
 
+    /**
+     * @brief If true the search ranges only contain matching values and the regular expression
+     * has been evaluated on the string storage already.
+     */
+    bool valuesFromDictionary;
+    /** Sorted IDs of all matching values, only set if valuesFromDictionary is true. */
+    std::vector<std::uint32_t> matchingValues;
+
     const std::string debugDescription;
 
     std::unordered_set<nodeid_t> uniqueResultFilter;
 
   private:
     void initializeValidAnnotationKeys();
+    void initDictionarySearch(std::shared_ptr<ThreadPool> threadPool, size_t numOfTasks);
     
   };
 } // end namespace annis
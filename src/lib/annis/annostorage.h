@@ -19,6 +19,7 @@
 #include <annis/stringstorage.h>                  // for StringStorage
 #include <annis/types.h>                          // for Annotation, Annotat...
 #include <annis/util/size_estimator.h>            // for element_size
+#include <annis/util/postingindex.h>              // for PostingIndex
 #include <google/btree.h>                         // for btree_iterator
 #include <google/btree_container.h>               // for btree_unique_contai...
 #include <google/btree_map.h>                     // for btree_map, btree_mu...
@@ -33,6 +34,7 @@
 #include <limits>                                 // for numeric_limits
 #include <list>                                   // for list
 #include <map>                                    // for _Rb_tree_iterator, map
+#include <set>                                    // for set
 #include <memory>                                 // for allocator_traits<>:...
 #include <string>                                 // for string
 #include <utility>                                // for pair
@@ -47,6 +49,60 @@ namespace annis {
 
   namespace bc = boost::container;
 
+  /**
+   * @brief Maps the items of an annotation storage to a position in a dense column.
+   *
+   * Only item types with a dense integer representation (like node IDs) can be stored in columns.
+   */
+  template<typename ContainerType>
+  struct DenseColumnIndex
+  {
+    static const bool supported = false;
+    static size_t pos(const ContainerType& item) {return 0;}
+    static ContainerType item(size_t pos) {return ContainerType();}
+  };
+
+  template<>
+  struct DenseColumnIndex<nodeid_t>
+  {
+    static const bool supported = true;
+    static size_t pos(const nodeid_t& item) {return item;}
+    static nodeid_t item(size_t pos) {return static_cast<nodeid_t>(pos);}
+  };
+
+
+  /**
+   * @brief Removes a single item from the items of an annotation in an inverse annotation map.
+   *
+   * Erasing the whole key would also remove all other items with the same annotation.
+   */
+  template<typename InverseAnnoMap>
+  struct InverseAnnoEraser
+  {
+    template<typename ContainerType>
+    static void erase(InverseAnnoMap& inverse, const Annotation& anno, const ContainerType& item)
+    {
+      auto range = inverse.equal_range(anno);
+      for(auto it=range.first; it != range.second; it++)
+      {
+        if(!(it->second < item) && !(item < it->second))
+        {
+          inverse.erase(it);
+          return;
+        }
+      }
+    }
+  };
+
+  template<>
+  struct InverseAnnoEraser<PostingIndex<Annotation>>
+  {
+    static void erase(PostingIndex<Annotation>& inverse, const Annotation& anno, nodeid_t item)
+    {
+      inverse.erase(anno, item);
+    }
+  };
+
 
   template<typename ContainerType,
            class AnnoMap = bc::flat_map<TypeAnnotationKey<ContainerType>, std::uint32_t>,
@@ -70,7 +126,25 @@ namespace annis {
 
     void addAnnotation(ContainerType item, const Annotation& anno)
     {
-      annotations.insert(std::pair<TypeAnnotationKey<ContainerType>, uint32_t>({item, anno.name, anno.ns}, anno.val));
+      auto itColumn = columns.find({anno.name, anno.ns});
+      if(itColumn != columns.end())
+      {
+        std::vector<std::uint32_t>& c = itColumn->second;
+        const size_t pos = DenseColumnIndex<ContainerType>::pos(item);
+        if(pos >= c.size())
+        {
+          c.resize(pos+1, STRING_STORAGE_ANY);
+        }
+        // behave like the insert into the map and do not overwrite an existing value
+        if(c[pos] == STRING_STORAGE_ANY)
+        {
+          c[pos] = anno.val;
+        }
+      }
+      else
+      {
+        annotations.insert(std::pair<TypeAnnotationKey<ContainerType>, uint32_t>({item, anno.name, anno.ns}, anno.val));
+      }
       inverseAnnotations.insert(std::pair<Annotation, ContainerType>(anno, item));
       btree::btree_map<AnnotationKey, std::uint64_t>::iterator itKey = annoKeys.find({anno.name, anno.ns});
       if(itKey == annoKeys.end())
@@ -85,6 +159,15 @@ namespace annis {
 
     void addAnnotationBulk(std::list<std::pair<TypeAnnotationKey<ContainerType>, ContainerType>>& annos)
     {
+      if(!columns.empty())
+      {
+        for(const auto& entry : annos)
+        {
+          addAnnotation(entry.first.id, {entry.first.anno_name, entry.first.anno_ns, entry.second});
+        }
+        return;
+      }
+
       annos.sort();
       annotations.insert(annos.begin(), annos.end());
 
@@ -119,14 +202,26 @@ namespace annis {
 
     void deleteAnnotation(ContainerType id, const AnnotationKey& anno)
     {
-       auto it = annotations.find({id, anno.name, anno.ns});
-       if(it != annotations.end())
+       boost::optional<Annotation> existing = getAnnotations(id, anno.ns, anno.name);
+       if(existing)
        {
-          Annotation oldAnno = {anno.name, anno.ns, it->second};
-          annotations.erase(it);
+          Annotation oldAnno = *existing;
+          auto itColumn = columns.find(anno);
+          if(itColumn != columns.end())
+          {
+            itColumn->second[DenseColumnIndex<ContainerType>::pos(id)] = STRING_STORAGE_ANY;
+          }
+          else
+          {
+            auto it = annotations.find({id, anno.name, anno.ns});
+            if(it != annotations.end())
+            {
+              annotations.erase(it);
+            }
+          }
 
-          // also delete the inverse annotation
-          inverseAnnotations.erase(oldAnno);
+          // also delete the inverse annotation, other items can have the same annotation
+          InverseAnnoEraser<InverseAnnoMap_t>::erase(inverseAnnotations, oldAnno, id);
 
           // decrease the annotation count for this key
           btree::btree_map<AnnotationKey, std::uint64_t>::iterator itAnnoKey = annoKeys.find(anno);
@@ -145,6 +240,22 @@ namespace annis {
 
     inline boost::optional<Annotation> getAnnotations(const ContainerType &id, const std::uint32_t& nsID, const std::uint32_t& nameID) const
     {
+      if(!columns.empty())
+      {
+        auto itColumn = columns.find({nameID, nsID});
+        if(itColumn != columns.end())
+        {
+          const std::vector<std::uint32_t>& c = itColumn->second;
+          const size_t pos = DenseColumnIndex<ContainerType>::pos(id);
+          if(pos < c.size() && c[pos] != STRING_STORAGE_ANY)
+          {
+            Annotation anno = {nameID, nsID, c[pos]};
+            return std::move(anno);
+          }
+          return boost::none;
+        }
+      }
+
       auto it = annotations.find({id, nameID, nsID});
 
       if (it != annotations.end())
@@ -188,12 +299,152 @@ namespace annis {
         result.push_back({key.anno_name, key.anno_ns, it->second});
       }
 
+      if(!columns.empty())
+      {
+        const size_t pos = DenseColumnIndex<ContainerType>::pos(id);
+        for(const auto& c : columns)
+        {
+          if(pos < c.second.size() && c.second[pos] != STRING_STORAGE_ANY)
+          {
+            result.push_back({c.first.name, c.first.ns, c.second[pos]});
+          }
+        }
+        // keep the same order as if all annotations would be stored in the map
+        std::sort(result.begin(), result.end());
+      }
+
       return result;
     }
 
     size_t numberOfAnnotations() const
     {
-      return annotations.size();
+      size_t result = annotations.size();
+      for(const auto& c : columns)
+      {
+        auto itKey = annoKeys.find(c.first);
+        if(itKey != annoKeys.end())
+        {
+          result += itKey->second;
+        }
+      }
+      return result;
+    }
+
+    /**
+     * @brief Returns the largest item which has at least one annotation.
+     */
+    boost::optional<ContainerType> maxItem() const
+    {
+      boost::optional<ContainerType> result;
+      if(!annotations.empty())
+      {
+        result = annotations.rbegin()->first.id;
+      }
+      for(const auto& c : columns)
+      {
+        // find the last used position in the column
+        for(size_t pos = c.second.size(); pos > 0; pos--)
+        {
+          if(c.second[pos-1] != STRING_STORAGE_ANY)
+          {
+            ContainerType item = DenseColumnIndex<ContainerType>::item(pos-1);
+            if(!result || *result < item)
+            {
+              result = item;
+            }
+            break;
+          }
+        }
+      }
+      return result;
+    }
+
+    /**
+     * @brief Choose for each annotation key whether its annotations are stored in a dense column or in the annotation map.
+     *
+     * A key is stored in a column if it is present on at least half of the items, since a column entry only needs
+     * a third of the space of a map entry and can be accessed directly.
+     * Columns are converted back if the key becomes rare (below a quarter of the items).
+     * This has no effect if the item type does not support dense columns.
+     */
+    void optimizeColumns()
+    {
+      if(!DenseColumnIndex<ContainerType>::supported)
+      {
+        return;
+      }
+
+      auto maxItemID = maxItem();
+      if(!maxItemID)
+      {
+        columns.clear();
+        return;
+      }
+      const size_t numOfItems = DenseColumnIndex<ContainerType>::pos(*maxItemID) + 1;
+
+      std::set<AnnotationKey> newColumnKeys;
+      std::set<AnnotationKey> removedColumnKeys;
+      for(const auto& annoKey : annoKeys)
+      {
+        bool isColumn = columns.find(annoKey.first) != columns.end();
+        if(!isColumn && annoKey.second * 2 >= numOfItems)
+        {
+          newColumnKeys.insert(annoKey.first);
+        }
+        else if(isColumn && annoKey.second * 4 < numOfItems)
+        {
+          removedColumnKeys.insert(annoKey.first);
+        }
+      }
+      for(const auto& c : columns)
+      {
+        if(annoKeys.find(c.first) == annoKeys.end())
+        {
+          removedColumnKeys.insert(c.first);
+        }
+      }
+
+      if(newColumnKeys.empty() && removedColumnKeys.empty())
+      {
+        return;
+      }
+
+      // rebuild the annotation map in a single pass
+      std::vector<std::pair<TypeAnnotationKey<ContainerType>, std::uint32_t>> mapEntries;
+      mapEntries.reserve(annotations.size());
+      for(const AnnotationKey& key : newColumnKeys)
+      {
+        columns[key] = std::vector<std::uint32_t>(numOfItems, STRING_STORAGE_ANY);
+      }
+      for(const auto& entry : annotations)
+      {
+        auto itColumn = columns.find({entry.first.anno_name, entry.first.anno_ns});
+        if(itColumn != columns.end() && newColumnKeys.find(itColumn->first) != newColumnKeys.end())
+        {
+          itColumn->second[DenseColumnIndex<ContainerType>::pos(entry.first.id)] = entry.second;
+        }
+        else
+        {
+          mapEntries.push_back(entry);
+        }
+      }
+      for(const AnnotationKey& key : removedColumnKeys)
+      {
+        auto itColumn = columns.find(key);
+        const std::vector<std::uint32_t>& c = itColumn->second;
+        for(size_t pos=0; pos < c.size(); pos++)
+        {
+          if(c[pos] != STRING_STORAGE_ANY)
+          {
+            mapEntries.push_back({{DenseColumnIndex<ContainerType>::item(pos), key.name, key.ns}, c[pos]});
+          }
+        }
+        columns.erase(itColumn);
+      }
+
+      std::sort(mapEntries.begin(), mapEntries.end());
+      annotations.clear();
+      annotations.insert(mapEntries.begin(), mapEntries.end());
     }
 
 
@@ -272,6 +523,9 @@ namespace annis {
           }
         }
       }
+
+      // the annotation key counts are final now, which makes this a good time to decide which keys are stored as columns
+      optimizeColumns();
     }
 
     bool hasStatistics() const
@@ -375,6 +629,7 @@ namespace annis {
       annoKeys.clear();
 
       histogramBounds.clear();
+      columns.clear();
     }
 
     void copyStatistics(const btree::btree_map<AnnotationKey, std::vector<std::string>>& stats)
@@ -392,11 +647,18 @@ namespace annis {
           histoStringsSize += s.capacity();
         }
       }
+      size_t columnsSize = 0;
+      for(const auto& c : columns)
+      {
+        columnsSize += c.second.capacity() * sizeof(std::uint32_t);
+      }
       return
           size_estimation::element_size(annotations)
           + size_estimation::element_size(inverseAnnotations)
           + size_estimation::element_size(annoKeys)
           + size_estimation::element_size(histogramBounds)
+          + size_estimation::element_size(columns)
+          + columnsSize
           + histoStringsSize;
     }
 
@@ -408,6 +670,30 @@ namespace annis {
       ar(annotations, inverseAnnotations, annoKeys, histogramBounds);
     }
 
+    /**
+     * @brief Load a storage which was saved with a different type for the inverse annotation map.
+     */
+    template <class OtherInverseAnnoMap, class Archive>
+    void loadWithInverseFormat( Archive & ar )
+    {
+      OtherInverseAnnoMap otherInverseAnnotations;
+      ar(annotations, otherInverseAnnotations, annoKeys, histogramBounds);
+
+      inverseAnnotations.clear();
+      inverseAnnotations.insert(otherInverseAnnotations.begin(), otherInverseAnnotations.end());
+    }
+
+    /**
+     * @brief Serialize the dense columns.
+     *
+     * They are not part of the default serialization, so storages without columns keep their format.
+     */
+    template <class Archive>
+    void serializeColumns( Archive & ar )
+    {
+      ar(columns);
+    }
+
   private:
 
     /**
@@ -421,6 +707,14 @@ namespace annis {
 
     /* additional statistical information */
     btree::btree_map<AnnotationKey, std::vector<std::string>> histogramBounds;
+
+    /**
+     * @brief Dense columns for annotation keys which are present on most items.
+     *
+     * The value for an item is stored at its position, STRING_STORAGE_ANY marks items without this annotation.
+     * Annotations with these keys are not included in the annotation map, but still in the inverse annotation map.
+     */
+    btree::btree_map<AnnotationKey, std::vector<std::uint32_t>> columns;
     
     
   private:
@@ -495,6 +789,14 @@ namespace annis {
     }
   };
 
+  /**
+   * @brief Node annotation storage which stores the node IDs for each annotation as compressed posting list.
+   */
+  using NodeAnnoStorage =
+    AnnoStorage<nodeid_t,
+      bc::flat_map<NodeAnnotationKey, std::uint32_t>,
+      PostingIndex<Annotation>>;
+
   template<typename ContainerType> using BTreeMultiAnnoStorage =
     AnnoStorage<ContainerType,
       btree::btree_multimap<TypeAnnotationKey<ContainerType>, std::uint32_t>,
@@ -17,6 +17,7 @@
 #include "corpusstoragemanager.h"
 
 #include <annis/db.h>                                   // for DB
+#include <annis/util/threadpool.h>                      // for ThreadPool
 #include <annis/util/relannisloader.h>
 #include <humblelogging/api.h>                          // for HL_DEBUG, HUM...
 #include <humblelogging/logger.h>                       // for Logger
@@ -35,13 +36,18 @@
 #include <cereal/archives/binary.hpp>                   // for BinaryOutputA...
 #include <cereal/cereal.hpp>                            // for OutputArchive
 #include <fstream>                                      // for stringstream
+#include <chrono>                                       // for steady_clock
 #include <set>                                          // for _Rb_tree_iter...
+#include <thread>                                       // for thread
+#include <unordered_set>                                // for unordered_set
 #include <utility>                                      // for pair
 #include <vector>                                       // for vector
 #include "annis/api/graphupdate.h"                      // for GraphUpdate
 #include "annis/dbloader.h"                             // for DBLoader
+#include "annis/resultcache.h"                          // for ResultCache
 #include "annis/json/jsonqueryparser.h"                 // for JSONQueryParser
 #include "annis/query/query.h"
+#include "annis/query/plancache.h"                     // for PlanCache
 #include "annis/annostorage.h"                          // for AnnoStorage
 #include "annis/stringstorage.h"                        // for StringStorage
 #include "annis/types.h"                                // for Match, Annota...
@@ -63,34 +69,103 @@ namespace bf = boost::filesystem;
 
 HUMBLE_LOGGER(logger, "annis4");
 
-CorpusStorageManager::CorpusStorageManager(std::string databaseDir, size_t maxAllowedCacheSize)
-  : databaseDir(databaseDir), maxAllowedCacheSize(maxAllowedCacheSize)
+namespace
 {
+
+/**
+ * @brief Describe a match by the names of its nodes.
+ */
+std::string describeMatch(const DB& db, const std::vector<Match>& m)
+{
+  std::stringstream matchDesc;
+  for(size_t i = 0; i < m.size(); i++)
+  {
+    const Match& n = m[i];
+
+
+    if(db.getNodeTypeRef(n.node) == "node")
+    {
+      if(n.anno.ns != 0 && n.anno.name != 0
+         && n.anno.ns != db.getNamespaceStringID() && n.anno.name != db.getNodeNameStringID())
+      {
+        matchDesc << db.strings.strRef(n.anno.ns)
+          << "::" << db.strings.strRef(n.anno.name)
+          << "::";
+      }
+
+      // we expect that the document path including the corpus name is included in the node name
+      matchDesc << "salt:/" << db.getNodeNameRef(n.node);
+
+      if(i < m.size()-1)
+      {
+       matchDesc << " ";
+      }
+    }
+  }
+  return matchDesc.str();
+}
+
+}
+
+struct CorpusStorageManager::FindCursor
+{
+  std::vector<std::string> corpora;
+  std::string queryAsJSON;
+
+  /** Only one page of a cursor can be fetched at the same time */
+  std::mutex mutex;
+  /** Protected by the lock for all cursors */
+  std::chrono::steady_clock::time_point lastAccess;
+
+  bool valid;
+  size_t corpusIdx;
+  /** Number of matches of the current corpus which have already been returned */
+  long long positionInCorpus;
+
+  /** The state of the query in the current corpus and the state of the database it refers to */
+  std::shared_ptr<Query> query;
+  std::shared_ptr<DBLoader> loader;
+  std::uint64_t changeID;
+  std::uint64_t loadGeneration;
+};
+
+CorpusStorageManager::CorpusStorageManager(std::string databaseDir, size_t maxAllowedCacheSize,
+                                           size_t maxOpenCursors, size_t cursorTimeout, size_t numOfLoadingThreads)
+  : databaseDir(databaseDir), maxAllowedCacheSize(maxAllowedCacheSize),
+    queryThreadPool(std::make_shared<ThreadPool>(std::max(1u, std::thread::hardware_concurrency()))),
+    numOfLoadingThreads(numOfLoadingThreads),
+    corporaMemorySize(0),
+    resultCache(std::make_shared<ResultCache>([this]() -> size_t
+    {
+      const size_t corporaSize = corporaMemorySize;
+      return corporaSize < this->maxAllowedCacheSize ? this->maxAllowedCacheSize - corporaSize : 0;
+    })),
+    maxOpenCursors(maxOpenCursors), cursorTimeout(cursorTimeout), lastCursorID(0)
+{
+  queryConfig.planCache = std::make_shared<PlanCache>();
 }
 
 CorpusStorageManager::~CorpusStorageManager() {}
 
 long long CorpusStorageManager::count(std::vector<std::string> corpora, std::string queryAsJSON)
 {
-  long long result = 0;
-
   // sort corpora by their name
   std::sort(corpora.begin(), corpora.end());
 
+  std::vector<std::future<long long>> corpusCounts;
   for(const std::string& c : corpora)
   {
-    std::shared_ptr<DBLoader> loader = getCorpusFromCache(c);
-
-    if(loader)
+    corpusCounts.push_back(queryThreadPool->enqueue([this, &c, &queryAsJSON]() -> long long
     {
-      boost::upgrade_lock<DBLoader> lock(*loader);
+      return countInCorpus(c, queryAsJSON);
+    }));
+  }
+  waitForAll(corpusCounts);
 
-      std::shared_ptr<annis::Query> q = annis::JSONQueryParser::parseWithUpgradeableLock(loader->get(), queryAsJSON, lock);
-      while(q->next())
-      {
-        result++;
-      }
-    }
+  long long result = 0;
+  for(auto& f : corpusCounts)
+  {
+    result += f.get();
   }
   return result;
 }
@@ -99,107 +174,379 @@ CorpusStorageManager::CountResult CorpusStorageManager::countExtra(std::vector<s
 {
   CountResult result = {0,0};
 
+  // sort corpora by their name
+  std::sort(corpora.begin(), corpora.end());
+
+  // each corpus collects its own documents, they are merged when all corpora are finished
+  std::vector<std::unordered_set<std::string>> corpusDocuments(corpora.size());
+  std::vector<std::future<long long>> corpusCounts;
+  for(size_t i=0; i < corpora.size(); i++)
+  {
+    corpusCounts.push_back(queryThreadPool->enqueue([this, i, &corpora, &queryAsJSON, &corpusDocuments]() -> long long
+    {
+      return countExtraInCorpus(corpora[i], queryAsJSON, corpusDocuments[i]);
+    }));
+  }
+  waitForAll(corpusCounts);
+
   std::unordered_set<std::string> documents;
+  for(size_t i=0; i < corpora.size(); i++)
+  {
+    result.matchCount += corpusCounts[i].get();
+    documents.insert(corpusDocuments[i].begin(), corpusDocuments[i].end());
+  }
+
+  result.documentCount = documents.size();
+  return result;
+}
 
+std::vector<std::string> CorpusStorageManager::find(std::vector<std::string> corpora, std::string queryAsJSON, long long offset, long long limit)
+{
   // sort corpora by their name
   std::sort(corpora.begin(), corpora.end());
 
-  for(const std::string& c : corpora)
+  // the range of the results for each corpus which are part of the requested page
+  std::vector<std::pair<long long, long long>> corpusRanges(corpora.size(), {0, limit});
+  if(offset > 0)
+  {
+    // Count the matches of all corpora in parallel to find the corpus where the offset is located.
+    // A corpus can never contribute more than offset+limit matches, thus counting can be stopped there.
+    const long long maxNeeded = limit > 0 ? offset + limit : 0;
+    std::vector<std::future<long long>> corpusCounts;
+    for(const std::string& c : corpora)
+    {
+      corpusCounts.push_back(queryThreadPool->enqueue([this, &c, &queryAsJSON, maxNeeded]() -> long long
+      {
+        return countInCorpus(c, queryAsJSON, maxNeeded);
+      }));
+    }
+    waitForAll(corpusCounts);
+
+    long long counter = 0;
+    for(size_t i=0; i < corpora.size(); i++)
+    {
+      const long long corpusCount = corpusCounts[i].get();
+      const long long begin = std::max(offset, counter);
+      const long long end = limit > 0 ? std::min(offset + limit, counter + corpusCount) : counter + corpusCount;
+      if(begin < end)
+      {
+        corpusRanges[i] = {begin - counter, end - begin};
+      }
+      else
+      {
+        // no results needed from this corpus
+        corpusRanges[i] = {0, -1};
+      }
+      counter += corpusCount;
+    }
+  }
+
+  std::vector<std::future<std::vector<std::string>>> corpusMatches;
+  for(size_t i=0; i < corpora.size(); i++)
   {
-    std::shared_ptr<DBLoader> loader = getCorpusFromCache(c);
+    if(corpusRanges[i].second >= 0)
+    {
+      corpusMatches.push_back(queryThreadPool->enqueue([this, i, &corpora, &queryAsJSON, &corpusRanges]()
+      {
+        return findInCorpus(corpora[i], queryAsJSON, corpusRanges[i].first, corpusRanges[i].second);
+      }));
+    }
+  }
+  waitForAll(corpusMatches);
 
-    if(loader)
+  // append the results in the order of the corpora
+  std::vector<std::string> result;
+  for(auto& f : corpusMatches)
+  {
+    std::vector<std::string> matches = f.get();
+    for(std::string& m : matches)
     {
-      boost::upgrade_lock<DBLoader> lock(*loader);
-      std::shared_ptr<annis::Query> q = annis::JSONQueryParser::parseWithUpgradeableLock(loader->get(), queryAsJSON, lock);
+      if(limit > 0 && result.size() >= static_cast<size_t>(limit))
+      {
+        return result;
+      }
+      result.push_back(std::move(m));
+    }
+  }
 
-      const DB& db = loader->get();
+  return result;
+}
+
+long long CorpusStorageManager::countInCorpus(const std::string& corpus, const std::string& queryAsJSON, long long limit)
+{
+  long long result = 0;
+
+  std::shared_ptr<DBLoader> loader = getCorpusFromCache(corpus);
+
+  if(loader)
+  {
+    boost::upgrade_lock<DBLoader> lock(*loader);
+
+    DB& db = loader->get();
+    const ResultCacheKey key = {corpus, db.getCurrentChangeID(), ResultCache::canonicalQuery(queryAsJSON)};
 
-      while(q->next())
+    boost::optional<long long> cachedCount = resultCache->getCount(key);
+    if(cachedCount)
+    {
+      return limit <= 0 ? *cachedCount : std::min(*cachedCount, limit);
+    }
+    std::vector<std::vector<Match>> cachedMatches;
+    if(limit > 0 && resultCache->getMatches(key, 0, limit, cachedMatches))
+    {
+      return static_cast<long long>(cachedMatches.size());
+    }
+
+    std::shared_ptr<annis::Query> q = annis::JSONQueryParser::parseWithUpgradeableLock(db, queryAsJSON, lock, queryConfig);
+    if(limit <= 0)
+    {
+      result = static_cast<long long>(q->count());
+      resultCache->putCount(key, result);
+    }
+    else
+    {
+      while(result < limit && q->next())
+      {
+        result++;
+      }
+      if(result < limit)
       {
-        result.matchCount++;
-        const std::vector<Match>& m = q->getCurrent();
-        if(!m.empty())
+        // the query was exhausted before reaching the limit, so this is the complete count
+        resultCache->putCount(key, result);
+      }
+    }
+  }
+  return result;
+}
+
+long long CorpusStorageManager::countExtraInCorpus(const std::string& corpus, const std::string& queryAsJSON,
+                                                   std::unordered_set<std::string>& documents)
+{
+  long long result = 0;
+
+  std::shared_ptr<DBLoader> loader = getCorpusFromCache(corpus);
+
+  if(loader)
+  {
+    boost::upgrade_lock<DBLoader> lock(*loader);
+    std::shared_ptr<annis::Query> q = annis::JSONQueryParser::parseWithUpgradeableLock(loader->get(), queryAsJSON, lock, queryConfig);
+
+    const DB& db = loader->get();
+
+    while(q->next())
+    {
+      result++;
+      const std::vector<Match>& m = q->getCurrent();
+      if(!m.empty())
+      {
+        const Match& n  = m[0];
+        boost::optional<Annotation> anno = db.nodeAnnos.getAnnotations(db.strings, n.node, annis_ns, annis_node_name);
+        if(anno)
         {
-          const Match& n  = m[0];
-          boost::optional<Annotation> anno = db.nodeAnnos.getAnnotations(db.strings, n.node, annis_ns, annis_node_name);
-          if(anno)
-          {
-            // extract the document path from the node name
-            const std::string& value = db.strings.str(anno->val);
-            std::string docPath = value.substr(0, value.size()-value.find_first_of('#'));
-            documents.insert(docPath);
-          }
+          // extract the document path from the node name
+          boost::string_ref value = db.strings.strRef(anno->val);
+          documents.insert(value.substr(0, value.size()-value.find_first_of('#')).to_string());
         }
       }
     }
   }
-
-  result.documentCount = documents.size();
   return result;
 }
 
-std::vector<std::string> CorpusStorageManager::find(std::vector<std::string> corpora, std::string queryAsJSON, long long offset, long long limit)
+std::vector<std::string> CorpusStorageManager::findInCorpus(const std::string& corpus, const std::string& queryAsJSON,
+                                                            long long offset, long long limit)
 {
   std::vector<std::string> result;
 
-  long long counter = 0;
+  std::shared_ptr<DBLoader> loader = getCorpusFromCache(corpus);
 
-  // sort corpora by their name
+  if(loader)
+  {
+    boost::upgrade_lock<DBLoader> lock(*loader);
+
+    DB& db = loader->get();
+    const ResultCacheKey key = {corpus, db.getCurrentChangeID(), ResultCache::canonicalQuery(queryAsJSON)};
+
+    std::vector<std::vector<Match>> matches;
+    if(!resultCache->getMatches(key, offset, limit, matches))
+    {
+      std::shared_ptr<annis::Query> q = annis::JSONQueryParser::parseWithUpgradeableLock(db, queryAsJSON, lock, queryConfig);
+
+      // Remember the matched nodes of all matches up to the requested page so that the following pages can be
+      // answered from the cache. Only the requested page is described.
+      bool complete = false;
+      while(limit <= 0 || static_cast<long long>(matches.size()) < (offset + limit))
+      {
+        if(!q->next())
+        {
+          complete = true;
+          break;
+        }
+        matches.push_back(q->getCurrent());
+      }
+
+      resultCache->putMatches(key, matches, complete);
+      matches.erase(matches.begin(), matches.begin() + std::min<long long>(offset, matches.size()));
+    }
+
+    result.reserve(matches.size());
+    for(const std::vector<Match>& m : matches)
+    {
+      result.push_back(describeMatch(db, m));
+    }
+  }
+
+  return result;
+}
+
+long long CorpusStorageManager::openFindCursor(std::vector<std::string> corpora, std::string queryAsJSON)
+{
+  std::shared_ptr<FindCursor> cursor = std::make_shared<FindCursor>();
+  // use the same order as find()
   std::sort(corpora.begin(), corpora.end());
+  cursor->corpora = corpora;
+  cursor->queryAsJSON = queryAsJSON;
+  cursor->valid = true;
+  cursor->corpusIdx = 0;
+  cursor->positionInCorpus = 0;
+  cursor->changeID = 0;
+  cursor->loadGeneration = 0;
+
+  std::lock_guard<std::mutex> lock(mutex_cursors);
+  // make room for the new cursor
+  removeUnusedCursors(maxOpenCursors > 0 ? maxOpenCursors - 1 : 0);
+
+  cursor->lastAccess = std::chrono::steady_clock::now();
+  const long long cursorID = ++lastCursorID;
+  cursors[cursorID] = cursor;
+  return cursorID;
+}
 
-  for(const std::string& c : corpora)
+CorpusStorageManager::CursorPage CorpusStorageManager::findNext(long long cursorID, long long limit)
+{
+  CursorPage result;
+  result.valid = false;
+
+  std::shared_ptr<FindCursor> cursor = getCursor(cursorID);
+  if(!cursor)
   {
-    std::shared_ptr<DBLoader> loader = getCorpusFromCache(c);
+    return result;
+  }
 
+  std::lock_guard<std::mutex> cursorLock(cursor->mutex);
+  if(!cursor->valid)
+  {
+    return result;
+  }
+  result.valid = true;
+
+  while((limit <= 0 || static_cast<long long>(result.matches.size()) < limit)
+        && cursor->corpusIdx < cursor->corpora.size())
+  {
+    std::shared_ptr<DBLoader> loader = getCorpusFromCache(cursor->corpora[cursor->corpusIdx]);
     if(loader)
     {
       boost::upgrade_lock<DBLoader> lock(*loader);
-
-      std::shared_ptr<annis::Query> q = annis::JSONQueryParser::parseWithUpgradeableLock(loader->get(), queryAsJSON, lock);
-
       const DB& db = loader->get();
 
-      while((limit <= 0 || counter < (offset + limit)) && q->next())
+      if(cursor->loader && (cursor->loader != loader || cursor->changeID != db.getCurrentChangeID()))
+      {
+        // the results of this corpus have changed, the already returned pages are not consistent with the new ones
+        cursor->valid = false;
+        cursor->query.reset();
+        cursor->loader.reset();
+        result.valid = false;
+        result.matches.clear();
+        return result;
+      }
+
+      if(!cursor->query || cursor->loadGeneration != loader->getLoadGeneration())
       {
-        if(counter >= offset)
+        // The query is executed for the first time or the corpus was unloaded in the meantime and
+        // the query refers to the old data structures. Since the data is the same just skip the matches
+        // which were already returned.
+        cursor->query = annis::JSONQueryParser::parseWithUpgradeableLock(loader->get(), cursor->queryAsJSON, lock, queryConfig);
+        cursor->loader = loader;
+        cursor->changeID = db.getCurrentChangeID();
+        cursor->loadGeneration = loader->getLoadGeneration();
+        long long skipped = 0;
+        while(skipped < cursor->positionInCorpus && cursor->query->next())
         {
-          const std::vector<Match>& m = q->getCurrent();
-          std::stringstream matchDesc;
-          for(size_t i = 0; i < m.size(); i++)
-          {
-            const Match& n = m[i];
+          skipped++;
+        }
+      }
 
+      while((limit <= 0 || static_cast<long long>(result.matches.size()) < limit) && cursor->query->next())
+      {
+        result.matches.push_back(describeMatch(db, cursor->query->getCurrent()));
+        cursor->positionInCorpus++;
+      }
 
-            if(db.getNodeType(n.node) == "node")
-            {
-              if(n.anno.ns != 0 && n.anno.name != 0
-                 && n.anno.ns != db.getNamespaceStringID() && n.anno.name != db.getNodeNameStringID())
-              {
-                matchDesc << db.strings.str(n.anno.ns)
-                  << "::" << db.strings.str(n.anno.name)
-                  << "::";
-              }
-
-              // we expect that the document path including the corpus name is included in the node name
-              matchDesc << "salt:/" << db.getNodeName(n.node);
-
-              if(i < m.size()-1)
-              {
-               matchDesc << " ";
-              }
-            }
-          }
-          result.push_back(matchDesc.str());
-        } // end if result in offset-limit range
-        counter++;
+      if(limit > 0 && static_cast<long long>(result.matches.size()) >= limit)
+      {
+        // there might be more matches in this corpus, keep the query for the next page
+        break;
       }
     }
+
+    // continue with the next corpus
+    cursor->corpusIdx++;
+    cursor->positionInCorpus = 0;
+    cursor->query.reset();
+    cursor->loader.reset();
   }
 
   return result;
 }
 
+void CorpusStorageManager::closeFindCursor(long long cursorID)
+{
+  std::lock_guard<std::mutex> lock(mutex_cursors);
+  cursors.erase(cursorID);
+}
+
+std::shared_ptr<CorpusStorageManager::FindCursor> CorpusStorageManager::getCursor(long long cursorID)
+{
+  std::lock_guard<std::mutex> lock(mutex_cursors);
+  removeUnusedCursors(maxOpenCursors);
+
+  auto it = cursors.find(cursorID);
+  if(it == cursors.end())
+  {
+    return std::shared_ptr<FindCursor>();
+  }
+  it->second->lastAccess = std::chrono::steady_clock::now();
+  return it->second;
+}
+
+void CorpusStorageManager::removeUnusedCursors(size_t maxNumOfCursors)
+{
+  const auto now = std::chrono::steady_clock::now();
+  for(auto it = cursors.begin(); it != cursors.end();)
+  {
+    if(now - it->second->lastAccess > cursorTimeout)
+    {
+      it = cursors.erase(it);
+    }
+    else
+    {
+      it++;
+    }
+  }
+
+  while(cursors.size() > maxNumOfCursors)
+  {
+    auto leastRecentlyUsed = cursors.begin();
+    for(auto it = cursors.begin(); it != cursors.end(); it++)
+    {
+      if(it->second->lastAccess < leastRecentlyUsed->second->lastAccess)
+      {
+        leastRecentlyUsed = it;
+      }
+    }
+    cursors.erase(leastRecentlyUsed);
+  }
+}
+
 void CorpusStorageManager::applyUpdate(std::string corpus, GraphUpdate &update)
 {
 
@@ -220,6 +567,9 @@ void CorpusStorageManager::applyUpdate(std::string corpus, GraphUpdate &update)
    {
       boost::lock_guard<DBLoader> lock(*loader);
 
+      // the change ID is not increased when the update fails and the corpus is loaded again
+      resultCache->invalidate(corpus);
+
       DB& db = loader->getFullyLoaded();
       try {
 
@@ -423,6 +773,7 @@ void CorpusStorageManager::importCorpus(std::string pathToCorpus, std::string ne
    if(loader)
    {
       boost::lock_guard<DBLoader> lock(*loader);
+      resultCache->invalidate(newCorpusName);
       DB& db = loader->get();
       // load the corpus data from the external location
       db.load(pathToCorpus);
@@ -448,6 +799,7 @@ void CorpusStorageManager::importRelANNIS(std::string pathToCorpus, std::string
   if(loader)
   {
     boost::unique_lock<DBLoader> lock(*loader);
+    resultCache->invalidate(newCorpusName);
 
     DB& db = loader->get();
 
@@ -489,6 +841,8 @@ bool CorpusStorageManager::deleteCorpus(std::string corpusName)
     }
 
 
+    resultCache->invalidate(corpusName);
+
     // delete the corpus from the cache and thus from memory
     std::lock_guard<std::mutex> lockCorpusCache(mutex_corpusCache);
     corpusCache.erase(corpusName);
@@ -605,6 +959,7 @@ std::shared_ptr<DBLoader> CorpusStorageManager::getCorpusFromCache(std::string c
         // callback can be executed at one time), there will always be another garbage collection run which will
         // ensure that the overall size limits are not exceeded in the end.
         size_t overallSize = 0;
+        size_t loadedCorpusSize = 0;
         std::vector<SizeListEntry> corpusSizes;
         for(const auto& entry : corpusCache)
         {
@@ -624,10 +979,17 @@ std::shared_ptr<DBLoader> CorpusStorageManager::getCorpusFromCache(std::string c
           }
           else
           {
-            HL_DEBUG(logger, "Can't lock \"" + entry.first + "\" for garbage collection since it is already locked by another thread.");
+            // the corpus which was just loaded is still locked by the calling thread
+            loadedCorpusSize = entry.second->estimateMemorySize();
           }
         }
 
+        // The query results share the memory limit with the corpora. They are cheaper to re-calculate than
+        // loading a corpus, so they only get the part of the limit which is not used by the corpora.
+        corporaMemorySize = overallSize + loadedCorpusSize;
+        resultCache->shrink();
+        overallSize += resultCache->estimateMemorySize();
+
         if(overallSize <= maxAllowedCacheSize)
         {
           // there is nothing to do
@@ -650,11 +1012,12 @@ std::shared_ptr<DBLoader> CorpusStorageManager::getCorpusFromCache(std::string c
             boost::lock_guard<DBLoader> lock(*(largestCorpus.first), boost::adopt_lock);
             largestCorpus.first->unload();
             overallSize -= largestCorpus.second;
+            corporaMemorySize -= largestCorpus.second;
           }
           corpusSizes.pop_back();
         }
 
-      });
+      }, numOfLoadingThreads, queryThreadPool);
     corpusCache[corpusName] =  result;
   }
   else
@@ -18,16 +18,23 @@
 
 #include <annis/api/graphupdate.h>
 #include <annis/api/graph.h>
+#include <annis/queryconfig.h>             // for QueryConfig
 
 #include <stddef.h>                        // for size_t
+#include <atomic>                          // for atomic
+#include <chrono>                          // for seconds
+#include <future>                          // for future
 #include <map>                             // for map
 #include <memory>                          // for shared_ptr
 #include <mutex>                           // for mutex
 #include <string>                          // for string
+#include <unordered_set>                   // for unordered_set
 #include <vector>                          // for vector
 
 
 namespace annis { class DBLoader; }
+namespace annis { class ResultCache; }
+namespace annis { class ThreadPool; }
 namespace annis { class DB; }
 namespace annis { struct Component; }
 namespace annis { namespace api { class GraphUpdate; } }
@@ -41,6 +48,8 @@ namespace api
 {
 /**
  * An API for managing corpora stored in a common location on the file system.
+ *
+ * Queries on several corpora are executed in parallel, each corpus is locked independently.
  */
 class CorpusStorageManager
 {
@@ -58,7 +67,23 @@ public:
     long long memoryUsageInBytes;
   };
 
-  CorpusStorageManager(std::string databaseDir, size_t maxAllowedCacheSize = 1073741824);
+  struct CursorPage
+  {
+    std::vector<std::string> matches;
+    /** False if the cursor is unknown (closed or expired) or a corpus was changed since the last page */
+    bool valid;
+  };
+
+  /**
+   * @param databaseDir
+   * @param maxAllowedCacheSize Maximal size in bytes of all loaded corpora and cached query results.
+   * @param maxOpenCursors Number of cursors which are kept open, the least recently used ones are closed first.
+   * @param cursorTimeout Number of seconds after which an unused cursor is closed.
+   * @param numOfLoadingThreads Maximal number of components of a corpus which are loaded in parallel by the workers
+   *        of the query thread pool, 0 uses the number of CPU cores.
+   */
+  CorpusStorageManager(std::string databaseDir, size_t maxAllowedCacheSize = 1073741824,
+                       size_t maxOpenCursors = 100, size_t cursorTimeout = 600, size_t numOfLoadingThreads = 0);
    ~CorpusStorageManager();
 
   /**
@@ -94,6 +119,30 @@ public:
   std::vector<std::string> find(std::vector< std::string > corpora, std::string queryAsJSON, long long offset=0,
                                 long long limit=0);
 
+  /**
+   * Open a cursor for fetching the occurrences of an AQL query page by page.
+   *
+   * The cursor keeps the state of the query between the calls, so each page only needs to
+   * compute its own matches instead of skipping all matches of the previous pages like find().
+   * The matches have the same order as the ones of find().
+   * @param corpora
+   * @param queryAsJSON
+   * @return The ID of the new cursor.
+   */
+  long long openFindCursor(std::vector<std::string> corpora, std::string queryAsJSON);
+
+  /**
+   * Fetch the next matches of a cursor.
+   *
+   * If a corpus was changed (or deleted) since the last page the cursor is not valid anymore.
+   * @param cursorID
+   * @param limit Maximal number of matches to return, 0 for all remaining matches.
+   * @return
+   */
+  CursorPage findNext(long long cursorID, long long limit);
+
+  void closeFindCursor(long long cursorID);
+
   void applyUpdate(std::string corpus, GraphUpdate &update);
 
   /**
@@ -134,6 +183,31 @@ private:
   std::mutex mutex_writerThreads;
   std::map<std::string, boost::thread> writerThreads;
 
+  /** Executes the queries for the different corpora and loads their components */
+  std::shared_ptr<ThreadPool> queryThreadPool;
+  const size_t numOfLoadingThreads;
+
+  /** Estimated memory size of the loaded corpora, updated whenever a corpus is loaded or unloaded */
+  std::atomic<size_t> corporaMemorySize;
+
+  /**
+   * Counts and matches of previous queries per corpus. Its size is part of the maxAllowedCacheSize
+   * and cached results are removed before any corpus is unloaded.
+   */
+  std::shared_ptr<ResultCache> resultCache;
+
+  /** Configuration of all queries, the plans of the queries are shared between all calls */
+  QueryConfig queryConfig;
+
+  struct FindCursor;
+
+  const size_t maxOpenCursors;
+  const std::chrono::seconds cursorTimeout;
+
+  std::mutex mutex_cursors;
+  long long lastCursorID;
+  std::map<long long, std::shared_ptr<FindCursor>> cursors;
+
 private:
 
 
@@ -152,6 +226,42 @@ private:
 
   std::shared_ptr<DBLoader> getCorpusFromCache(std::string name);
 
+  /**
+   * @brief Count the matches in a single corpus.
+   * @param limit Stop counting when this number of matches is reached, 0 for no limit.
+   */
+  long long countInCorpus(const std::string& corpus, const std::string& queryAsJSON, long long limit = 0);
+  long long countExtraInCorpus(const std::string& corpus, const std::string& queryAsJSON,
+                               std::unordered_set<std::string>& documents);
+  std::vector<std::string> findInCorpus(const std::string& corpus, const std::string& queryAsJSON,
+                                        long long offset, long long limit);
+
+  /**
+   * @brief Get an open cursor and mark it as used.
+   * @return An empty pointer if there is no such cursor.
+   */
+  std::shared_ptr<FindCursor> getCursor(long long cursorID);
+
+  /**
+   * @brief Close all expired cursors and the least recently used ones if there are too many.
+   * The caller must hold the lock for the cursors.
+   */
+  void removeUnusedCursors(size_t maxNumOfCursors);
+
+  /**
+   * @brief Wait until all tasks are finished, even if some of them failed.
+   *
+   * The tasks reference local variables of the caller, thus they must not outlive it when an exception is thrown.
+   */
+  template<typename T>
+  static void waitForAll(std::vector<std::future<T>>& futures)
+  {
+    for(auto& f : futures)
+    {
+      f.wait();
+    }
+  }
+
   Node createSubgraphNode(std::uint32_t nodeID, DB &db, const std::vector<annis::Component>& allComponents);
 
 };
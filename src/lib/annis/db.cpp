@@ -21,6 +21,9 @@
 #include <annis/graphstorage/graphstorage.h>            // for WriteableGrap...
 #include <annis/graphstorageregistry.h>                 // for GraphStorageR...
 #include <annis/util/helper.h>                          // for Helper
+#include <annis/util/mappedfile.h>                      // for MappedFile
+#include <annis/util/threadpool.h>                      // for ThreadPool
+#include <annis/util/tokenindex.h>                      // for TokenIndex
 #include <google/btree.h>                               // for btree_iterator
 #include <google/btree_container.h>                     // for btree_unique_...
 #include <google/btree_map.h>                           // for btree_map
@@ -33,6 +36,12 @@
 #include <boost/thread/thread.hpp>                      // for interruption_...
 #include <cereal/archives/binary.hpp>                   // for BinaryInputAr...
 #include <cereal/cereal.hpp>                            // for InputArchive
+#include <algorithm>                                    // for min, max
+#include <atomic>                                       // for atomic
+#include <chrono>                                       // for steady_clock
+#include <condition_variable>                           // for condition_variable
+#include <mutex>                                        // for mutex, lock_guard
+#include <thread>                                       // for thread
 #include <iostream>                                     // for ifstream, ope...
 #include <limits>                                       // for numeric_limits
 #include <list>                                         // for list
@@ -49,9 +58,11 @@ using namespace annis;
 using namespace std;
 
 DB::DB()
-: currentChangeID(0),
+: currentChangeID(0), loadGeneration(0),
   f_getGraphStorage([this](ComponentType type, const std::string &layer, const std::string &name) {return this->getGraphStorage(type, layer, name);}),
-  f_getAllGraphStorages([this](ComponentType type, const std::string &name) {return this->getAllGraphStorages(type, name);})
+  f_getAllGraphStorages([this](ComponentType type, const std::string &name) {return this->getAllGraphStorages(type, name);}),
+  numOfLoadingThreads(std::max(1u, std::thread::hardware_concurrency())),
+  tokenIndexEnabled(true)
 {
   addDefaultStrings();
 }
@@ -72,12 +83,46 @@ bool DB::load(string dir, bool preloadComponents)
     backupWasLoaded = true;
   }
 
+  // the strings are used in place if they have been saved in the memory mapped format
+  bool stringsLoaded = strings.loadMapped((dir2load / "strings.annis").string());
+  std::ifstream stringsStream((dir2load / "strings.cereal").string(), std::ios::binary);
+  if(!stringsLoaded && stringsStream.is_open())
+  {
+    cereal::BinaryInputArchive stringsArchive(stringsStream);
+    stringsArchive(strings);
+    stringsLoaded = true;
+  }
+
+  std::ifstream annosStream((dir2load / "node_annos.cereal").string(), std::ios::binary);
   std::ifstream is((dir2load / "nodes.cereal").string(), std::ios::binary);
-  if(is.is_open())
+  if(stringsLoaded)
+  {
+    if(annosStream.is_open())
+    {
+      cereal::BinaryInputArchive archive(annosStream);
+      archive(nodeAnnos);
+    }
+    else if(is.is_open())
+    {
+      // node annotations without posting lists
+      cereal::BinaryInputArchive archive(is);
+      nodeAnnos.loadWithInverseFormat<bc::flat_multimap<Annotation, nodeid_t>>(archive);
+    }
+    std::ifstream columnsStream((dir2load / "node_columns.cereal").string(), std::ios::binary);
+    if(columnsStream.is_open())
+    {
+      cereal::BinaryInputArchive columnsArchive(columnsStream);
+      nodeAnnos.serializeColumns(columnsArchive);
+    }
+  }
+  else if(is.is_open())
   {
+    // older corpora store the strings together with the node annotations
     cereal::BinaryInputArchive archive(is);
-    archive(strings, nodeAnnos);
+    strings.loadLegacy(archive);
+    nodeAnnos.loadWithInverseFormat<bc::flat_multimap<Annotation, nodeid_t>>(archive);
   }
+  nodeAnnos.optimizeColumns();
 
   bool logfileExists = false;
   // check if we have to apply a log file to get to the last stable snapshot version
@@ -135,9 +180,24 @@ bool DB::save(string dir)
 
   boost::this_thread::interruption_point();
 
-  std::ofstream os((dirPath / "nodes.cereal").string(), std::ios::binary);
-  cereal::BinaryOutputArchive archive( os );
-  archive(strings, nodeAnnos);
+  if(!strings.saveMapped((dirPath / "strings.annis").string()))
+  {
+    // keep the strings in the older format, they are the only ones left
+    HL_ERROR(logger, (boost::format("could not save the strings to %1%") % dirPath.string()).str());
+    return false;
+  }
+
+  {
+    std::ofstream os((dirPath / "node_annos.cereal").string(), std::ios::binary);
+    cereal::BinaryOutputArchive archive( os );
+    archive(nodeAnnos);
+  }
+
+  {
+    std::ofstream os((dirPath / "node_columns.cereal").string(), std::ios::binary);
+    cereal::BinaryOutputArchive archive( os );
+    nodeAnnos.serializeColumns(archive);
+  }
 
   boost::this_thread::interruption_point();
 
@@ -161,6 +221,12 @@ bool DB::save(string dir)
     {
       boost::filesystem::remove(fileIt->path());
     }
+    else if(fileIt->path().filename() == "nodes.cereal" || fileIt->path().filename() == "strings.cereal")
+    {
+      // node annotations are saved to node_annos.cereal and the strings to strings.annis now,
+      // remove the files in the older format
+      boost::filesystem::remove(fileIt->path());
+    }
   }
 
   // TODO: return false on failure
@@ -175,12 +241,23 @@ std::string DB::getNodeDebugName(const nodeid_t &id) const
   return ss.str();
 }
 
+size_t DB::estimateTokenIndexMemorySize() const
+{
+  std::lock_guard<std::mutex> lock(mutex_tokenIndex);
+  return tokenIndex ? tokenIndex->estimateMemorySize() : 0;
+}
+
 void DB::clear()
 {
+  loadGeneration++;
   strings.clear();
   nodeAnnos.clear();
   graphStorages.clear();
   notLoadedLocations.clear();
+  {
+    std::lock_guard<std::mutex> lock(mutex_tokenIndex);
+    tokenIndex.reset();
+  }
 
   addDefaultStrings();
 }
@@ -221,30 +298,12 @@ void DB::loadGraphStorages(string dirPath, bool preloadComponents)
           Component emptyNameComponent = {(ComponentType) componentType,
               layerPath.filename().string(), ""};
 
-          std::shared_ptr<ReadableGraphStorage> gsEmptyName;
-
-          auto inputFile = layerPath / "component.cereal";
-
           // only load the graph storage with the empty name if there is data for it
-          if(boost::filesystem::is_regular_file(inputFile))
+          if(hasGraphStorageFile(layerPath.string()))
           {
-            if(preloadComponents)
-            {
-              HL_DEBUG(logger, (boost::format("loading component %1%")
-                               % debugComponentString(emptyNameComponent)).str());
-              std::ifstream is(inputFile.string(), std::ios::binary);
-              if(is.is_open())
-              {
-                cereal::BinaryInputArchive ar(is);
-                ar(gsEmptyName);
-              }
-            }
-            else
-            {
-              notLoadedLocations.insert({emptyNameComponent, layerPath.string()});
-            }
-            graphStorages[emptyNameComponent] = gsEmptyName;
-          } // end if component.cereal exists
+            notLoadedLocations.insert({emptyNameComponent, layerPath.string()});
+            graphStorages[emptyNameComponent] = std::shared_ptr<ReadableGraphStorage>();
+          } // end if component file exists
         }
 
         // also load all named components
@@ -260,28 +319,11 @@ void DB::loadGraphStorages(string dirPath, bool preloadComponents)
                                                            namedComponentPath.filename().string()
                                        };
 
-            auto inputFile = namedComponentPath / "component.cereal";
-
-            if(boost::filesystem::is_regular_file(inputFile))
+            if(hasGraphStorageFile(namedComponentPath.string()))
             {
-              std::shared_ptr<ReadableGraphStorage> gsNamed;
-              if(preloadComponents)
-              {
-                HL_DEBUG(logger, (boost::format("loading component %1%")
-                                 % debugComponentString(namedComponent)).str());
-                std::ifstream is(inputFile.string(), std::ios::binary);
-                if(is.is_open())
-                {
-                  cereal::BinaryInputArchive ar(is);
-                  ar(gsNamed);
-                }
-              }
-              else
-              {
-                notLoadedLocations.insert({namedComponent, namedComponentPath.string()});
-              }
-              graphStorages[namedComponent] = gsNamed;
-            } // end if components.cereal exists
+              notLoadedLocations.insert({namedComponent, namedComponentPath.string()});
+              graphStorages[namedComponent] = std::shared_ptr<ReadableGraphStorage>();
+            } // end if component file exists
           }
           itNamedComponents++;
         } // end for each file/directory in layer directory
@@ -289,6 +331,94 @@ void DB::loadGraphStorages(string dirPath, bool preloadComponents)
       } // for each layers
     }
   } // end for each component
+
+  if(preloadComponents)
+  {
+    loadComponents(notLoadedLocations);
+  }
+}
+
+void DB::loadComponents(const std::map<Component, string> &locations)
+{
+  if(locations.empty())
+  {
+    return;
+  }
+
+  const std::vector<std::pair<Component, std::string>> toLoad(locations.begin(), locations.end());
+  std::vector<std::shared_ptr<ReadableGraphStorage>> loaded(toLoad.size());
+
+  auto startTime = std::chrono::steady_clock::now();
+
+  const size_t numOfThreads = std::min(numOfLoadingThreads, toLoad.size());
+  // the components are independent of each other, only the registration in the maps has to be done sequentially
+  std::atomic<size_t> nextToLoad(0);
+  auto loadRemaining = [this, &toLoad, &loaded, &nextToLoad]()
+  {
+    for(size_t i = nextToLoad++; i < toLoad.size(); i = nextToLoad++)
+    {
+      loaded[i] = loadGraphStorage(toLoad[i].first, toLoad[i].second);
+    }
+  };
+
+  if(numOfThreads > 1)
+  {
+    // The caller holds the lock of the DBLoader, so it must not execute other tasks of a shared pool while waiting:
+    // a query on the same corpus would block on this lock forever. Instead, the calling thread loads components
+    // itself and only waits for the helpers which already started. Helpers which start later do nothing.
+    struct HelperState
+    {
+      std::mutex mutex;
+      std::condition_variable finished;
+      bool closed = false;
+      size_t running = 0;
+    };
+    std::shared_ptr<HelperState> state = std::make_shared<HelperState>();
+
+    std::shared_ptr<ThreadPool> pool = loadingThreadPool ? loadingThreadPool : std::make_shared<ThreadPool>(numOfThreads - 1);
+    for(size_t t=1; t < numOfThreads; t++)
+    {
+      pool->enqueue([state, &loadRemaining]()
+      {
+        {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          if(state->closed)
+          {
+            return;
+          }
+          state->running++;
+        }
+        loadRemaining();
+        {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->running--;
+        }
+        state->finished.notify_all();
+      });
+    }
+    loadRemaining();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->finished.wait(lock, [&state]() {return state->running == 0;});
+  }
+  else
+  {
+    loadRemaining();
+  }
+
+  for(size_t i=0; i < toLoad.size(); i++)
+  {
+    if(loaded[i])
+    {
+      graphStorages[toLoad[i].first] = loaded[i];
+      notLoadedLocations.erase(toLoad[i].first);
+    }
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+  HL_DEBUG(logger, (boost::format("loaded %1% components with %2% thread(s) in %3% ms")
+                   % toLoad.size() % std::max<size_t>(numOfThreads, 1) % duration.count()).str());
 }
 
 void DB::saveGraphStorages(string dirPath)
@@ -317,12 +447,58 @@ void DB::saveGraphStorages(string dirPath)
       finalPath = gsParent / ComponentTypeHelper::toString(c.type) / c.layer / c.name;
     }
     boost::filesystem::create_directories(finalPath);
-    auto outputFile = finalPath / "component.cereal";
-    std::ofstream os(outputFile.string(), std::ios::binary);
-    cereal::BinaryOutputArchive ar(os);
-    ar(it->second);
-    os.close();
+
+    // use the memory mapped format if the implementation supports it
+    MappedFileWriter writer;
+    writer.addSection("impl", gsRegistry.getName(it->second));
+    if(!it->second || !it->second->saveMapped(writer) || !writer.write((finalPath / "component.annis").string()))
+    {
+      auto outputFile = finalPath / "component.cereal";
+      std::ofstream os(outputFile.string(), std::ios::binary);
+      cereal::BinaryOutputArchive ar(os);
+      ar(it->second);
+      os.close();
+    }
+  }
+}
+
+std::shared_ptr<ReadableGraphStorage> DB::loadGraphStorage(const Component &c, const string &dir)
+{
+  auto startTime = std::chrono::steady_clock::now();
+
+  std::shared_ptr<ReadableGraphStorage> result;
+
+  std::shared_ptr<const MappedFile> file = MappedFile::open(dir + "/component.annis");
+  if(file)
+  {
+    std::shared_ptr<ReadableGraphStorage> gs = gsRegistry.createGraphStorage(file->sectionString("impl"), strings, c);
+    if(gs && gs->loadMapped(file))
+    {
+      result = gs;
+    }
+  }
+
+  if(!result)
+  {
+    std::ifstream is(dir + "/component.cereal", std::ios::binary);
+    if(is.is_open())
+    {
+      cereal::BinaryInputArchive ar(is);
+      ar(result);
+    }
   }
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+  HL_DEBUG(logger, (boost::format("loaded component %1% in %2% ms")
+                   % debugComponentString(c) % duration.count()).str());
+
+  return result;
+}
+
+bool DB::hasGraphStorageFile(const string &dir)
+{
+  return boost::filesystem::is_regular_file(dir + "/component.annis")
+      || boost::filesystem::is_regular_file(dir + "/component.cereal");
 }
 
 bool DB::ensureGraphStorageIsLoaded(const Component &c)
@@ -333,16 +509,11 @@ bool DB::ensureGraphStorageIsLoaded(const Component &c)
     auto itLocation = notLoadedLocations.find(c);
     if(itLocation != notLoadedLocations.end())
     {
-      HL_DEBUG(logger, (boost::format("loading component %1%")
-                       % debugComponentString(itLocation->first)).str());
-      std::ifstream is(itLocation->second + "/component.cereal", std::ios::binary);
-      if(is.is_open())
+      std::shared_ptr<ReadableGraphStorage> gs = loadGraphStorage(itLocation->first, itLocation->second);
+      if(gs)
       {
-        cereal::BinaryInputArchive ar(is);
-        ar(itGS->second);
+        itGS->second = gs;
         notLoadedLocations.erase(itLocation);
-
-        is.close();
         return true;
       }
     }
@@ -426,7 +597,8 @@ string DB::debugComponentString(const Component &c) const
 
 nodeid_t DB::nextFreeNodeID() const
 {
-  return nodeAnnos.annotations.empty() ? 0 : (nodeAnnos.annotations.rbegin()->first.id) + 1;
+  boost::optional<nodeid_t> maxNodeID = nodeAnnos.maxItem();
+  return maxNodeID ? *maxNodeID + 1 : 0;
 }
 
 void DB::convertComponent(Component c, std::string impl)
@@ -478,6 +650,8 @@ void DB::optimizeAll(const std::map<Component, string>& manualExceptions)
       convertComponent(c, find->second);
     }
   }
+
+  // the implementations have changed, but not the token related information
 }
 
 bool DB::allGraphStoragesLoaded() const
@@ -514,10 +688,44 @@ bool DB::allGraphStoragesLoaded(ComponentType type, const string &name)
 
 void DB::ensureAllComponentsLoaded()
 {
-  for(const auto& c : getAllComponents())
+  // copy the locations since the loaded ones are removed while iterating
+  const std::map<Component, std::string> locations = notLoadedLocations;
+  loadComponents(locations);
+}
+
+std::shared_ptr<const TokenIndex> DB::getTokenIndex(const GetGSFuncT& getGraphStorageFunc) const
+{
+  if(!tokenIndexEnabled)
   {
-    ensureGraphStorageIsLoaded(c);
+    return std::shared_ptr<const TokenIndex>();
   }
+
+  // Load the token related components before the index is locked, the function might have to wait until
+  // no other query uses the database.
+  for(ComponentType type : {ComponentType::COVERAGE, ComponentType::LEFT_TOKEN, ComponentType::RIGHT_TOKEN,
+                            ComponentType::ORDERING})
+  {
+    getGraphStorageFunc(type, annis_ns, "");
+    if(!isGraphStorageLoaded(type, annis_ns, ""))
+    {
+      return std::shared_ptr<const TokenIndex>();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_tokenIndex);
+  if(!tokenIndex)
+  {
+    // the index is only rebuilt once before it is needed, not after each change
+    tokenIndex = TokenIndex::build(*this);
+  }
+  return tokenIndex;
+}
+
+void DB::updateTokenIndex()
+{
+  std::shared_ptr<const TokenIndex> newIndex = TokenIndex::build(*this);
+  std::lock_guard<std::mutex> lock(mutex_tokenIndex);
+  tokenIndex = newIndex;
 }
 
 size_t DB::estimateMemorySize() const
@@ -525,7 +733,8 @@ size_t DB::estimateMemorySize() const
   return
       nodeAnnos.estimateMemorySize()
       + strings.estimateMemorySize()
-      + estimateGraphStorageMemorySize();
+      + estimateGraphStorageMemorySize()
+      + estimateTokenIndexMemorySize();
 }
 
 string DB::info()
@@ -549,6 +758,7 @@ std::shared_ptr<WriteableGraphStorage> DB::createWritableGraphStorage(ComponentT
       graphStorages.find(c);
   if(itDB != graphStorages.end())
   {
+    ensureGraphStorageIsLoaded(c);
     // check if the current implementation is writeable
     std::shared_ptr<WriteableGraphStorage> writable = std::dynamic_pointer_cast<WriteableGraphStorage>(itDB->second);
     if(writable)
@@ -558,6 +768,11 @@ std::shared_ptr<WriteableGraphStorage> DB::createWritableGraphStorage(ComponentT
   }
 
   std::shared_ptr<WriteableGraphStorage> gs = std::shared_ptr<WriteableGraphStorage>(new AdjacencyListStorage());
+  if(itDB != graphStorages.end())
+  {
+    // the existing read-only implementation must not lose its edges when it is replaced
+    gs->copy(*this, *itDB->second);
+  }
   // register the used implementation
   graphStorages[c] = gs;
   return gs;
@@ -651,6 +866,12 @@ vector<Annotation> DB::getEdgeAnnotations(const Component &component,
 
 void DB::update(const api::GraphUpdate& u)
 {
+   // the token index is not updated incrementally, it is rebuilt when it is needed the next time
+   {
+     std::lock_guard<std::mutex> lock(mutex_tokenIndex);
+     tokenIndex.reset();
+   }
+
    for(std::shared_ptr<api::UpdateEvent> change : u.getDiffs())
    {
       if(change->changeID <= u.getLastConsistentChangeID())
@@ -795,7 +1016,6 @@ void DB::update(const api::GraphUpdate& u)
          currentChangeID = change->changeID;
       } // end if changeID is behind last consistent
    } // end for each change in update list
-
 }
 
 DB::~DB()
@@ -20,18 +20,23 @@
 #include <annis/stringstorage.h>         // for StringStorage
 #include <annis/types.h>                 // for nodeid_t, Annotation, annis_ns
 #include <stddef.h>                      // for size_t
+#include <algorithm>                     // for max
 #include <boost/container/flat_map.hpp>  // for flat_multimap
 #include <boost/container/vector.hpp>    // for operator!=, vec_iterator
 #include <boost/optional/optional.hpp>   // for optional
+#include <boost/utility/string_ref.hpp>  // for string_ref
 #include <cstdint>                       // for uint32_t, uint64_t
 #include <map>                           // for map
 #include <memory>                        // for allocator_traits<>::value_type
+#include <mutex>                         // for mutex
 #include <string>                        // for string, operator<<, char_traits
 #include <utility>                       // for pair
 #include <vector>                        // for vector
 #include <annis/graphstorageregistry.h>
 
 namespace annis { class WriteableGraphStorage; }  // lines 43-43
+namespace annis { class TokenIndex; }
+namespace annis { class ThreadPool; }
 namespace annis { namespace api { class GraphUpdate; } }  // lines 40-40
 
 namespace annis
@@ -51,26 +56,35 @@ public:
 
   inline std::string getNodeName(const nodeid_t &id) const
   {
-    std::string result = "";
+    return getNodeNameRef(id).to_string();
+  }
+
+  std::string getNodeType(const nodeid_t &id) const
+  {
+    return getNodeTypeRef(id).to_string();
+  }
 
+  /**
+   * @brief Get the node name without copying it, the reference is only valid until the next string is added.
+   */
+  boost::string_ref getNodeNameRef(const nodeid_t &id) const
+  {
     boost::optional<Annotation> anno = nodeAnnos.getAnnotations(strings, id, annis_ns, annis_node_name);
     if(anno)
     {
-      result = strings.str(anno->val);
+      return strings.strRef(anno->val);
     }
-    return result;
+    return boost::string_ref();
   }
 
-  std::string getNodeType(const nodeid_t &id) const
+  boost::string_ref getNodeTypeRef(const nodeid_t &id) const
   {
-    std::string result = "";
-
     boost::optional<Annotation> anno = nodeAnnos.getAnnotations(strings, id, annis_ns, annis_node_type);
     if(anno)
     {
-      result = strings.str(anno->val);
+      return strings.strRef(anno->val);
     }
-    return result;
+    return boost::string_ref();
   }
 
   inline boost::optional<nodeid_t> getNodeID(const std::string& nodeName) const
@@ -105,6 +119,17 @@ public:
   inline std::uint32_t getTokStringID() const {return annisTokStringID;}
   inline std::uint32_t getNodeTypeStringID() const {return annisNodeTypeID;}
 
+  /** ID of the last update which was applied to this database */
+  inline std::uint64_t getCurrentChangeID() const {return currentChangeID;}
+
+  /**
+   * @brief Number of times the data of this database was cleared or loaded.
+   *
+   * Anything that refers to the data structures of the database (e.g. a query) is only valid
+   * as long as this number does not change.
+   */
+  inline std::uint64_t getLoadGeneration() const {return loadGeneration;}
+
   std::shared_ptr<annis::WriteableGraphStorage> createWritableGraphStorage(ComponentType type, const std::string& layer,
                        const std::string& name);
 
@@ -121,6 +146,56 @@ public:
   bool allGraphStoragesLoaded(ComponentType type, const std::string& name);
   void ensureAllComponentsLoaded();
 
+  /**
+   * @brief Get the index for the token related information.
+   *
+   * The index is built on the first call after the database was loaded or changed. It only needs the node
+   * annotations and the COVERAGE, LEFT_TOKEN, RIGHT_TOKEN and ORDERING components, which are loaded with the
+   * given function if necessary. Other components can stay unloaded.
+   * @return An empty pointer if the index is not available (e.g. since one of the components can't be loaded).
+   */
+  std::shared_ptr<const TokenIndex> getTokenIndex(const GetGSFuncT& getGraphStorageFunc) const;
+
+  std::shared_ptr<const TokenIndex> getTokenIndex() const
+  {
+    return getTokenIndex(f_getGraphStorage);
+  }
+
+  /**
+   * @brief (Re-)build the token index from the current node annotations and components.
+   */
+  void updateTokenIndex();
+
+  /**
+   * @brief If disabled, getTokenIndex() returns an empty pointer and the token related information is searched
+   * in the components.
+   */
+  void setTokenIndexEnabled(bool enabled)
+  {
+    tokenIndexEnabled = enabled;
+  }
+
+  /**
+   * @brief Set the maximal number of components which are loaded in parallel.
+   *
+   * Defaults to the number of available CPU cores, use 1 to load the components sequentially.
+   */
+  void setNumOfLoadingThreads(size_t numOfThreads)
+  {
+    numOfLoadingThreads = std::max<size_t>(numOfThreads, 1);
+  }
+
+  /**
+   * @brief Use the workers of an existing pool (e.g. the one of the queries) to load the components.
+   *
+   * Without a pool a temporary one is created for each load. The loading thread never executes other tasks of the
+   * pool and does not wait for helpers which start after it finished loading, so a busy pool only slows the loading down.
+   */
+  void setLoadingThreadPool(std::shared_ptr<ThreadPool> threadPool)
+  {
+    loadingThreadPool = threadPool;
+  }
+
   size_t estimateMemorySize() const;
 
   void update(const api::GraphUpdate& u);
@@ -133,7 +208,7 @@ public:
 public:
 
   StringStorage strings;
-  AnnoStorage<nodeid_t> nodeAnnos;
+  NodeAnnoStorage nodeAnnos;
 
   const GetGSFuncT f_getGraphStorage;
   const GetAllGSFuncT f_getAllGraphStorages;
@@ -142,6 +217,10 @@ public:
 private:
 
   std::uint64_t currentChangeID;
+  std::uint64_t loadGeneration;
+
+  size_t numOfLoadingThreads;
+  std::shared_ptr<ThreadPool> loadingThreadPool;
 
   std::uint32_t annisNamespaceStringID;
   std::uint32_t annisEmptyStringID;
@@ -159,6 +238,11 @@ private:
   std::map<Component, std::string> notLoadedLocations;
   GraphStorageRegistry gsRegistry;
 
+  /** Empty if the index has to be rebuilt before it is used the next time */
+  mutable std::shared_ptr<const TokenIndex> tokenIndex;
+  mutable std::mutex mutex_tokenIndex;
+  bool tokenIndexEnabled;
+
 private:
 
   void addDefaultStrings();
@@ -166,8 +250,20 @@ private:
   void loadGraphStorages(std::string dirPath, bool preloadComponents);
   void saveGraphStorages(std::string dirPath);
 
+  /**
+   * @brief Load a single graph storage from its directory, the memory mapped format is preferred over the cereal format.
+   * @return An empty pointer if there is no graph storage in this directory.
+   */
+  std::shared_ptr<ReadableGraphStorage> loadGraphStorage(const Component& c, const std::string& dir);
+  /**
+   * @brief Load the graph storages at the given locations, using up to numOfLoadingThreads threads.
+   */
+  void loadComponents(const std::map<Component, std::string>& locations);
+  static bool hasGraphStorageFile(const std::string& dir);
+
   bool ensureGraphStorageIsLoaded(const Component& c);
   size_t estimateGraphStorageMemorySize() const;
+  size_t estimateTokenIndexMemorySize() const;
   std::string gsInfo() const;
   std::string debugComponentString(const Component& c) const;
 
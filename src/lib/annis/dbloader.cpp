@@ -18,7 +18,13 @@
 
 using namespace annis;
 
-DBLoader::DBLoader(std::string location, std::function<void()> onloadCalback)
+DBLoader::DBLoader(std::string location, std::function<void()> onloadCalback,
+                   size_t numOfLoadingThreads, std::shared_ptr<ThreadPool> loadingThreadPool)
   : location(location), dbLoaded(false), onloadCalback(onloadCalback)
 {
+  if(numOfLoadingThreads > 0)
+  {
+    db.setNumOfLoadingThreads(numOfLoadingThreads);
+  }
+  db.setLoadingThreadPool(loadingThreadPool);
 }
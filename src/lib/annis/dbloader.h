@@ -18,11 +18,15 @@
 
 #include <annis/db.h>                         // for DB
 #include <stddef.h>                           // for size_t
+#include <cstdint>                            // for uint64_t
 #include <boost/thread/lockable_adapter.hpp>  // for shared_lockable_adapter
 #include <boost/thread/shared_mutex.hpp>      // for shared_mutex
 #include <functional>                         // for function
+#include <memory>                             // for shared_ptr
 #include <string>                             // for string
 
+namespace annis { class ThreadPool; }
+
 namespace annis
 {
 
@@ -38,7 +42,14 @@ namespace annis
     };
 
   public:
-    DBLoader(std::string location, std::function<void()> onloadCalback);
+    /**
+     * @param location
+     * @param onloadCalback
+     * @param numOfLoadingThreads Maximal number of components which are loaded in parallel, 0 uses the default of the DB.
+     * @param loadingThreadPool Pool which loads the components, a temporary one is created for each load if empty.
+     */
+    DBLoader(std::string location, std::function<void()> onloadCalback,
+             size_t numOfLoadingThreads = 0, std::shared_ptr<ThreadPool> loadingThreadPool = nullptr);
 
     LoadStatus status() const
     {
@@ -105,6 +116,14 @@ namespace annis
       }
     }
 
+    /**
+     * @brief Number of times the data of the database was cleared or loaded, see DB::getLoadGeneration().
+     */
+    std::uint64_t getLoadGeneration() const
+    {
+      return db.getLoadGeneration();
+    }
+
     std::string statusString() const
     {
       switch(status())
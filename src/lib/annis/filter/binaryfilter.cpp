@@ -46,6 +46,28 @@ bool BinaryFilter::next(std::vector<Match>& tuple)
   return false;
 }
 
+bool BinaryFilter::nextBatch(MatchBatch& batch)
+{
+  batch.clear();
+  if(op && inner)
+  {
+    // only the two columns of the condition are needed to decide which tuples are included
+    while(batch.empty() && inner->nextBatch(innerBatch))
+    {
+      const std::vector<Match>& lhsColumn = innerBatch.column(lhsIdx);
+      const std::vector<Match>& rhsColumn = innerBatch.column(rhsIdx);
+      for(size_t row=0; row < innerBatch.size(); row++)
+      {
+        if(op->filter(lhsColumn[row], rhsColumn[row]))
+        {
+          batch.add(innerBatch, row);
+        }
+      }
+    }
+  }
+  return !batch.empty();
+}
+
 void BinaryFilter::reset()
 {
   if(inner)
@@ -35,6 +35,7 @@ public:
     size_t lhsIdx, size_t rhsIdx);
 
   virtual bool next(std::vector<Match>& tuple) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
   virtual void reset() override;
 
   virtual ~BinaryFilter();
@@ -44,6 +45,8 @@ private:
   std::shared_ptr<Iterator> inner;
   size_t lhsIdx; 
   size_t rhsIdx;
+
+  MatchBatch innerBatch;
 };
 
 } // end namespace annis
@@ -0,0 +1,287 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "csrstorage.h"
+#include <annis/annosearch/exactannokeysearch.h>  // for ExactAnnoKeySearch
+#include <annis/util/dfs.h>                       // for CycleSafeDFS, DFSIt...
+#include <annis/util/mappedfile.h>                // for MappedFile, MappedFil...
+#include <annis/util/size_estimator.h>            // for element_size
+#include <algorithm>                              // for sort, binary_search
+#include <limits>                                 // for numeric_limits
+#include <list>                                   // for list
+#include "annis/annostorage.h"                    // for AnnoStorage
+#include "annis/db.h"                             // for DB
+#include "annis/graphstorage/graphstorage.h"      // for ReadableGraphStorage
+#include "annis/iterators.h"                      // for EdgeIterator
+#include "annis/types.h"                          // for Edge, GraphStatistic
+
+using namespace annis;
+using namespace std;
+
+namespace
+{
+
+/** Iterates over the direct successors of a node without any traversal state. */
+class CSRSliceIterator : public EdgeIterator
+{
+public:
+  CSRSliceIterator(const nodeid_t* begin, const nodeid_t* end)
+    : it(begin), itBegin(begin), itEnd(end)
+  {
+  }
+
+  virtual boost::optional<nodeid_t> next() override
+  {
+    if(it != itEnd)
+    {
+      return *(it++);
+    }
+    return boost::optional<nodeid_t>();
+  }
+
+  virtual void reset() override
+  {
+    it = itBegin;
+  }
+
+  virtual ~CSRSliceIterator() {}
+
+private:
+  const nodeid_t* it;
+  const nodeid_t* itBegin;
+  const nodeid_t* itEnd;
+};
+
+}
+
+CSRStorage::NodeIt::NodeIt(std::function<std::list<Annotation> (nodeid_t)> nodeAnnoMatchGenerator,
+                           bool maximalOneNodeAnno,
+                           bool returnsNothing,
+                           const CSRStorage &storage)
+  : BufferedEstimatedSearch(maximalOneNodeAnno, returnsNothing),
+    nodeAnnoMatchGenerator(nodeAnnoMatchGenerator),
+    storage(storage), currentIdx(0),
+    maxCount(storage.stat.nodes)
+{
+}
+
+void CSRStorage::NodeIt::reset()
+{
+  BufferedEstimatedSearch::reset();
+  currentIdx = 0;
+}
+
+CSRStorage::NodeIt::~NodeIt()
+{
+
+}
+
+bool CSRStorage::NodeIt::nextMatchBuffer(std::list<Match>& currentMatchBuffer)
+{
+  currentMatchBuffer.clear();
+  const MappableVector<uint32_t>& offsets = storage.offsets;
+  while(currentIdx + 1 < offsets.size())
+  {
+    const size_t idx = currentIdx++;
+    // only nodes with a non-empty slice are source nodes
+    if(offsets[idx] != offsets[idx+1])
+    {
+      const nodeid_t source = storage.firstNode + static_cast<nodeid_t>(idx);
+      if(getConstAnnoValue())
+      {
+        currentMatchBuffer.push_back({source, *getConstAnnoValue()});
+      }
+      else
+      {
+        for(const Annotation& anno : nodeAnnoMatchGenerator(source))
+        {
+          currentMatchBuffer.push_back({source, anno});
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void CSRStorage::copy(const DB &db, const ReadableGraphStorage &orig)
+{
+  clear();
+
+  std::vector<Edge> edges;
+
+  ExactAnnoKeySearch nodes(db, annis_ns, annis_node_name);
+  Match match;
+  while(nodes.next(match))
+  {
+    nodeid_t source = match.node;
+    std::vector<nodeid_t> outEdges = orig.getOutgoingEdges(source);
+    for(auto target : outEdges)
+    {
+      Edge e = {source, target};
+      edges.push_back(e);
+      std::vector<Annotation> annos = orig.getEdgeAnnotations(e);
+      for(auto a : annos)
+      {
+        edgeAnnos.addAnnotation(e, a);
+      }
+    }
+  }
+
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end(),
+                          [](const Edge& a, const Edge& b) {return a.source == b.source && a.target == b.target;}),
+              edges.end());
+
+  if(!edges.empty())
+  {
+    firstNode = edges.front().source;
+    const size_t numOfSources = edges.back().source - firstNode + 1;
+
+    // count the outgoing edges for each node and calculate the prefix sum
+    std::vector<uint32_t>& offsetsVec = offsets.vec();
+    std::vector<nodeid_t>& targetsVec = targets.vec();
+    offsetsVec.assign(numOfSources + 1, 0);
+    targetsVec.reserve(edges.size());
+    for(const Edge& e : edges)
+    {
+      offsetsVec[e.source - firstNode + 1]++;
+      targetsVec.push_back(e.target);
+    }
+    for(size_t i = 1; i < offsetsVec.size(); i++)
+    {
+      offsetsVec[i] += offsetsVec[i-1];
+    }
+  }
+
+  stat = orig.getStatistics();
+  edgeAnnos.calculateStatistics(db.strings);
+}
+
+void CSRStorage::clear()
+{
+  firstNode = 0;
+  offsets.clear();
+  targets.clear();
+  edgeAnnos.clear();
+
+  stat.valid = false;
+}
+
+bool CSRStorage::isConnected(const Edge &edge, unsigned int minDistance, unsigned int maxDistance) const
+{
+  if(minDistance == 1 && maxDistance == 1)
+  {
+    auto slice = outgoing(edge.source);
+    return std::binary_search(slice.first, slice.second, edge.target);
+  }
+  else
+  {
+    CycleSafeDFS dfs(*this, edge.source, minDistance, maxDistance);
+    DFSIteratorResult result = dfs.nextDFS();
+    while(result.found)
+    {
+      if(result.node == edge.target)
+      {
+        return true;
+      }
+      result = dfs.nextDFS();
+    }
+  }
+
+  return false;
+}
+
+std::unique_ptr<EdgeIterator> CSRStorage::findConnected(nodeid_t sourceNode,
+                                                 unsigned int minDistance,
+                                                 unsigned int maxDistance) const
+{
+  if(minDistance == 1 && maxDistance == 1)
+  {
+    // the slice is already sorted and unique, no need to track the visited nodes
+    auto slice = outgoing(sourceNode);
+    return std::unique_ptr<EdgeIterator>(new CSRSliceIterator(slice.first, slice.second));
+  }
+  return std::unique_ptr<EdgeIterator>(
+        new UniqueDFS(*this, sourceNode, minDistance, maxDistance));
+}
+
+int CSRStorage::distance(const Edge &edge) const
+{
+  CycleSafeDFS dfs(*this, edge.source, 0, uintmax);
+  DFSIteratorResult result = dfs.nextDFS();
+  while(result.found)
+  {
+    if(result.node == edge.target)
+    {
+      return result.distance;
+    }
+    result = dfs.nextDFS();
+  }
+  return -1;
+}
+
+std::vector<Annotation> CSRStorage::getEdgeAnnotations(const Edge& edge) const
+{
+  return edgeAnnos.getAnnotations(edge);
+}
+
+std::vector<nodeid_t> CSRStorage::getOutgoingEdges(nodeid_t node) const
+{
+  auto slice = outgoing(node);
+  return std::vector<nodeid_t>(slice.first, slice.second);
+}
+
+size_t CSRStorage::numberOfEdges() const
+{
+  return targets.size();
+}
+
+size_t CSRStorage::numberOfEdgeAnnotations() const
+{
+  return edgeAnnos.numberOfAnnotations();
+}
+
+size_t CSRStorage::estimateMemorySize()
+{
+  return
+      size_estimation::element_size(offsets)
+      + size_estimation::element_size(targets)
+      + edgeAnnos.estimateMemorySize()
+      + sizeof(CSRStorage);
+}
+
+bool CSRStorage::saveMapped(MappedFileWriter &writer) const
+{
+  // the annotations are not stored as plain arrays, they are copied to the heap when loading
+  writer.addCerealSection("csr_meta", stat, firstNode, edgeAnnos);
+  offsets.addTo(writer, "csr_offsets");
+  targets.addTo(writer, "csr_targets");
+  return true;
+}
+
+bool CSRStorage::loadMapped(std::shared_ptr<const MappedFile> file)
+{
+  if(!file->hasSection("csr_meta") || !file->hasSection("csr_offsets") || !file->hasSection("csr_targets"))
+  {
+    return false;
+  }
+  clear();
+  file->loadCereal("csr_meta", stat, firstNode, edgeAnnos);
+  offsets.map(file, "csr_offsets");
+  targets.map(file, "csr_targets");
+  return true;
+}
@@ -0,0 +1,175 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <cereal/types/polymorphic.hpp>       // for CEREAL_REGISTER_TYPE
+#include <cereal/types/vector.hpp>            // for vector serialization
+
+#include <annis/types.h>                      // for Edge, nodeid_t
+#include <annis/serializers.h>
+#include <annis/util/mappablevector.h>        // for MappableVector
+
+#include <annis/annostorage.h>                // for AnnoStorage
+#include <annis/graphstorage/graphstorage.h>  // for ReadableGraphStorage
+#include <annis/annosearch/estimatedsearch.h>
+#include <stddef.h>                           // for size_t
+#include <cstdint>                            // for uint32_t
+
+#include <memory>                             // for unique_ptr
+#include <vector>                             // for vector
+namespace annis { class DB; }
+namespace annis { class EdgeIterator; }
+namespace annis { class StringStorage; }
+
+
+namespace annis
+{
+
+/**
+ * @brief Read-only graph storage using a compressed sparse row (CSR) layout.
+ *
+ * The outgoing edges of all nodes are stored in a single contiguous array of targets which is
+ * sorted by source and target. An offset array indexed by the source node ID (relative to the
+ * smallest source node) points to the beginning of each slice.
+ *
+ * This storage can't be changed after it has been created via copy(), it is meant for components
+ * which are neither trees nor linear (e.g. POINTING) and where the adjacency list is only needed for lookups.
+ * When loaded with loadMapped() the offset and target arrays are used directly from the memory mapped file.
+ */
+class CSRStorage : public ReadableGraphStorage
+{
+
+public:
+
+  class NodeIt : public BufferedEstimatedSearch
+  {
+  public:
+    NodeIt(std::function<std::list<Annotation> (nodeid_t)> nodeAnnoMatchGenerator,
+           bool maximalOneNodeAnno, bool returnsNothing,
+           const CSRStorage& storage);
+
+    virtual void reset() override;
+
+    virtual std::function<std::list<Annotation> (nodeid_t)> getNodeAnnoMatchGenerator() override
+    {
+      return nodeAnnoMatchGenerator;
+    }
+
+    virtual std::int64_t guessMaxCount() const override
+    {
+      return maxCount;
+    }
+
+    virtual ~NodeIt();
+
+  protected:
+    virtual bool nextMatchBuffer(std::list<Match>& currentMatchBuffer) override;
+  private:
+    const std::function<std::list<Annotation> (nodeid_t)> nodeAnnoMatchGenerator;
+
+    const CSRStorage& storage;
+    /** Index into the offset array of the next source node to check */
+    size_t currentIdx;
+
+    const std::int64_t maxCount;
+
+  };
+
+  CSRStorage() : firstNode(0) {}
+
+  virtual void copy(const DB& db, const ReadableGraphStorage& orig) override;
+
+  virtual void clear() override;
+
+  virtual bool isConnected(const Edge& edge, unsigned int minDistance, unsigned int maxDistance) const override;
+  virtual std::unique_ptr<EdgeIterator> findConnected(nodeid_t sourceNode,
+                                           unsigned int minDistance = 1,
+                                           unsigned int maxDistance = 1) const override;
+
+  virtual int distance(const Edge &edge) const override;
+
+  virtual std::vector<Annotation> getEdgeAnnotations(const Edge &edge) const override;
+  virtual std::vector<nodeid_t> getOutgoingEdges(nodeid_t node) const override;
+
+  virtual size_t numberOfEdges() const override;
+  virtual size_t numberOfEdgeAnnotations() const override;
+
+  virtual const BTreeMultiAnnoStorage<Edge>& getAnnoStorage() const override
+  {
+    return edgeAnnos;
+  }
+
+  virtual std::shared_ptr<EstimatedSearch> getSourceNodeIterator(
+      std::function<std::list<Annotation> (nodeid_t)> nodeAnnoMatchGenerator, bool maximalOneNodeAnno,
+      bool returnsNothing) const override
+  {
+    return std::make_shared<NodeIt>(nodeAnnoMatchGenerator, maximalOneNodeAnno, returnsNothing, *this);
+  }
+
+  virtual size_t estimateMemorySize() override;
+
+  virtual bool saveMapped(MappedFileWriter& writer) const override;
+  virtual bool loadMapped(std::shared_ptr<const MappedFile> file) override;
+
+  template<class Archive>
+  void serialize(Archive & archive)
+  {
+    archive(cereal::base_class<ReadableGraphStorage>(this),
+            firstNode, offsets, targets, edgeAnnos);
+  }
+
+private:
+
+  /**
+   * @brief Get the slice of the target array for the outgoing edges of a node.
+   * @return A pointer range which is empty if the node has no outgoing edges.
+   */
+  std::pair<const nodeid_t*, const nodeid_t*> outgoing(nodeid_t node) const
+  {
+    if(node >= firstNode)
+    {
+      const size_t idx = node - firstNode;
+      if(idx + 1 < offsets.size())
+      {
+        return {targets.data() + offsets[idx], targets.data() + offsets[idx+1]};
+      }
+    }
+    return {nullptr, nullptr};
+  }
+
+  /** The node ID corresponding to the first entry of the offset array. */
+  nodeid_t firstNode;
+  /** Node i has the targets in the range [offsets[i-firstNode], offsets[i-firstNode+1]) */
+  MappableVector<uint32_t> offsets;
+  MappableVector<nodeid_t> targets;
+
+  BTreeMultiAnnoStorage<Edge> edgeAnnos;
+
+private:
+  friend class cereal::access;
+
+};
+
+
+} // end namespace annis
+
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/archives/xml.hpp>
+#include <cereal/archives/json.hpp>
+
+CEREAL_REGISTER_TYPE(annis::CSRStorage)
@@ -28,6 +28,8 @@
 namespace annis { class DB; }
 namespace annis { class StringStorage; }
 namespace annis { class EdgeIterator; }
+namespace annis { class MappedFile; }
+namespace annis { class MappedFileWriter; }
 
 
 namespace annis
@@ -85,6 +87,24 @@ public:
 
   virtual size_t estimateMemorySize() = 0;
 
+  /**
+   * @brief Add the content of this graph storage as sections to a memory mappable file.
+   * @return False if the implementation only supports the cereal serialization.
+   */
+  virtual bool saveMapped(MappedFileWriter& /* writer */) const
+  {
+    return false;
+  }
+
+  /**
+   * @brief Load the content from a file written by saveMapped(), the data should be used in place if possible.
+   * @return False if the implementation does not support the mapped format or the file is incompatible.
+   */
+  virtual bool loadMapped(std::shared_ptr<const MappedFile> /* file */)
+  {
+    return false;
+  }
+
   template<class Archive>
   void serialize(Archive & archive)
   {
@@ -17,6 +17,7 @@
 #include "graphstorageregistry.h"
 
 #include <annis/graphstorage/adjacencyliststorage.h>  // for AdjacencyListSt...
+#include <annis/graphstorage/csrstorage.h>           // for CSRStorage
 #include <annis/graphstorage/linearstorage.h>         // for LinearStorage
 #include <annis/graphstorage/prepostorderstorage.h>   // for PrePostOrderSto...
 #include <cstdint>                                    // for uint32_t, int32_t
@@ -48,6 +49,7 @@ const std::string GraphStorageRegistry::prepostorderO32L8 = "prepostorderO32L8";
 const std::string GraphStorageRegistry::prepostorderO16L32 = "prepostorderO16L32";
 const std::string GraphStorageRegistry::prepostorderO16L8 = "prepostorderO16L8";
 const std::string GraphStorageRegistry::adjacencylist = "adjacencylist";
+const std::string GraphStorageRegistry::csr = "csr";
 
 GraphStorageRegistry::GraphStorageRegistry()
 {
@@ -94,6 +96,10 @@ std::string annis::GraphStorageRegistry::getName(std::weak_ptr<const ReadableGra
     {
       return adjacencylist;
     }
+    else if(std::dynamic_pointer_cast<const CSRStorage>(db) != nullptr)
+    {
+      return csr;
+    }
   }
   return "";
 }
@@ -132,6 +138,10 @@ std::unique_ptr<ReadableGraphStorage> GraphStorageRegistry::createGraphStorage(s
   {
     return std::unique_ptr<ReadableGraphStorage>(new AdjacencyListStorage());
   }
+  else if(name == csr)
+  {
+    return std::unique_ptr<ReadableGraphStorage>(new CSRStorage());
+  }
 
   return std::unique_ptr<ReadableGraphStorage>();
 }
@@ -158,12 +168,16 @@ std::string GraphStorageRegistry::getImplByHeuristics(const Component &component
 {
   std::string result = adjacencylist;
 
+  // the CSR storage has no index for the incoming edges, only use it for the components which are not
+  // used by the token and coverage related operators
+  const std::string nonTreeImpl = component.type == ComponentType::POINTING ? csr : adjacencylist;
+
   if(stats.valid)
   {
     if(stats.maxDepth <= 1)
     {
-      // if we don't have any deep graph structures an adjencency list is always fasted (and has no overhead)
-      result = adjacencylist;
+      // if we don't have any deep graph structures a (compressed) adjencency list is always fasted (and has no overhead)
+      result = nonTreeImpl;
     }
     else if(stats.rootedTree)
     {
@@ -199,6 +213,15 @@ std::string GraphStorageRegistry::getImplByHeuristics(const Component &component
         // TODO: how to determine the border?
         result = getPrePostOrderBySize(stats, false);
       }
+      else
+      {
+        result = nonTreeImpl;
+      }
+    }
+    else
+    {
+      // cyclic graphs can only be traversed with a DFS, make the lookup of the outgoing edges as fast as possible
+      result = nonTreeImpl;
     }
   }
 
@@ -50,6 +50,7 @@ public:
   static const std::string prepostorderO16L32;
   static const std::string prepostorderO16L8;
   static const std::string adjacencylist;
+  static const std::string csr;
 
 private:
 
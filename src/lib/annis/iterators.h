@@ -1,6 +1,8 @@
 #pragma once
 
 #include <annis/types.h>
+#include <stddef.h>
+#include <cstdint>
 #include <vector>
 #include <list>
 #include <functional>
@@ -18,15 +20,210 @@ public:
   virtual ~EdgeIterator() {}
 };
 
+/**
+ * @brief A batch of result tuples which is stored column-wise.
+ *
+ * Column i holds the i-th match of all tuples of the batch. Operators which only need a single column
+ * (e.g. a filter on the join columns) can process the batch without copying the complete tuples.
+ * All tuples of a batch have the same number of columns, which is set when adding the first tuple.
+ */
+class MatchBatch
+{
+public:
+  static const size_t defaultCapacity = 1024;
+
+  MatchBatch(size_t capacity = defaultCapacity) : capacity(capacity) {}
+
+  size_t size() const
+  {
+    return columns.empty() ? 0 : columns[0].size();
+  }
+
+  size_t width() const
+  {
+    return columns.size();
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  bool full() const
+  {
+    return size() >= capacity;
+  }
+
+  /**
+   * @brief Remove all tuples, but keep the allocated memory.
+   */
+  void clear()
+  {
+    for(auto& c : columns)
+    {
+      c.clear();
+    }
+  }
+
+  const std::vector<Match>& column(size_t col) const
+  {
+    return columns[col];
+  }
+
+  const Match& get(size_t row, size_t col) const
+  {
+    return columns[col][row];
+  }
+
+  /**
+   * @brief Copy a tuple of the batch to a row-wise representation.
+   */
+  void get(size_t row, std::vector<Match>& tuple) const
+  {
+    tuple.resize(columns.size());
+    for(size_t col=0; col < columns.size(); col++)
+    {
+      tuple[col] = columns[col][row];
+    }
+  }
+
+  /** Add a tuple with a single match. */
+  void add(const Match& m)
+  {
+    setWidth(1);
+    columns[0].push_back(m);
+  }
+
+  void add(const std::vector<Match>& tuple)
+  {
+    setWidth(tuple.size());
+    for(size_t col=0; col < tuple.size(); col++)
+    {
+      columns[col].push_back(tuple[col]);
+    }
+  }
+
+  /** Add a copy of the tuple at the given row of another batch. */
+  void add(const MatchBatch& other, size_t row)
+  {
+    setWidth(other.width());
+    for(size_t col=0; col < other.columns.size(); col++)
+    {
+      columns[col].push_back(other.columns[col][row]);
+    }
+  }
+
+  /** Add a copy of the tuple at the given row of another batch extended by one additional match. */
+  void add(const MatchBatch& other, size_t row, const Match& extra)
+  {
+    setWidth(other.width() + 1);
+    for(size_t col=0; col < other.columns.size(); col++)
+    {
+      columns[col].push_back(other.columns[col][row]);
+    }
+    columns.back().push_back(extra);
+  }
+
+private:
+  void setWidth(size_t newWidth)
+  {
+    if(columns.size() != newWidth && empty())
+    {
+      columns.resize(newWidth);
+    }
+  }
+
+private:
+  size_t capacity;
+  std::vector<std::vector<Match>> columns;
+};
+
 class Iterator
 {
 public:
   virtual bool next(std::vector<Match>& tuple) = 0;
   virtual void reset() = 0;
 
+  /**
+   * @brief Fetch the next tuples at once.
+   *
+   * The default implementation collects the results of next() until the batch is full.
+   * Calls to next() and nextBatch() must not be mixed without a reset() in between.
+   *
+   * @return False if there are no more tuples and the batch is empty.
+   */
+  virtual bool nextBatch(MatchBatch& batch)
+  {
+    batch.clear();
+    std::vector<Match> tuple;
+    while(!batch.full() && next(tuple))
+    {
+      batch.add(tuple);
+    }
+    return !batch.empty();
+  }
+
+  /**
+   * @brief Count all results without returning them.
+   *
+   * The default implementation only counts the size of the batches returned by nextBatch(), sub-classes can
+   * overwrite this if they can count the results without creating the tuples.
+   * Calls to count() must not be mixed with next() or nextBatch() without a reset() in between.
+   */
+  virtual std::uint64_t count()
+  {
+    std::uint64_t result = 0;
+    MatchBatch batch;
+    while(nextBatch(batch))
+    {
+      result += batch.size();
+    }
+    return result;
+  }
+
   virtual ~Iterator() {}
 };
 
+/**
+ * @brief Base class for iterators which produce their results batch-wise.
+ *
+ * next() is an adapter which returns the tuples of an internal batch one by one.
+ * Sub-classes overriding reset() must call BatchIterator::reset().
+ */
+class BatchIterator : public Iterator
+{
+public:
+  BatchIterator() : bufferPos(0) {}
+
+  virtual bool next(std::vector<Match>& tuple) override
+  {
+    if(bufferPos >= buffer.size())
+    {
+      bufferPos = 0;
+      if(!nextBatch(buffer))
+      {
+        tuple.clear();
+        return false;
+      }
+    }
+    buffer.get(bufferPos++, tuple);
+    return true;
+  }
+
+  virtual bool nextBatch(MatchBatch& batch) override = 0;
+
+  virtual void reset() override
+  {
+    buffer.clear();
+    bufferPos = 0;
+  }
+
+  virtual ~BatchIterator() {}
+private:
+  MatchBatch buffer;
+  size_t bufferPos;
+};
+
 class AnnoIt : public Iterator
 {
 public:
@@ -54,6 +251,20 @@ public:
     }
   }
 
+  virtual bool nextBatch(MatchBatch& batch) override
+  {
+    batch.clear();
+    Match m;
+    while(!batch.full() && next(m))
+    {
+      if(acceptedByOutputFilter(m))
+      {
+        batch.add(m);
+      }
+    }
+    return !batch.empty();
+  }
+
   void setOutputFilter(std::list<MatchFilter> filters)
   {
     if(filters.empty())
@@ -76,6 +287,11 @@ public:
     }
   }
 
+  bool hasOutputFilter() const
+  {
+    return outputFilter ? true : false;
+  }
+
   MatchFilter getOutputFilter() const
   {
     if(outputFilter)
@@ -89,6 +305,11 @@ public:
   }
 
   virtual ~AnnoIt() {}
+protected:
+  bool acceptedByOutputFilter(const Match& m) const
+  {
+    return !outputFilter || (*outputFilter)(m);
+  }
 private:
   boost::optional<MatchFilter> outputFilter;
 };
@@ -0,0 +1,138 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "bandjoin.h"
+#include <annis/operators/operator.h>     // for Operator
+#include <algorithm>                      // for stable_sort
+#include <boost/optional/optional.hpp>    // for optional
+#include "annis/util/comparefunctions.h"  // for checkAnnotationKeyEqual
+
+using namespace annis;
+
+
+BandJoin::BandJoin(std::shared_ptr<Operator> op,
+                   std::shared_ptr<Iterator> lhs,
+                   std::shared_ptr<Iterator> rhs,
+                   size_t lhsIdx, size_t rhsIdx)
+  : op(op), lhs(lhs), rhs(rhs), lhsIdx(lhsIdx), rhsIdx(rhsIdx),
+    minDistance(0), maxDistance(0),
+    sorted(false), currentLHS(0), windowBegin(0), currentRHS(0)
+{
+  if(op)
+  {
+    std::pair<std::int64_t, std::int64_t> band = op->band();
+    minDistance = band.first;
+    maxDistance = band.second;
+  }
+}
+
+bool BandJoin::next(std::vector<Match>& result)
+{
+  result.clear();
+
+  if(!op || !lhs || !rhs)
+  {
+    return false;
+  }
+
+  if(!sorted)
+  {
+    materialize(*lhs, lhsIdx, true, lhsTuples, lhsEntries);
+    materialize(*rhs, rhsIdx, false, rhsTuples, rhsEntries);
+    sorted = true;
+    moveWindow();
+  }
+
+  while(currentLHS < lhsEntries.size())
+  {
+    const Entry& l = lhsEntries[currentLHS];
+    while(currentRHS < rhsEntries.size())
+    {
+      const Entry& r = rhsEntries[currentRHS];
+      if(r.key.first != l.key.first || r.key.second - l.key.second > maxDistance)
+      {
+        // the rest of the RHS is outside the band
+        break;
+      }
+      currentRHS++;
+
+      const std::vector<Match>& matchLHS = lhsTuples[l.tupleIdx];
+      const std::vector<Match>& matchRHS = rhsTuples[r.tupleIdx];
+
+      // do not include the same match if not reflexive
+      if(!op->isReflexive()
+         && matchLHS[lhsIdx].node == matchRHS[rhsIdx].node
+         && checkAnnotationKeyEqual(matchLHS[lhsIdx].anno, matchRHS[rhsIdx].anno))
+      {
+        continue;
+      }
+
+      result.reserve(matchLHS.size() + matchRHS.size());
+      result.insert(result.end(), matchLHS.begin(), matchLHS.end());
+      result.insert(result.end(), matchRHS.begin(), matchRHS.end());
+      return true;
+    }
+
+    currentLHS++;
+    moveWindow();
+  }
+
+  return false;
+}
+
+void BandJoin::materialize(Iterator& it, size_t idx, bool isLHS,
+                           std::vector<std::vector<Match>>& tuples, std::vector<Entry>& entries)
+{
+  std::vector<Match> tuple;
+  while(it.next(tuple))
+  {
+    boost::optional<BandKey> key = isLHS ? op->bandKeyLHS(tuple[idx]) : op->bandKeyRHS(tuple[idx]);
+    if(key)
+    {
+      entries.push_back({*key, tuples.size()});
+      tuples.push_back(tuple);
+    }
+  }
+  std::stable_sort(entries.begin(), entries.end());
+}
+
+void BandJoin::moveWindow()
+{
+  if(currentLHS < lhsEntries.size())
+  {
+    const BandKey& l = lhsEntries[currentLHS].key;
+    const BandKey lowerBound(l.first, l.second + minDistance);
+    while(windowBegin < rhsEntries.size() && rhsEntries[windowBegin].key < lowerBound)
+    {
+      windowBegin++;
+    }
+    currentRHS = windowBegin;
+  }
+}
+
+void BandJoin::reset()
+{
+  // the sorted inputs are kept, only the sweep starts again
+  currentLHS = 0;
+  windowBegin = 0;
+  currentRHS = 0;
+  moveWindow();
+}
+
+BandJoin::~BandJoin()
+{
+
+}
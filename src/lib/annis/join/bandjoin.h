@@ -0,0 +1,92 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/iterators.h>           // for Iterator
+#include <annis/operators/operator.h>  // for BandKey
+#include <annis/types.h>               // for Match
+#include <stddef.h>                    // for size_t
+#include <cstdint>                     // for int64_t
+#include <memory>                      // for shared_ptr
+#include <vector>                      // for vector
+
+
+namespace annis
+{
+
+  /**
+   * A sort-merge join for operators which compare the distance of positions inside a group (see Operator::hasBandKey()),
+   * e.g. the precedence of token inside a text.
+   *
+   * Both inputs are materialized and sorted by their band key. For each LHS tuple the RHS tuples inside the band
+   * are found by sweeping a window over the sorted RHS tuples. Since the LHS tuples are sorted, the window only moves
+   * forward.
+   *
+   * @param lhsIdx the column of the LHS tuple to join on
+   * @param rhsIdx the column of the RHS tuple to join on
+   */
+  class BandJoin : public Iterator
+  {
+  public:
+    BandJoin(std::shared_ptr<Operator> op,
+             std::shared_ptr<Iterator> lhs, std::shared_ptr<Iterator> rhs,
+             size_t lhsIdx, size_t rhsIdx);
+    virtual ~BandJoin();
+
+    virtual bool next(std::vector<Match>& tuple) override;
+    virtual void reset() override;
+  private:
+    struct Entry
+    {
+      BandKey key;
+      size_t tupleIdx;
+
+      bool operator<(const Entry& other) const
+      {
+        return key < other.key;
+      }
+    };
+
+    std::shared_ptr<Operator> op;
+
+    std::shared_ptr<Iterator> lhs;
+    std::shared_ptr<Iterator> rhs;
+
+    const size_t lhsIdx;
+    const size_t rhsIdx;
+
+    std::int64_t minDistance;
+    std::int64_t maxDistance;
+
+    bool sorted;
+    std::vector<std::vector<Match>> lhsTuples;
+    std::vector<std::vector<Match>> rhsTuples;
+    std::vector<Entry> lhsEntries;
+    std::vector<Entry> rhsEntries;
+
+    size_t currentLHS;
+    /** First RHS entry which is not left of the band of the current LHS */
+    size_t windowBegin;
+    size_t currentRHS;
+  private:
+    void materialize(Iterator& it, size_t idx, bool isLHS,
+                     std::vector<std::vector<Match>>& tuples, std::vector<Entry>& entries);
+    void moveWindow();
+  };
+
+
+} // end namespace annis
@@ -0,0 +1,127 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "hashjoin.h"
+#include <annis/operators/operator.h>     // for Operator
+#include <boost/optional/optional.hpp>    // for optional
+#include "annis/util/comparefunctions.h"  // for checkAnnotationKeyEqual
+
+using namespace annis;
+
+
+HashJoin::HashJoin(std::shared_ptr<Operator> op,
+                   std::shared_ptr<Iterator> lhs,
+                   std::shared_ptr<Iterator> rhs,
+                   size_t lhsIdx, size_t rhsIdx,
+                   bool leftIsBuild)
+  : op(op), leftIsBuild(leftIsBuild),
+    build(leftIsBuild ? lhs : rhs), probe(leftIsBuild ? rhs : lhs),
+    buildIdx(leftIsBuild ? lhsIdx : rhsIdx), probeIdx(leftIsBuild ? rhsIdx : lhsIdx),
+    hashTableBuilt(false), candidates(nullptr), candidatePos(0)
+{
+}
+
+bool HashJoin::next(std::vector<Match>& result)
+{
+  result.clear();
+
+  if(!op || !build || !probe)
+  {
+    return false;
+  }
+
+  if(!hashTableBuilt)
+  {
+    buildHashTable();
+  }
+  if(hashTable.empty())
+  {
+    return false;
+  }
+
+  do
+  {
+    while(candidates && candidatePos < candidates->size())
+    {
+      const std::vector<Match>& matchBuild = buildTuples[(*candidates)[candidatePos++]];
+
+      // do not include the same match if not reflexive
+      if(!op->isReflexive()
+         && matchBuild[buildIdx].node == matchProbe[probeIdx].node
+         && checkAnnotationKeyEqual(matchBuild[buildIdx].anno, matchProbe[probeIdx].anno))
+      {
+        continue;
+      }
+
+      // the LHS columns are always the first ones of the result
+      const std::vector<Match>& first = leftIsBuild ? matchBuild : matchProbe;
+      const std::vector<Match>& second = leftIsBuild ? matchProbe : matchBuild;
+      result.reserve(first.size() + second.size());
+      result.insert(result.end(), first.begin(), first.end());
+      result.insert(result.end(), second.begin(), second.end());
+      return true;
+    }
+  } while(nextProbe());
+
+  return false;
+}
+
+void HashJoin::buildHashTable()
+{
+  std::vector<Match> tuple;
+  while(build->next(tuple))
+  {
+    boost::optional<JoinKey> key = op->joinKey(tuple[buildIdx]);
+    if(key)
+    {
+      hashTable[*key].push_back(buildTuples.size());
+      buildTuples.push_back(tuple);
+    }
+  }
+  hashTableBuilt = true;
+}
+
+bool HashJoin::nextProbe()
+{
+  candidates = nullptr;
+  candidatePos = 0;
+  while(probe->next(matchProbe))
+  {
+    boost::optional<JoinKey> key = op->joinKey(matchProbe[probeIdx]);
+    if(key)
+    {
+      auto itCandidates = hashTable.find(*key);
+      if(itCandidates != hashTable.end())
+      {
+        candidates = &itCandidates->second;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void HashJoin::reset()
+{
+  probe->reset();
+  candidates = nullptr;
+  candidatePos = 0;
+}
+
+HashJoin::~HashJoin()
+{
+
+}
@@ -0,0 +1,88 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/iterators.h>           // for Iterator
+#include <annis/operators/operator.h>  // for JoinKey
+#include <annis/types.h>               // for Match
+#include <stddef.h>                    // for size_t
+#include <cstdint>                     // for uint64_t
+#include <functional>                  // for hash
+#include <memory>                      // for shared_ptr
+#include <unordered_map>               // for unordered_map
+#include <vector>                      // for vector
+
+
+namespace annis
+{
+
+  /**
+   * A join for operators which can be expressed as equality of a join key (see Operator::hasJoinKey()).
+   *
+   * All tuples of the build side are inserted into a hash table by the join key of their match at the join column.
+   * The tuples of the probe side are then only compared with the tuples that have the same key.
+   * The hash table is kept when the join is reset.
+   *
+   * @param lhsIdx the column of the LHS tuple to join on
+   * @param rhsIdx the column of the RHS tuple to join on
+   * @param leftIsBuild If true, the LHS is inserted into the hash table, otherwise the RHS.
+   */
+  class HashJoin : public Iterator
+  {
+  public:
+    HashJoin(std::shared_ptr<Operator> op,
+             std::shared_ptr<Iterator> lhs, std::shared_ptr<Iterator> rhs,
+             size_t lhsIdx, size_t rhsIdx,
+             bool leftIsBuild=true);
+    virtual ~HashJoin();
+
+    virtual bool next(std::vector<Match>& tuple) override;
+    virtual void reset() override;
+  private:
+    struct JoinKeyHash
+    {
+      size_t operator()(const JoinKey& k) const
+      {
+        return std::hash<std::uint64_t>()(k.first) ^ (std::hash<std::uint64_t>()(k.second) * 31);
+      }
+    };
+
+    std::shared_ptr<Operator> op;
+
+    const bool leftIsBuild;
+
+    std::shared_ptr<Iterator> build;
+    std::shared_ptr<Iterator> probe;
+
+    const size_t buildIdx;
+    const size_t probeIdx;
+
+    bool hashTableBuilt;
+    std::vector<std::vector<Match>> buildTuples;
+    /** Maps the join key to the positions in the build tuples */
+    std::unordered_map<JoinKey, std::vector<size_t>, JoinKeyHash> hashTable;
+
+    std::vector<Match> matchProbe;
+    const std::vector<size_t>* candidates;
+    size_t candidatePos;
+  private:
+    void buildHashTable();
+    bool nextProbe();
+  };
+
+
+} // end namespace annis
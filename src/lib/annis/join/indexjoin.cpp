@@ -32,7 +32,7 @@ IndexJoin::IndexJoin(const DB &db, std::shared_ptr<Operator> op,
                      bool maximalOneRHSAnno)
   : db(db), op(op),
     left(lhs), lhsIdx(lhsIdx), matchGeneratorFunc(matchGeneratorFunc),
-    currentLHSMatchValid(false),
+    lhsRow(0), currentLHSMatchValid(false),
     operatorIsReflexive(op->isReflexive()),
     maximalOneRHSAnno(maximalOneRHSAnno)
 {
@@ -44,31 +44,29 @@ IndexJoin::~IndexJoin()
 
 }
 
-bool IndexJoin::next(std::vector<Match>& tuple)
+bool IndexJoin::nextBatch(MatchBatch& batch)
 {
-  tuple.clear();
+  batch.clear();
 
-  if(!currentLHSMatchValid)
-  {
-    nextLeftMatch();
-  }
-  
-  if(!op || !left || !currentLHSMatchValid)
+  if(!op || !left)
   {
     return false;
   }
-  
-  if(!maximalOneRHSAnno && nextRightAnnotation())
+
+  if(!currentLHSMatchValid && !nextLeftMatch())
   {
-    tuple.reserve(currentLHSMatch.size()+1);
-    tuple.insert(tuple.end(), currentLHSMatch.begin(), currentLHSMatch.end());
-    tuple.push_back(currentRHSMatch);
-    return true;
+    return false;
   }
 
   do
   {
-    while(matchesByOperator && matchesByOperator->next(currentRHSMatch))
+    // there might be annotations left from the last call
+    while(!batch.full() && !maximalOneRHSAnno && nextRightAnnotation())
+    {
+      batch.add(lhsBatch, lhsRow, currentRHSMatch);
+    }
+
+    while(!batch.full() && matchesByOperator && matchesByOperator->next(currentRHSMatch))
     {
       if(maximalOneRHSAnno)
       {
@@ -77,14 +75,11 @@ bool IndexJoin::next(std::vector<Match>& tuple)
         if(!annos.empty())
         {
           currentRHSMatch.anno = annos.front();
-          if(operatorIsReflexive || currentLHSMatch[lhsIdx].node != currentRHSMatch.node
-             || !checkAnnotationKeyEqual(currentLHSMatch[lhsIdx].anno, currentRHSMatch.anno))
+          const Match& lhs = lhsBatch.get(lhsRow, lhsIdx);
+          if(operatorIsReflexive || lhs.node != currentRHSMatch.node
+             || !checkAnnotationKeyEqual(lhs.anno, currentRHSMatch.anno))
           {
-            tuple.reserve(currentLHSMatch.size()+1);
-            tuple.insert(tuple.end(), currentLHSMatch.begin(), currentLHSMatch.end());
-            tuple.push_back(currentRHSMatch);
-
-            return true;
+            batch.add(lhsBatch, lhsRow, currentRHSMatch);
           }
         }
       }
@@ -92,23 +87,61 @@ bool IndexJoin::next(std::vector<Match>& tuple)
       {
         rhsCandidates = matchGeneratorFunc(currentRHSMatch.node);
 
-        if(nextRightAnnotation())
+        while(!batch.full() && nextRightAnnotation())
         {
-          tuple.reserve(currentLHSMatch.size()+1);
-          tuple.insert(tuple.end(), currentLHSMatch.begin(), currentLHSMatch.end());
-          tuple.push_back(currentRHSMatch);
-          return true;
+          batch.add(lhsBatch, lhsRow, currentRHSMatch);
         }
       }
     } // end while there are right candidates
+
+    if(batch.full())
+    {
+      // continue with the same LHS tuple in the next call
+      break;
+    }
   } while(nextLeftMatch()); // end while left has match
 
+  return !batch.empty();
+}
 
-  return false;
+std::uint64_t IndexJoin::count()
+{
+  std::uint64_t result = 0;
+
+  if(!op || !left)
+  {
+    return result;
+  }
+
+  if(!currentLHSMatchValid && !nextLeftMatch())
+  {
+    return result;
+  }
+
+  // same as nextBatch() but the RHS matches are only counted and never added to a tuple
+  do
+  {
+    while(matchesByOperator && matchesByOperator->next(currentRHSMatch))
+    {
+      rhsCandidates = matchGeneratorFunc(currentRHSMatch.node);
+      if(maximalOneRHSAnno && !rhsCandidates.empty())
+      {
+        rhsCandidates.resize(1);
+      }
+      while(nextRightAnnotation())
+      {
+        result++;
+      }
+    }
+  } while(nextLeftMatch());
+
+  return result;
 }
 
 void IndexJoin::reset()
 {
+  BatchIterator::reset();
+
   if(left)
   {
     left->reset();
@@ -116,33 +149,56 @@ void IndexJoin::reset()
 
   matchesByOperator.reset(nullptr);
   rhsCandidates.clear();
+  lhsBatch.clear();
+  lhsRow = 0;
   currentLHSMatchValid = false;
 }
 
 bool IndexJoin::nextLeftMatch()
 {
   rhsCandidates.clear();
-  if(op && op->valid() && left && left->next(currentLHSMatch))
+  matchesByOperator.reset(nullptr);
+  currentLHSMatchValid = false;
+
+  if(!op || !op->valid() || !left)
   {
-    currentLHSMatchValid = true;
+    return false;
+  }
 
+  while(true)
+  {
+    lhsRow++;
+    if(lhsRow >= lhsBatch.size())
+    {
+      lhsRow = 0;
+      if(!left->nextBatch(lhsBatch))
+      {
+        return false;
+      }
+    }
 
-    matchesByOperator = op->retrieveMatches(currentLHSMatch[lhsIdx]);
+    // skip all LHS tuples where the operator can't retrieve any matches
+    matchesByOperator = op->retrieveMatches(lhsBatch.get(lhsRow, lhsIdx));
     if(matchesByOperator)
     {
+      currentLHSMatchValid = true;
       return true;
     }
   }
-
-  return false;
 }
 
 bool IndexJoin::nextRightAnnotation()
 {
+  if(rhsCandidates.empty())
+  {
+    return false;
+  }
+
+  const Match& lhs = lhsBatch.get(lhsRow, lhsIdx);
   while(!rhsCandidates.empty())
   {
-    if(operatorIsReflexive || currentLHSMatch[lhsIdx].node != currentRHSMatch.node
-       || !checkAnnotationKeyEqual(currentLHSMatch[lhsIdx].anno, rhsCandidates.front()))
+    if(operatorIsReflexive || lhs.node != currentRHSMatch.node
+       || !checkAnnotationKeyEqual(lhs.anno, rhsCandidates.front()))
     {
       currentRHSMatch.anno = std::move(rhsCandidates.front());
       rhsCandidates.pop_front();
@@ -155,4 +211,3 @@ bool IndexJoin::nextRightAnnotation()
   }
   return false;
 }
-
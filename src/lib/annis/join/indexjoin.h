@@ -19,6 +19,7 @@
 #include <annis/iterators.h>  // for Iterator
 #include <annis/types.h>      // for Annotation, Match, nodeid_t
 #include <stddef.h>           // for size_t
+#include <cstdint>            // for uint64_t
 #include <functional>         // for function
 #include <list>               // for list
 #include <memory>             // for shared_ptr, unique_ptr
@@ -32,9 +33,10 @@ namespace annis
 /**
  * A join that takes the left argument as a seed, finds all connected nodes
  * (probably using and index of the graph storage) and checks the condition for each node.
+ * The LHS is consumed batch-wise and the results are produced as batches.
  * This join is not parallized.
  */
-class IndexJoin : public Iterator
+class IndexJoin : public BatchIterator
 {
 public:
   IndexJoin(const DB& db, std::shared_ptr<Operator> op,
@@ -44,7 +46,8 @@ public:
            bool maximalOneRHSAnno);
   virtual ~IndexJoin();
 
-  virtual bool next(std::vector<Match>& tuple) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
+  virtual std::uint64_t count() override;
   virtual void reset() override;
 private:
   const DB& db;
@@ -55,7 +58,9 @@ private:
   const std::function<std::list<Annotation> (nodeid_t)> matchGeneratorFunc;
 
   std::unique_ptr<AnnoIt> matchesByOperator;
-  std::vector<Match> currentLHSMatch;
+  MatchBatch lhsBatch;
+  /** Row of the current LHS tuple in the LHS batch */
+  size_t lhsRow;
   bool currentLHSMatchValid;
   std::list<Annotation> rhsCandidates;
 
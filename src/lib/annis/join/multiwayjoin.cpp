@@ -0,0 +1,355 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "multiwayjoin.h"
+#include <annis/operators/operator.h>     // for Operator
+#include <algorithm>                      // for sort, lower_bound, unique
+#include "annis/util/comparefunctions.h"  // for checkAnnotationKeyEqual
+
+using namespace annis;
+
+namespace
+{
+
+/**
+ * @brief Intersect several sorted and unique lists by letting each list leap to the largest current value of the others.
+ */
+std::vector<nodeid_t> leapfrogIntersection(const std::vector<std::vector<nodeid_t>>& lists)
+{
+  std::vector<nodeid_t> result;
+  if(lists.empty())
+  {
+    return result;
+  }
+  else if(lists.size() == 1)
+  {
+    return lists[0];
+  }
+
+  std::vector<std::vector<nodeid_t>::const_iterator> its;
+  for(const auto& l : lists)
+  {
+    if(l.empty())
+    {
+      return result;
+    }
+    its.push_back(l.begin());
+  }
+
+  nodeid_t maxValue = *its[0];
+  for(const auto& it : its)
+  {
+    maxValue = std::max(maxValue, *it);
+  }
+
+  size_t numOfAgreeing = 0;
+  size_t current = 0;
+  while(true)
+  {
+    its[current] = std::lower_bound(its[current], lists[current].end(), maxValue);
+    if(its[current] == lists[current].end())
+    {
+      return result;
+    }
+    if(*its[current] == maxValue)
+    {
+      numOfAgreeing++;
+      if(numOfAgreeing == lists.size())
+      {
+        result.push_back(maxValue);
+        // continue with the next value of the current list
+        its[current]++;
+        if(its[current] == lists[current].end())
+        {
+          return result;
+        }
+        maxValue = *its[current];
+        numOfAgreeing = 1;
+      }
+    }
+    else
+    {
+      maxValue = *its[current];
+      numOfAgreeing = 1;
+    }
+    current = (current + 1) % lists.size();
+  }
+}
+
+bool compareMatchNode(const Match& m, nodeid_t n)
+{
+  return m.node < n;
+}
+
+}
+
+MultiwayJoin::MultiwayJoin(std::vector<std::shared_ptr<AnnoIt>> nodes, std::vector<MatchGenerator> matchGenerators,
+                           std::vector<std::uint64_t> estimatedSizes, std::vector<Relation> relations)
+  : nodes(nodes), matchGenerators(matchGenerators), estimatedSizes(estimatedSizes), relations(relations),
+    initialized(false), level(-1)
+{
+  this->matchGenerators.resize(nodes.size());
+  this->estimatedSizes.resize(nodes.size(), 0);
+  planOrder();
+}
+
+bool MultiwayJoin::next(std::vector<Match>& tuple)
+{
+  tuple.clear();
+  if(!initialized)
+  {
+    init();
+  }
+
+  while(level >= 0)
+  {
+    if(candidatePos[level] < candidates[level].size())
+    {
+      binding[order[level]] = candidates[level][candidatePos[level]++];
+      if(static_cast<size_t>(level) + 1 == order.size())
+      {
+        tuple = binding;
+        return true;
+      }
+      level++;
+      findCandidates(level);
+    }
+    else
+    {
+      level--;
+    }
+  }
+  return false;
+}
+
+void MultiwayJoin::init()
+{
+  initialized = true;
+
+  baseMatches.assign(nodes.size(), std::vector<Match>());
+  baseMatchesFetched.assign(nodes.size(), false);
+
+  candidates.resize(nodes.size());
+  candidatePos.resize(nodes.size());
+  binding.resize(nodes.size());
+
+  if(!nodes.empty())
+  {
+    level = 0;
+    findCandidates(0);
+  }
+}
+
+const std::vector<Match>& MultiwayJoin::getBaseMatches(size_t node)
+{
+  if(!baseMatchesFetched[node])
+  {
+    baseMatchesFetched[node] = true;
+    std::vector<Match> tuple;
+    // the output filter of the base search is applied when fetching tuples
+    while(nodes[node] && nodes[node]->next(tuple))
+    {
+      baseMatches[node].push_back(tuple[0]);
+    }
+    std::sort(baseMatches[node].begin(), baseMatches[node].end());
+  }
+  return baseMatches[node];
+}
+
+void MultiwayJoin::planOrder()
+{
+  order.clear();
+  generators.assign(nodes.size(), std::vector<BoundRelation>());
+  filters.assign(nodes.size(), std::vector<BoundRelation>());
+
+  std::vector<bool> bound(nodes.size(), false);
+  while(order.size() < nodes.size())
+  {
+    // prefer the node with the most operators producing its candidates and then the one with the smallest base search
+    size_t best = nodes.size();
+    size_t bestNumOfGenerators = 0;
+    for(size_t i=0; i < nodes.size(); i++)
+    {
+      if(bound[i])
+      {
+        continue;
+      }
+      size_t numOfGenerators = 0;
+      for(const Relation& r : relations)
+      {
+        if((r.lhs != i && r.rhs == i && bound[r.lhs])
+           || (r.lhs == i && r.rhs != i && bound[r.rhs] && r.op->isCommutative()))
+        {
+          numOfGenerators++;
+        }
+      }
+      if(best == nodes.size() || numOfGenerators > bestNumOfGenerators
+         || (numOfGenerators == bestNumOfGenerators && estimatedSizes[i] < estimatedSizes[best]))
+      {
+        best = i;
+        bestNumOfGenerators = numOfGenerators;
+      }
+    }
+
+    const size_t levelIdx = order.size();
+    for(const Relation& r : relations)
+    {
+      if(r.lhs == best && r.rhs == best)
+      {
+        filters[levelIdx].push_back({r.op, best, true});
+      }
+      else if(r.rhs == best && bound[r.lhs])
+      {
+        generators[levelIdx].push_back({r.op, r.lhs, false});
+      }
+      else if(r.lhs == best && bound[r.rhs])
+      {
+        if(r.op->isCommutative())
+        {
+          generators[levelIdx].push_back({r.op, r.rhs, true});
+        }
+        else
+        {
+          filters[levelIdx].push_back({r.op, r.rhs, true});
+        }
+      }
+    }
+
+    bound[best] = true;
+    order.push_back(best);
+  }
+}
+
+void MultiwayJoin::findCandidates(size_t level)
+{
+  candidates[level].clear();
+  candidatePos[level] = 0;
+
+  const size_t n = order[level];
+
+  if(generators[level].empty())
+  {
+    for(const Match& m : getBaseMatches(n))
+    {
+      if(isIncluded(level, m))
+      {
+        candidates[level].push_back(m);
+      }
+    }
+    return;
+  }
+
+  // each operator retrieves the sorted node IDs reachable from the already bound node
+  std::vector<std::vector<nodeid_t>> lists;
+  lists.reserve(generators[level].size() + 1);
+  for(const BoundRelation& g : generators[level])
+  {
+    std::vector<nodeid_t> reachable;
+    std::unique_ptr<AnnoIt> it = g.op->retrieveMatches(binding[g.other]);
+    Match m;
+    while(it && it->next(m))
+    {
+      reachable.push_back(m.node);
+    }
+    std::sort(reachable.begin(), reachable.end());
+    reachable.erase(std::unique(reachable.begin(), reachable.end()), reachable.end());
+    lists.push_back(std::move(reachable));
+  }
+
+  if(matchGenerators[n])
+  {
+    // check the annotations of the few candidates instead of executing the base search
+    for(nodeid_t candidateNode : leapfrogIntersection(lists))
+    {
+      for(const Annotation& anno : matchGenerators[n](candidateNode))
+      {
+        const Match m = {candidateNode, anno};
+        if(isIncluded(level, m))
+        {
+          candidates[level].push_back(m);
+        }
+      }
+    }
+    return;
+  }
+
+  const std::vector<Match>& base = getBaseMatches(n);
+  std::vector<nodeid_t> baseNodes;
+  baseNodes.reserve(base.size());
+  for(const Match& m : base)
+  {
+    if(baseNodes.empty() || baseNodes.back() != m.node)
+    {
+      baseNodes.push_back(m.node);
+    }
+  }
+  lists.push_back(std::move(baseNodes));
+
+  for(nodeid_t candidateNode : leapfrogIntersection(lists))
+  {
+    // there might be several matching annotations for the same node
+    for(auto it = std::lower_bound(base.begin(), base.end(), candidateNode, compareMatchNode);
+        it != base.end() && it->node == candidateNode; it++)
+    {
+      if(isIncluded(level, *it))
+      {
+        candidates[level].push_back(*it);
+      }
+    }
+  }
+}
+
+bool MultiwayJoin::isIncluded(size_t level, const Match& m)
+{
+  for(const BoundRelation& g : generators[level])
+  {
+    const Match& other = binding[g.other];
+    // do not include the same match if not reflexive
+    if(!g.op->isReflexive() && other.node == m.node && checkAnnotationKeyEqual(other.anno, m.anno))
+    {
+      return false;
+    }
+  }
+  for(const BoundRelation& f : filters[level])
+  {
+    const Match& other = f.other == order[level] ? m : binding[f.other];
+    if(!f.op->isReflexive() && f.other != order[level]
+       && other.node == m.node && checkAnnotationKeyEqual(other.anno, m.anno))
+    {
+      return false;
+    }
+    if(!(f.isLHS ? f.op->filter(m, other) : f.op->filter(other, m)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MultiwayJoin::reset()
+{
+  if(initialized && !nodes.empty())
+  {
+    // the fetched base matches are kept, only the first level is started again
+    level = 0;
+    findCandidates(0);
+  }
+}
+
+MultiwayJoin::~MultiwayJoin()
+{
+
+}
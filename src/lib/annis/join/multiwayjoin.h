@@ -0,0 +1,129 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/iterators.h>  // for Iterator, AnnoIt
+#include <annis/types.h>      // for Match, nodeid_t
+#include <stddef.h>           // for size_t
+#include <cstdint>            // for uint64_t
+#include <functional>         // for function
+#include <list>               // for list
+#include <memory>             // for shared_ptr
+#include <vector>             // for vector
+
+namespace annis { class Operator; }
+
+
+namespace annis
+{
+
+  /**
+   * A worst-case optimal join of several nodes connected by several operators (e.g. a cycle in the query graph).
+   *
+   * Instead of joining two inputs at a time, the nodes are bound one after another (similar to a leapfrog triejoin).
+   * The candidates for the next node are the intersection of the sorted node ID lists which the operators
+   * retrieve from each already bound node. The annotations of each candidate are checked with the match generator
+   * of the node (see Plan::createSearchFilter()), so the base search of a node is only executed if there is no
+   * operator which produces its candidates (e.g. for the first node) or if it has no match generator.
+   * Operators which can't retrieve the candidates in this direction are used as filter.
+   *
+   * The columns of the result tuples are in the same order as the given nodes.
+   */
+  class MultiwayJoin : public Iterator
+  {
+  public:
+    struct Relation
+    {
+      std::shared_ptr<Operator> op;
+      /** Index of the left operand in the nodes of this join */
+      size_t lhs;
+      /** Index of the right operand in the nodes of this join */
+      size_t rhs;
+    };
+
+    using MatchGenerator = std::function<std::list<Annotation>(nodeid_t)>;
+
+    /**
+     * @param nodes The base search of each node.
+     * @param matchGenerators Returns the matching annotations of a node ID for each base search, might be empty.
+     * @param estimatedSizes The estimated number of matches of each base search, used to plan the binding order.
+     * @param relations The operators between the nodes.
+     */
+    MultiwayJoin(std::vector<std::shared_ptr<AnnoIt>> nodes, std::vector<MatchGenerator> matchGenerators,
+                 std::vector<std::uint64_t> estimatedSizes, std::vector<Relation> relations);
+    virtual ~MultiwayJoin();
+
+    virtual bool next(std::vector<Match>& tuple) override;
+    virtual void reset() override;
+
+    /**
+     * @brief The order in which the nodes are bound.
+     */
+    const std::vector<size_t>& getOrder() const
+    {
+      return order;
+    }
+
+    /**
+     * @brief True if the candidates of the node at this position of the order are produced by an operator.
+     */
+    bool hasGenerator(size_t level) const
+    {
+      return !generators[level].empty();
+    }
+  private:
+    struct BoundRelation
+    {
+      std::shared_ptr<Operator> op;
+      /** The already bound node */
+      size_t other;
+      /** True if the node which is bound at this level is the left operand */
+      bool isLHS;
+    };
+
+    std::vector<std::shared_ptr<AnnoIt>> nodes;
+    std::vector<MatchGenerator> matchGenerators;
+    std::vector<std::uint64_t> estimatedSizes;
+    std::vector<Relation> relations;
+
+    bool initialized;
+    /** The order in which the nodes are bound */
+    std::vector<size_t> order;
+    /** Operators which produce the candidates for each level */
+    std::vector<std::vector<BoundRelation>> generators;
+    /** Operators which are only checked for each candidate of a level */
+    std::vector<std::vector<BoundRelation>> filters;
+
+    /** All matches of a base search sorted by the node ID, only fetched for the nodes which need them */
+    std::vector<std::vector<Match>> baseMatches;
+    std::vector<bool> baseMatchesFetched;
+
+    std::vector<std::vector<Match>> candidates;
+    std::vector<size_t> candidatePos;
+    std::vector<Match> binding;
+    /** Current level, the join is finished if it is negative */
+    int level;
+  private:
+    void init();
+    void planOrder();
+    const std::vector<Match>& getBaseMatches(size_t node);
+    void findCandidates(size_t level);
+    bool isIncluded(size_t level, const Match& m);
+  };
+
+
+} // end namespace annis
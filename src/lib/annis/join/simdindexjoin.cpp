@@ -29,72 +29,76 @@ using namespace annis;
 
 SIMDIndexJoin::SIMDIndexJoin(std::shared_ptr<Iterator> lhs, size_t lhsIdx,
                              std::shared_ptr<Operator> op,
-                             const AnnoStorage<nodeid_t>& annos,
+                             const NodeAnnoStorage& annos,
                              Annotation rhsAnnoToFind, boost::optional<Annotation> constAnno)
-  : lhs(lhs), lhsIdx(lhsIdx), op(op), annos(annos), rhsAnnoToFind(rhsAnnoToFind), constAnno(constAnno)
+  : lhs(lhs), lhsIdx(lhsIdx), op(op), annos(annos), rhsAnnoToFind(rhsAnnoToFind), constAnno(constAnno),
+    lhsRow(0)
 {
 }
 
-bool SIMDIndexJoin::next(std::vector<Match> &tuple)
+bool SIMDIndexJoin::nextBatch(MatchBatch& batch)
 {
-  tuple.clear();
+  batch.clear();
 
+  const Annotation& rhsAnno = constAnno ? *constAnno : rhsAnnoToFind;
   do
   {
-    while(!matchBuffer.empty())
+    while(!matchBuffer.empty() && !batch.full())
     {
-      const nodeid_t& n = matchBuffer.front();
-
-      tuple.reserve(currentLHS.size()+1);
-      tuple.insert(tuple.begin(), currentLHS.begin(), currentLHS.end());
-      if(constAnno)
-      {
-        tuple.push_back({n, *constAnno});
-      }
-      else
-      {
-        tuple.push_back({n, rhsAnnoToFind});
-      }
-
+      batch.add(lhsBatch, lhsRow, {matchBuffer.front(), rhsAnno});
       matchBuffer.pop_front();
-      return true;
-
     }
-  } while (fillMatchBuffer());
+  } while (!batch.full() && fillMatchBuffer());
 
-  return false;
+  return !batch.empty();
 }
 
 void SIMDIndexJoin::reset()
 {
+  BatchIterator::reset();
+
   if(lhs)
   {
     lhs->reset();
   }
 
   matchBuffer.clear();
+  lhsBatch.clear();
+  lhsRow = 0;
+}
+
+bool SIMDIndexJoin::nextLeftMatch()
+{
+  lhsRow++;
+  if(lhsRow >= lhsBatch.size())
+  {
+    lhsRow = 0;
+    return lhs->nextBatch(lhsBatch);
+  }
+  return true;
 }
 
 bool SIMDIndexJoin::fillMatchBuffer()
 {
   Vc::uint32_v valueTemplate = rhsAnnoToFind.val;
 
-  while(matchBuffer.empty() && lhs->next(currentLHS))
+  while(matchBuffer.empty() && nextLeftMatch())
   {
-    Vc::uint32_v v_lhsNode = currentLHS[lhsIdx].node;
+    const Match& currentLHS = lhsBatch.get(lhsRow, lhsIdx);
+    Vc::uint32_v v_lhsNode = currentLHS.node;
 
-    std::unique_ptr<AnnoIt> reachableNodesIt = op->retrieveMatches(currentLHS[lhsIdx]);
+    std::unique_ptr<AnnoIt> reachableNodesIt = op->retrieveMatches(currentLHS);
     if(reachableNodesIt)
     {
       const bool skipReflexitivityCheck =
           constAnno ? (
             op->isReflexive()
-            || constAnno->ns != currentLHS[lhsIdx].anno.ns
-            || constAnno->name != currentLHS[lhsIdx].anno.name
+            || constAnno->ns != currentLHS.anno.ns
+            || constAnno->name != currentLHS.anno.name
           ) : (
           op->isReflexive()
-          || rhsAnnoToFind.ns != currentLHS[lhsIdx].anno.ns
-          || rhsAnnoToFind.name != currentLHS[lhsIdx].anno.name
+          || rhsAnnoToFind.ns != currentLHS.anno.ns
+          || rhsAnnoToFind.name != currentLHS.anno.name
         );
 
       annoVals.clear();
@@ -36,7 +36,7 @@ namespace annis { class Operator; }
 namespace annis
 {
 
-class SIMDIndexJoin : public Iterator
+class SIMDIndexJoin : public BatchIterator
 {
 public:
 
@@ -44,10 +44,10 @@ public:
 public:
   SIMDIndexJoin(std::shared_ptr<Iterator> lhs, size_t lhsIdx,
                 std::shared_ptr<Operator> op,
-                const AnnoStorage<nodeid_t>& annos,
+                const NodeAnnoStorage& annos,
                 Annotation rhsAnnoToFind, boost::optional<Annotation> constAnno);
 
-  virtual bool next(std::vector<Match>& tuple) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
   virtual void reset() override;
 
   virtual ~SIMDIndexJoin();
@@ -57,12 +57,14 @@ private:
   const size_t lhsIdx;
 
   std::shared_ptr<Operator> op;
-  const AnnoStorage<nodeid_t>& annos;
+  const NodeAnnoStorage& annos;
   const Annotation rhsAnnoToFind;
   const boost::optional<Annotation> constAnno;
 
   std::list<nodeid_t> matchBuffer;
-  std::vector<Match> currentLHS;
+  MatchBatch lhsBatch;
+  /** Row of the current LHS tuple in the LHS batch */
+  size_t lhsRow;
 
   std::vector<uint32_t, Vc::Allocator<uint32_t>> annoVals;
   std::vector<nodeid_t, Vc::Allocator<uint32_t>> reachableNodes;
@@ -70,6 +72,7 @@ private:
 
 private:
 
+  bool nextLeftMatch();
   bool fillMatchBuffer();
 
   inline void collectResults(Vc::Mask<uint32_t>& v_valid, const size_t& offset)
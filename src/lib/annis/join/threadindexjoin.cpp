@@ -21,8 +21,6 @@
 #include <algorithm>                      // for move
 #include "annis/iterators.h"              // for AnnoIt, Iterator
 #include "annis/types.h"                  // for Match, Annotation, nodeid_t
-#include "annis/util/sharedqueue.h"       // for SharedQueue
-#include "annis/util/threadpool.h"        // for ThreadPool
 
 
 using namespace annis;
@@ -30,114 +28,114 @@ using namespace annis;
 ThreadIndexJoin::ThreadIndexJoin(std::shared_ptr<Iterator> lhs, size_t lhsIdx,
                      std::shared_ptr<Operator> op,
                      std::function<std::list<Annotation>(nodeid_t)> matchGeneratorFunc,
-                     size_t numOfTasks, std::shared_ptr<ThreadPool> threadPool)
-  : lhs(lhs), op(op), runBackgroundThreads(false), activeBackgroundTasks(0), numOfTasks(numOfTasks),
-    threadPool(threadPool)
+                     size_t numOfTasks, std::shared_ptr<ThreadPool> threadPool, size_t morselSize)
+  : lhs(lhs), morselSize(morselSize), lhsMorselsInitialized(false), nextLHSMorsel(0), op(op),
+    lhsIdx(lhsIdx), matchGeneratorFunc(matchGeneratorFunc), operatorIsReflexive(op->isReflexive()),
+    tasks([this](std::shared_ptr<MorselState> state) {processMorsel(state);}, numOfTasks, threadPool)
 {
+}
 
-  results = std::unique_ptr<SharedQueue<std::vector<Match>>>(new SharedQueue<std::vector<Match>>());
-
-  const bool operatorIsReflexive = op->isReflexive();
-  lhsFetchLoop = [this, lhsIdx, matchGeneratorFunc, operatorIsReflexive]() -> void {
-
-    std::vector<Match> currentLHSVector;
+void ThreadIndexJoin::processMorsel(std::shared_ptr<MorselState> state)
+{
+  if(!state)
+  {
+    state = std::make_shared<MorselState>();
+    state->morsel = MatchBatch(morselSize);
+    state->nextRow = 0;
 
-    while(this->runBackgroundThreads && this->nextLHS(currentLHSVector))
+    if(!tasks.isRunning() || !nextLHS(state->morsel))
     {
-      const Match& currentLHS = currentLHSVector[lhsIdx];
+      tasks.finishTask();
+      return;
+    }
+  }
+  else if(!tasks.flushOrPark(state))
+  {
+    // the output of the resumed task still does not fit into the queue
+    return;
+  }
+
+  while(state->nextRow < state->morsel.size() && tasks.isRunning())
+  {
+    const size_t row = state->nextRow++;
+    const Match& currentLHS = state->morsel.get(row, lhsIdx);
 
-      std::unique_ptr<AnnoIt> itRHS = this->op->retrieveMatches(currentLHS);
+    std::unique_ptr<AnnoIt> itRHS = op->retrieveMatches(currentLHS);
 
-      if(itRHS)
+    if(itRHS)
+    {
+      Match rhsCandidateNode;
+      while(itRHS->next(rhsCandidateNode))
       {
-        Match rhsCandidateNode;
-        while(itRHS->next(rhsCandidateNode))
+        std::list<Annotation> rhsAnnos = matchGeneratorFunc(rhsCandidateNode.node);
+        for(Annotation currentRHSAnno : rhsAnnos)
         {
-          std::list<Annotation> rhsAnnos = matchGeneratorFunc(rhsCandidateNode.node);
-          for(Annotation currentRHSAnno : rhsAnnos)
+          // additionally check for reflexivity
+          if((operatorIsReflexive|| currentLHS.node != rhsCandidateNode.node
+                 || !checkAnnotationEqual(currentLHS.anno, currentRHSAnno)))
           {
-            // additionally check for reflexivity
-            if((operatorIsReflexive|| currentLHS.node != rhsCandidateNode.node
-                   || !checkAnnotationEqual(currentLHS.anno, currentRHSAnno)))
+            state->output.add(state->morsel, row, {rhsCandidateNode.node, currentRHSAnno});
+            if(state->output.full())
             {
-              std::vector<Match> tuple;
-              tuple.reserve(currentLHSVector.size()+1);
-              tuple.insert(tuple.end(), currentLHSVector.begin(), currentLHSVector.end());
-              tuple.push_back({rhsCandidateNode.node, currentRHSAnno});
-
-              this->results->push(std::move(tuple));
+              state->pending.emplace_back(std::move(state->output));
+              state->output.clear();
             }
           }
         }
       }
     }
 
+    // the current row is finished, so a parked task can continue with the next row when it is resumed
+    if(!tasks.flushOrPark(state))
     {
-      std::lock_guard<std::mutex> lock(mutex_activeBackgroundTasks);
-      activeBackgroundTasks--;
-
-      if(activeBackgroundTasks == 0)
-      {
-        // if this was the last background task shutdown the queue to message that there are no more results to fetch
-        this->results->shutdown();
-      }
+      return;
+    }
+  }
+  if(!state->output.empty())
+  {
+    state->pending.emplace_back(std::move(state->output));
+    state->output.clear();
+    if(!tasks.flushOrPark(state))
+    {
+      return;
     }
-  };
+  }
+
+  tasks.continueWithNextMorsel();
 }
 
-bool ThreadIndexJoin::next(std::vector<Match>& tuple)
+bool ThreadIndexJoin::nextBatch(MatchBatch& batch)
 {
-  if(!runBackgroundThreads)
+  batch.clear();
+
+  if(!tasks.isRunning())
   {
+    if(!lhsMorselsInitialized)
     {
-      runBackgroundThreads = true;
-      // Make sure activeBackgroundTasks is correct before actually running all the threads.
-      // Thus if a thread immediatly returns since there is no result only the very last
-      // thread will trigger a shutdown.
-      {
-        std::lock_guard<std::mutex> lock(mutex_activeBackgroundTasks);
-        activeBackgroundTasks = numOfTasks;
-      }
-
-      if(!threadPool)
+      std::shared_ptr<EstimatedSearch> lhsSearch = std::dynamic_pointer_cast<EstimatedSearch>(lhs);
+      if(lhsSearch)
       {
-        threadPool = std::make_shared<ThreadPool>(numOfTasks);
-      }
-
-      for(size_t i=0; i < numOfTasks; i++)
-      {
-        taskList.emplace_back(threadPool->enqueue(lhsFetchLoop));
+        lhsMorsels = lhsSearch->createMorsels(morselSize);
       }
+      lhsMorselsInitialized = true;
     }
-  }
-
 
+    tasks.start();
+  }
 
-  //  wait for next item in queue or return immediatly if queue was shutdown
-  return results->pop(tuple);
+  return tasks.pop(batch);
 }
 
 void ThreadIndexJoin::reset()
 {
-  runBackgroundThreads = false;
-
-  for(auto& t : taskList)
-  {
-    t.wait();
-  }
+  tasks.stop();
 
+  BatchIterator::reset();
   lhs->reset();
-
-  results = std::unique_ptr<SharedQueue<std::vector<Match>>>(new SharedQueue<std::vector<Match>>());
+  nextLHSMorsel = 0;
 }
 
 ThreadIndexJoin::~ThreadIndexJoin()
 {
-  runBackgroundThreads = false;
-
-  for(auto& t : taskList)
-  {
-    t.wait();
-  }
+  tasks.stop();
 }
-
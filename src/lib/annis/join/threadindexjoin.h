@@ -16,25 +16,33 @@
 
 #pragma once
 
+#include <annis/annosearch/estimatedsearch.h>  // for EstimatedSearch
 #include <annis/iterators.h>  // for Iterator
 #include <annis/types.h>      // for Match, nodeid_t
+#include <annis/util/morseltasks.h>  // for MorselTasks, MorselTaskState
 #include <stddef.h>           // for size_t
-#include <atomic>             // for atomic_bool
-#include <deque>              // for deque
+#include <atomic>             // for atomic
 #include <functional>         // for function
-#include <future>             // for future
 #include <list>               // for list
-#include <memory>             // for shared_ptr, __shared_ptr, unique_ptr
+#include <memory>             // for shared_ptr, __shared_ptr
 #include <mutex>              // for mutex, lock_guard
 #include <vector>             // for vector
 namespace annis { class Operator; }  // lines 36-36
 namespace annis { class ThreadPool; }
-namespace annis { template <typename T> class SharedQueue; }
 
 namespace annis
 {
 
-class ThreadIndexJoin : public Iterator
+/**
+ * @brief An index join which processes the LHS in parallel.
+ *
+ * The LHS is split into small morsels. Each morsel is processed by a single task of the thread pool, which
+ * enqueues a task for the next morsel when it is finished. If the LHS is a base search which can be split into
+ * morsels (EstimatedSearch::createMorsels()) the tasks claim these morsels without locking the LHS.
+ * The tasks are executed by MorselTasks, which parks a task with its partially processed morsel if the consumer
+ * is too slow.
+ */
+class ThreadIndexJoin : public BatchIterator
 {
 public:
   struct MatchPair
@@ -49,9 +57,10 @@ public:
             std::shared_ptr<Operator> op,
             std::function<std::list<Annotation>(nodeid_t)> matchGeneratorFunc,
             size_t numOfTasks = 1,
-            std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>());
+            std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>(),
+            size_t morselSize = MatchBatch::defaultCapacity);
 
-  virtual bool next(std::vector<Match>& tuple) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
   virtual void reset() override;
 
   virtual ~ThreadIndexJoin();
@@ -59,29 +68,53 @@ private:
 
   std::shared_ptr<Iterator> lhs;
   std::mutex mutex_lhs;
+  const size_t morselSize;
 
-  std::shared_ptr<Operator> op;
-
+  bool lhsMorselsInitialized;
+  std::vector<EstimatedSearch::Morsel> lhsMorsels;
+  std::atomic<size_t> nextLHSMorsel;
 
+  std::shared_ptr<Operator> op;
 
-  std::atomic_bool runBackgroundThreads;
-  size_t activeBackgroundTasks;
-  std::mutex mutex_activeBackgroundTasks;
-  const size_t numOfTasks;
-  std::shared_ptr<ThreadPool> threadPool;
+  const size_t lhsIdx;
+  std::function<std::list<Annotation>(nodeid_t)> matchGeneratorFunc;
+  const bool operatorIsReflexive;
 
-  std::unique_ptr<SharedQueue<std::vector<Match>>> results;
-  std::function<void()> lhsFetchLoop;
+  /** A morsel which is only partially processed */
+  struct MorselState : public MorselTaskState
+  {
+    MatchBatch morsel;
+    size_t nextRow;
+    /** The batch which is currently filled */
+    MatchBatch output;
+  };
 
-  std::deque<std::future<void>> taskList;
+  MorselTasks<MorselState> tasks;
 
 private:
-  bool nextLHS(std::vector<Match>& tuple)
+  bool nextLHS(MatchBatch& morsel)
   {
-    std::lock_guard<std::mutex> lock(mutex_lhs);
-    return lhs->next(tuple);
+    if(lhsMorsels.empty())
+    {
+      std::lock_guard<std::mutex> lock(mutex_lhs);
+      return lhs->nextBatch(morsel);
+    }
+
+    // each task claims its own morsel, skip the ones where the filter did not leave any match
+    for(size_t idx = nextLHSMorsel++; idx < lhsMorsels.size(); idx = nextLHSMorsel++)
+    {
+      morsel.clear();
+      lhsMorsels[idx](morsel);
+      if(!morsel.empty())
+      {
+        return true;
+      }
+    }
+    return false;
   }
 
+  void processMorsel(std::shared_ptr<MorselState> state);
+
 };
 }
 
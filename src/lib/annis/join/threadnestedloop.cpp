@@ -21,13 +21,16 @@
 #include <algorithm>                      // for move
 #include "annis/iterators.h"              // for Iterator
 #include "annis/types.h"                  // for Match
-#include "annis/util/sharedqueue.h"       // for SharedQueue
-#include "annis/util/threadpool.h"        // for ThreadPool
-
 
 
 using namespace annis;
 
+namespace
+{
+  /** Number of combinations of outer and inner tuples which are checked by a single task */
+  const size_t morselSize = 256;
+}
+
 ThreadNestedLoop::ThreadNestedLoop(std::shared_ptr<Operator> op,
                                    std::shared_ptr<Iterator> lhs,
                                    std::shared_ptr<Iterator> rhs,
@@ -35,117 +38,128 @@ ThreadNestedLoop::ThreadNestedLoop(std::shared_ptr<Operator> op,
                                    size_t numOfTasks, std::shared_ptr<ThreadPool> threadPool)
   : op(op), outer(leftIsOuter ? lhs : rhs), firstOuterFinished(false),
     inner(leftIsOuter ? rhs : lhs), leftIsOuter(leftIsOuter),
-    runBackgroundThreads(false), activeBackgroundTasks(0), numOfTasks(numOfTasks),
-    threadPool(threadPool),
-    initialized(false)
+    outerIdx(leftIsOuter ? lhsIdx : rhsIdx), innerIdx(leftIsOuter ? rhsIdx : lhsIdx),
+    operatorIsReflexive(op->isReflexive()),
+    initialized(false),
+    tasks([this](std::shared_ptr<MorselTaskState> state) {processMorsel(state);}, numOfTasks, threadPool)
 {
+}
 
-  results = std::unique_ptr<SharedQueue<std::vector<Match>>>(new SharedQueue<std::vector<Match>>());
+void ThreadNestedLoop::processMorsel(std::shared_ptr<MorselTaskState> state)
+{
+  if(state)
+  {
+    // a resumed task only has to add its output to the queue before it continues with the next morsel
+    if(tasks.flushOrPark(state))
+    {
+      tasks.continueWithNextMorsel();
+    }
+    return;
+  }
 
-  const bool operatorIsReflexive = op->isReflexive();
+  std::vector<std::vector<Match>> morselOuter;
+  std::vector<std::vector<Match>> morselInner;
 
-  size_t outerIdx = leftIsOuter ? lhsIdx : rhsIdx;
-  size_t innerIdx = leftIsOuter ? rhsIdx : lhsIdx;
+  if(!tasks.isRunning() || !nextMorsel(morselOuter, morselInner))
+  {
+    tasks.finishTask();
+    return;
+  }
 
-  fetchLoop = [this, outerIdx, innerIdx, leftIsOuter, operatorIsReflexive]() -> void
+  MatchBatch output;
+  for(size_t i=0; i < morselOuter.size(); i++)
   {
-    std::vector<Match> matchOuter;
-    std::vector<Match> matchInner;
+    const std::vector<Match>& matchOuter = morselOuter[i];
+    const std::vector<Match>& matchInner = morselInner[i];
+
+    bool include = true;
+    // do not include the same match if not reflexive
+    if(!operatorIsReflexive
+       && matchOuter[outerIdx].node == matchInner[innerIdx].node
+       && checkAnnotationKeyEqual(matchOuter[outerIdx].anno, matchInner[innerIdx].anno)) {
+      include = false;
+    }
 
-    while(this->runBackgroundThreads && this->nextTuple(matchOuter, matchInner))
+    if(include)
     {
-      bool include = true;
-      // do not include the same match if not reflexive
-      if(!operatorIsReflexive
-         && matchOuter[outerIdx].node == matchInner[innerIdx].node
-         && checkAnnotationKeyEqual(matchOuter[outerIdx].anno, matchInner[innerIdx].anno)) {
-        include = false;
-      }
-
-      if(include)
+      if(leftIsOuter)
       {
-        if(leftIsOuter)
+        if(op->filter(matchOuter[outerIdx], matchInner[innerIdx]))
         {
-          if(this->op->filter(matchOuter[outerIdx], matchInner[innerIdx]))
-          {
-            std::vector<Match> resultMatch;
+          std::vector<Match> resultMatch;
 
-            resultMatch.reserve(matchInner.size() + matchOuter.size());
-            // return a tuple where the first values are from the outer relation and the iner relations tuples are added behind
-            resultMatch.insert(resultMatch.end(), matchOuter.begin(), matchOuter.end());
-            resultMatch.insert(resultMatch.end(), matchInner.begin(), matchInner.end());
+          resultMatch.reserve(matchInner.size() + matchOuter.size());
+          // return a tuple where the first values are from the outer relation and the iner relations tuples are added behind
+          resultMatch.insert(resultMatch.end(), matchOuter.begin(), matchOuter.end());
+          resultMatch.insert(resultMatch.end(), matchInner.begin(), matchInner.end());
 
-            this->results->push(std::move(resultMatch));
-          }
+          output.add(resultMatch);
         }
-        else
+      }
+      else
+      {
+        if(op->filter(matchInner[innerIdx], matchOuter[outerIdx]))
         {
-          if(this->op->filter(matchInner[innerIdx], matchOuter[outerIdx]))
-          {
-            std::vector<Match> resultMatch;
+          std::vector<Match> resultMatch;
 
-            resultMatch.reserve(matchInner.size() + matchOuter.size());
-            // return a tuple where the first values are from the inner relation and the outer relations tuples are added behind
-            resultMatch.insert(resultMatch.end(), matchInner.begin(), matchInner.end());
-            resultMatch.insert(resultMatch.end(), matchOuter.begin(), matchOuter.end());
+          resultMatch.reserve(matchInner.size() + matchOuter.size());
+          // return a tuple where the first values are from the inner relation and the outer relations tuples are added behind
+          resultMatch.insert(resultMatch.end(), matchInner.begin(), matchInner.end());
+          resultMatch.insert(resultMatch.end(), matchOuter.begin(), matchOuter.end());
 
-            this->results->push(std::move(resultMatch));
-          }
+          output.add(resultMatch);
         }
       }
-    } // end while outer
+    }
+  } // end for each combination of the morsel
 
+  if(!output.empty())
+  {
+    // the output of a morsel is small, so the whole batch is kept if the task has to be parked
+    state = std::make_shared<MorselTaskState>();
+    state->pending.emplace_back(std::move(output));
+    if(!tasks.flushOrPark(state))
     {
-      std::lock_guard<std::mutex> lock(mutex_activeBackgroundTasks);
-      activeBackgroundTasks--;
-
-      if(activeBackgroundTasks == 0)
-      {
-        // if this was the last background task shutdown the queue to message that there are no more results to fetch
-        this->results->shutdown();
-      }
+      return;
     }
+  }
 
-
-  }; // end fetchLoop function
+  tasks.continueWithNextMorsel();
 }
 
-bool ThreadNestedLoop::next(std::vector<Match>& tuple)
+bool ThreadNestedLoop::nextBatch(MatchBatch& batch)
 {
-  if(!runBackgroundThreads)
+  batch.clear();
+
+  if(!tasks.isRunning())
   {
-    {
-      runBackgroundThreads = true;
-      // Make sure activeBackgroundTasks is correct before actually running all the threads.
-      // Thus if a thread immediatly returns since there is no result only the very last
-      // thread will trigger a shutdown.
-      {
-        std::lock_guard<std::mutex> lock(mutex_activeBackgroundTasks);
-        activeBackgroundTasks = numOfTasks;
-      }
+    tasks.start();
+  }
 
-      if(!threadPool)
-      {
-        threadPool = std::make_shared<ThreadPool>(numOfTasks);
-      }
+  return tasks.pop(batch);
+}
 
-      for(size_t i=0; i < numOfTasks; i++)
-      {
-        taskList.emplace_back(threadPool->enqueue(fetchLoop));
-      }
-    }
-  }
+bool ThreadNestedLoop::nextMorsel(std::vector<std::vector<Match>>& morselOuter,
+                                  std::vector<std::vector<Match>>& morselInner)
+{
+  std::lock_guard<std::mutex> lock(mutex_fetch);
 
+  morselOuter.clear();
+  morselInner.clear();
 
+  std::vector<Match> matchOuter;
+  std::vector<Match> matchInner;
+  while(morselOuter.size() < morselSize && nextTuple(matchOuter, matchInner))
+  {
+    morselOuter.push_back(matchOuter);
+    morselInner.push_back(matchInner);
+  }
 
-  //  wait for next item in queue or return immediatly if queue was shutdown
-  return results->pop(tuple);
+  return !morselOuter.empty();
 }
 
 bool ThreadNestedLoop::nextTuple(std::vector<Match> &matchOuter, std::vector<Match> &matchInner)
 {
-  std::lock_guard<std::mutex> lock(mutex_fetch);
-
   bool proceed = true;
 
   if(!initialized)
@@ -191,13 +205,9 @@ bool ThreadNestedLoop::nextTuple(std::vector<Match> &matchOuter, std::vector<Mat
 
 void ThreadNestedLoop::reset()
 {
-  runBackgroundThreads = false;
+  tasks.stop();
 
-
-  for(auto& t : taskList)
-  {
-    t.wait();
-  }
+  BatchIterator::reset();
 
   inner->reset();
   outer->reset();
@@ -205,19 +215,9 @@ void ThreadNestedLoop::reset()
   itInnerCache = innerCache.begin();
   firstOuterFinished = false;
   initialized = false;
-
-  results = std::unique_ptr<SharedQueue<std::vector<Match>>>(new SharedQueue<std::vector<Match>>());
 }
 
 ThreadNestedLoop::~ThreadNestedLoop()
 {
-  runBackgroundThreads = false;
-
-  for(auto& t : taskList)
-  {
-    t.wait();
-  }
+  tasks.stop();
 }
-
-
-
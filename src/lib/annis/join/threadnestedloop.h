@@ -18,23 +18,26 @@
 
 #include <annis/iterators.h>  // for Iterator
 #include <annis/types.h>      // for Match
+#include <annis/util/morseltasks.h>  // for MorselTasks, MorselTaskState
 #include <stddef.h>           // for size_t
-#include <atomic>             // for atomic_bool
 #include <deque>              // for deque, _Deque_iterator, deque<>::const_...
-#include <functional>         // for function
-#include <future>             // for future
-#include <memory>             // for shared_ptr, __shared_ptr, unique_ptr
+#include <memory>             // for shared_ptr, __shared_ptr
 #include <mutex>              // for mutex
 #include <vector>             // for vector, allocator
 namespace annis { class Operator; }  // lines 36-36
 namespace annis { class ThreadPool; }
-namespace annis { template <typename T> class SharedQueue; }
 
 
 namespace annis
 {
 
-class ThreadNestedLoop : public Iterator
+/**
+ * @brief A nested loop join which checks the combinations of outer and inner tuples in parallel.
+ *
+ * Each task of the thread pool checks a small morsel of combinations. The tasks are executed by MorselTasks,
+ * which parks a task with its output if the consumer is too slow.
+ */
+class ThreadNestedLoop : public BatchIterator
 {
 public:
   struct MatchPair
@@ -53,7 +56,7 @@ public:
             size_t numOfTasks,
             std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>());
 
-  virtual bool next(std::vector<Match>& tuple) override;
+  virtual bool nextBatch(MatchBatch& batch) override;
   virtual void reset() override;
 
   virtual ~ThreadNestedLoop();
@@ -70,25 +73,20 @@ private:
 
 
   const bool leftIsOuter;
-
-  std::atomic_bool runBackgroundThreads;
-  size_t activeBackgroundTasks;
-  std::mutex mutex_activeBackgroundTasks;
-
-  const size_t numOfTasks;
-  std::shared_ptr<ThreadPool> threadPool;
-
-  std::unique_ptr<SharedQueue<std::vector<Match>>> results;
-  std::function<void()> fetchLoop;
-
-  std::deque<std::future<void>> taskList;
+  const size_t outerIdx;
+  const size_t innerIdx;
+  const bool operatorIsReflexive;
 
   std::mutex mutex_fetch;
   bool initialized;
   std::vector<Match> currentOuter;
 
+  MorselTasks<> tasks;
+
 private:
 
+  void processMorsel(std::shared_ptr<MorselTaskState> state);
+  bool nextMorsel(std::vector<std::vector<Match>>& morselOuter, std::vector<std::vector<Match>>& morselInner);
   bool nextTuple(std::vector<Match>& matchOuter, std::vector<Match>& matchInner);
 
   bool fetchNextInner(std::vector<Match>& matchInner)
@@ -120,10 +120,19 @@ std::shared_ptr<Query> JSONQueryParser::parse(const DB& db, DB::GetGSFuncT getGr
       }
     }
 
+    if(config.planCache)
+    {
+      // queries which only differ in their literal values can use the same plan
+      Json::Value shape = alt;
+      std::string literals;
+      extractLiterals(shape, literals);
+      q->setPlanCacheKey(Json::FastWriter().write(shape), literals);
+    }
+
     result.push_back(q);
 
   } // end for each alternative
-  return std::make_shared<Query>(result);
+  return std::make_shared<Query>(result, config);
 }
 
 std::shared_ptr<Query> JSONQueryParser::parseWithUpgradeableLock(DB &db,
@@ -263,14 +272,18 @@ size_t JSONQueryParser::addNodeAnnotation(const DB& db,
         return q->addNode(std::make_shared<RegexAnnoSearch>(db,
           *ns,
           *name,
-          *value),
+          *value,
+          q->getConfig().threadPool,
+          q->getConfig().numOfBackgroundTasks),
           wrapEmptyAnno);
       }
       else
       {
         return q->addNode(std::make_shared<RegexAnnoSearch>(db,
           *name,
-          *value),
+          *value,
+          q->getConfig().threadPool,
+          q->getConfig().numOfBackgroundTasks),
           wrapEmptyAnno);
       }
     }
@@ -475,7 +488,35 @@ bool JSONQueryParser::canReplaceRegex(const std::string& str)
 }
 
 
-JSONQueryParser::~JSONQueryParser()
+void JSONQueryParser::extractLiterals(Json::Value& val, std::string& literals)
 {
+  if(val.isObject())
+  {
+    for(const std::string& name : val.getMemberNames())
+    {
+      Json::Value& member = val[name];
+      if((name == "value" || name == "spannedText") && member.isString())
+      {
+        literals += member.asString();
+        literals += '\0';
+        member = "?";
+      }
+      else
+      {
+        extractLiterals(member, literals);
+      }
+    }
+  }
+  else if(val.isArray())
+  {
+    for(Json::Value& element : val)
+    {
+      extractLiterals(element, literals);
+    }
+  }
 }
 
+
+JSONQueryParser::~JSONQueryParser()
+{
+}
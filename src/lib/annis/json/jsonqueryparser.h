@@ -95,6 +95,12 @@ namespace annis {
     static Annotation getEdgeAnno(const DB& db, const Json::Value& edgeAnno);
     
     static bool canReplaceRegex(const std::string& str);
+
+    /**
+     * @brief Replace all literal annotation values and spanned texts with a placeholder.
+     * @param literals The replaced values are appended to this string.
+     */
+    static void extractLiterals(Json::Value& val, std::string& literals);
     
   };
 
@@ -44,6 +44,13 @@ bool IdenticalCoverage::filter(const Match& lhs, const Match& rhs)
   return lhsTokRange == rhsTokRange;
 }
 
+boost::optional<JoinKey> IdenticalCoverage::joinKey(const Match& m)
+{
+  // the same as in filter(): both nodes must have the same left and right token
+  auto tokRange = tokHelper.leftRightTokenForNode(m.node);
+  return JoinKey(tokRange.first, tokRange.second);
+}
+
 std::unique_ptr<AnnoIt> IdenticalCoverage::retrieveMatches(const Match& lhs)
 { 
   nodeid_t leftToken;
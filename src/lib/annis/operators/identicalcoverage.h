@@ -39,6 +39,9 @@ public:
   virtual bool isReflexive() override {return false;}
   virtual bool isCommutative() override {return true;}
 
+  virtual bool hasJoinKey() override {return true;}
+  virtual boost::optional<JoinKey> joinKey(const Match& m) override;
+
   virtual std::string description() override
   {
     return "_=_";
@@ -19,6 +19,12 @@ public:
   virtual std::string description() override {return "_ident_";}
 
   virtual bool isCommutative() override {return true;}
+
+  virtual bool hasJoinKey() override {return true;}
+  virtual boost::optional<JoinKey> joinKey(const Match& m) override
+  {
+    return JoinKey(m.node, 0);
+  }
 private:
   const Annotation anyNodeAnno;
 };
@@ -40,15 +40,23 @@ Inclusion::Inclusion(const DB &db, DB::GetGSFuncT getGSFunc)
   gsLeftToken = getGSFunc(ComponentType::LEFT_TOKEN, annis_ns, "");
   gsRightToken = getGSFunc(ComponentType::RIGHT_TOKEN, annis_ns, "");
   gsCoverage = getGSFunc(ComponentType::COVERAGE, annis_ns, "");
+  orderIndex = tokHelper.getOrderIndex();
 }
 
 bool Inclusion::filter(const Match &lhs, const Match &rhs)
 {
   auto lhsTokenRange = tokHelper.leftRightTokenForNode(lhs.node);
-  int spanLength = gsOrder->distance({lhsTokenRange.first, lhsTokenRange.second});
-
   auto rhsTokenRange = tokHelper.leftRightTokenForNode(rhs.node);
 
+  if(orderIndex)
+  {
+    int spanLength = orderIndex->distance(lhsTokenRange.first, lhsTokenRange.second);
+    return orderIndex->isConnected(lhsTokenRange.first, rhsTokenRange.first, 0, spanLength)
+        && orderIndex->isConnected(rhsTokenRange.second, lhsTokenRange.second, 0, spanLength);
+  }
+
+  int spanLength = gsOrder->distance({lhsTokenRange.first, lhsTokenRange.second});
+
   if(gsOrder->isConnected({lhsTokenRange.first, rhsTokenRange.first}, 0, spanLength)
      && gsOrder->isConnected({rhsTokenRange.second, lhsTokenRange.second}, 0, spanLength)
     )
@@ -64,6 +72,19 @@ std::unique_ptr<AnnoIt> Inclusion::retrieveMatches(const annis::Match &lhs)
 
   std::unique_ptr<ListWrapper> w = std::unique_ptr<ListWrapper>(new ListWrapper());
 
+  if(orderIndex && orderIndex->contains(lhs.node))
+  {
+    std::vector<nodeid_t> included;
+    if(orderIndex->findIncluded(orderIndex->left(lhs.node), orderIndex->right(lhs.node), included))
+    {
+      for(const auto& n : included)
+      {
+        w->addMatch({n, anyNodeAnno});
+      }
+      return std::move(w);
+    }
+  }
+
   nodeid_t leftToken;
   nodeid_t rightToken;
   int spanLength = 0;
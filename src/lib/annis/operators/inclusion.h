@@ -60,7 +60,8 @@ private:
   Annotation anyNodeAnno;
 
   TokenHelper tokHelper;
-
+  /** Replaces the token ORDERING component if set */
+  std::shared_ptr<const TokenIndex> orderIndex;
 
 };
 } // end namespace annis
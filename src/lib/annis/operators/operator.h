@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <list>
 #include <memory>
+#include <utility>
+
+#include <boost/optional.hpp>
 
 #include <annis/iterators.h>
 
@@ -10,6 +14,16 @@ namespace annis
 {
 
 
+/**
+ * @brief Value of a match which is compared by operators that can be expressed as equality.
+ */
+using JoinKey = std::pair<std::uint64_t, std::uint64_t>;
+
+/**
+ * @brief Group (e.g. the text) and position of a match for operators which compare the distance of positions.
+ */
+using BandKey = std::pair<std::uint64_t, std::int64_t>;
+
 class Operator
 {
 public:
@@ -55,6 +69,40 @@ public:
    * @return 
    */
   virtual bool valid() const {return true;}
+
+  /**
+   * Return true if two matches are connected by this operator if and only if their join keys are equal.
+   * Such an operator can be executed as hash join. Per default this is "false".
+   */
+  virtual bool hasJoinKey() {return false;}
+
+  /**
+   * @brief Get the join key of a match, which is the same for both sides of the operator.
+   * @return Nothing if the match can't be connected to any other match or if the operator has no join key.
+   */
+  virtual boost::optional<JoinKey> joinKey(const Match& /*m*/) {return boost::optional<JoinKey>();}
+
+  /**
+   * Return true if two matches are connected by this operator if and only if their band keys have the same group
+   * and the position of the RHS minus the position of the LHS is inside the range given by band().
+   * Such an operator can be executed as sort-merge band join. Per default this is "false".
+   */
+  virtual bool hasBandKey() {return false;}
+
+  /**
+   * @return Nothing if the match can't be the LHS of any result or if the operator has no band key.
+   */
+  virtual boost::optional<BandKey> bandKeyLHS(const Match& /*m*/) {return boost::optional<BandKey>();}
+
+  /**
+   * @return Nothing if the match can't be the RHS of any result or if the operator has no band key.
+   */
+  virtual boost::optional<BandKey> bandKeyRHS(const Match& /*m*/) {return boost::optional<BandKey>();}
+
+  /**
+   * @brief Minimal and maximal (inclusive) difference between the RHS and LHS positions.
+   */
+  virtual std::pair<std::int64_t, std::int64_t> band() {return {0, 0};}
   
   /**
    * A descripte string of the state of the operator used for debugging.
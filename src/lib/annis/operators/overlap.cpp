@@ -33,12 +33,27 @@ Overlap::Overlap(const DB &db, DB::GetGSFuncT getGraphStorageFunc)
   gsOrder = getGraphStorageFunc(ComponentType::ORDERING, annis_ns, "");
   gsCoverage = getGraphStorageFunc(ComponentType::COVERAGE, annis_ns, "");
   gsInverseCoverage = getGraphStorageFunc(ComponentType::INVERSE_COVERAGE, annis_ns, "");
+  orderIndex = tokHelper.getOrderIndex();
 }
 
 std::unique_ptr<AnnoIt> Overlap::retrieveMatches(const annis::Match &lhs)
 {
   std::unique_ptr<ListWrapper> w = std::unique_ptr<ListWrapper>(new ListWrapper());
 
+  if(orderIndex && orderIndex->contains(lhs.node))
+  {
+    // each node is only contained once in the interval index, no need to check for duplicates
+    std::vector<nodeid_t> overlapping;
+    if(orderIndex->findOverlapping(orderIndex->left(lhs.node), orderIndex->right(lhs.node), overlapping))
+    {
+      for(const auto& n : overlapping)
+      {
+        w->addMatch(Init::initMatch(anyNodeAnno, n));
+      }
+      return std::move(w);
+    }
+  }
+
   btree::btree_set<nodeid_t> uniqueResultSet;
 
   // get covered token of lhs
@@ -89,6 +104,12 @@ bool Overlap::filter(const Match &lhs, const Match &rhs)
   nodeid_t rhsLeftToken = tokHelper.leftTokenForNode(rhs.node);
   nodeid_t rhsRightToken = tokHelper.rightTokenForNode(rhs.node);
 
+  if(orderIndex)
+  {
+    return orderIndex->distance(lhsLeftToken, rhsRightToken) >= 0
+        && orderIndex->distance(rhsLeftToken, lhsRightToken) >= 0;
+  }
+
   if(gsOrder->distance(Init::initEdge(lhsLeftToken, rhsRightToken)) >= 0
      && gsOrder->distance(Init::initEdge(rhsLeftToken, lhsRightToken)) >= 0)
   {
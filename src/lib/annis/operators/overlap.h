@@ -59,5 +59,7 @@ private:
   std::shared_ptr<const ReadableGraphStorage> gsOrder;
   std::shared_ptr<const ReadableGraphStorage> gsCoverage;
   std::shared_ptr<const ReadableGraphStorage> gsInverseCoverage;
+  /** Replaces the token ORDERING component if set */
+  std::shared_ptr<const TokenIndex> orderIndex;
 };
 } // end namespace annis
@@ -30,6 +30,7 @@ using namespace annis;
 
 Precedence::Precedence(const DB &db, DB::GetGSFuncT getGraphStorageFunc, unsigned int minDistance, unsigned int maxDistance)
   : tokHelper(getGraphStorageFunc, db),
+    orderIndex(tokHelper.getOrderIndex()),
     gsOrder(getGraphStorageFunc(ComponentType::ORDERING, annis_ns, "")),
     gsLeft(getGraphStorageFunc(ComponentType::LEFT_TOKEN, annis_ns, "")),
     anyTokAnno(Init::initAnnotation(db.getTokStringID(), 0, db.getNamespaceStringID())),
@@ -100,6 +101,11 @@ bool Precedence::filter(const Match &lhs, const Match &rhs)
   {
     startNode = tokHelper.rightTokenForNode(lhs.node);
     endNode = tokHelper.leftTokenForNode(rhs.node);
+
+    if(orderIndex)
+    {
+      return orderIndex->isConnected(startNode, endNode, minDistance, maxDistance);
+    }
   }
 
   if(gsOrder->isConnected(Init::initEdge(startNode, endNode),
@@ -111,6 +117,34 @@ bool Precedence::filter(const Match &lhs, const Match &rhs)
 
 }
 
+boost::optional<BandKey> Precedence::bandKeyLHS(const Match& m)
+{
+  if(orderIndex)
+  {
+    const nodeid_t startNode = tokHelper.rightTokenForNode(m.node);
+    const nodeid_t text = orderIndex->textOf(startNode);
+    if(text != TokenIndex::noToken)
+    {
+      return BandKey(text, orderIndex->positionOf(startNode));
+    }
+  }
+  return boost::optional<BandKey>();
+}
+
+boost::optional<BandKey> Precedence::bandKeyRHS(const Match& m)
+{
+  if(orderIndex)
+  {
+    const nodeid_t endNode = tokHelper.leftTokenForNode(m.node);
+    const nodeid_t text = orderIndex->textOf(endNode);
+    if(text != TokenIndex::noToken)
+    {
+      return BandKey(text, orderIndex->positionOf(endNode));
+    }
+  }
+  return boost::optional<BandKey>();
+}
+
 std::string Precedence::description() 
 {
   if(minDistance == 1 && maxDistance == 1)
@@ -44,7 +44,16 @@ public:
 
   virtual std::unique_ptr<AnnoIt> retrieveMatches(const Match& lhs) override;
   virtual bool filter(const Match& lhs, const Match& rhs) override;
-  
+
+  /** The token positions can only be used for the default segmentation when the token index has valid positions */
+  virtual bool hasBandKey() override {return orderIndex && !segmentation;}
+  virtual boost::optional<BandKey> bandKeyLHS(const Match& m) override;
+  virtual boost::optional<BandKey> bandKeyRHS(const Match& m) override;
+  virtual std::pair<std::int64_t, std::int64_t> band() override
+  {
+    return {minDistance, maxDistance};
+  }
+
   virtual std::string description() override;
 
   virtual double selectivity() override;
@@ -53,6 +62,8 @@ public:
   virtual ~Precedence();
 private:
   TokenHelper tokHelper;
+  /** Replaces the token ORDERING component if set */
+  std::shared_ptr<const TokenIndex> orderIndex;
   std::shared_ptr<const ReadableGraphStorage> gsOrder;
   std::shared_ptr<const ReadableGraphStorage> gsLeft;
   Annotation anyTokAnno;
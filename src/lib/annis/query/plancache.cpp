@@ -0,0 +1,99 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "plancache.h"
+
+#include <annis/db.h>  // for DB
+
+using namespace annis;
+
+PlanCache::PlanCache(size_t maxEntries)
+  : maxEntries(maxEntries)
+{
+}
+
+PlanCacheKey PlanCache::createKey(const DB& db, size_t numOfBackgroundTasks,
+                                  const std::string& shape, const std::string& literals)
+{
+  return {reinterpret_cast<std::uintptr_t>(&db), db.getCurrentChangeID(), numOfBackgroundTasks, shape, literals};
+}
+
+std::shared_ptr<const CachedPlan> PlanCache::get(const PlanCacheKey& key, bool anyLiterals)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+
+  auto it = entries.lower_bound(key);
+  const bool found = it != entries.end() && !(key < it->first);
+  if(!found)
+  {
+    if(!anyLiterals)
+    {
+      return std::shared_ptr<const CachedPlan>();
+    }
+    // all entries with the same shape are next to each other, use the first one
+    PlanCacheKey shapeKey = key;
+    shapeKey.literals = "";
+    it = entries.lower_bound(shapeKey);
+    if(it == entries.end() || it->first.db != key.db || it->first.changeID != key.changeID
+       || it->first.numOfBackgroundTasks != key.numOfBackgroundTasks || it->first.shape != key.shape)
+    {
+      return std::shared_ptr<const CachedPlan>();
+    }
+  }
+
+  lru.splice(lru.begin(), lru, it->second.itLRU);
+  return it->second.plan;
+}
+
+void PlanCache::put(const PlanCacheKey& key, std::shared_ptr<const CachedPlan> plan)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+
+  auto it = entries.find(key);
+  if(it != entries.end())
+  {
+    it->second.plan = plan;
+    lru.splice(lru.begin(), lru, it->second.itLRU);
+    return;
+  }
+
+  lru.push_front(key);
+  entries[key] = {plan, lru.begin()};
+
+  while(entries.size() > maxEntries)
+  {
+    entries.erase(lru.back());
+    lru.pop_back();
+  }
+}
+
+void PlanCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  entries.clear();
+  lru.clear();
+}
+
+size_t PlanCache::size()
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  return entries.size();
+}
+
+PlanCache::~PlanCache()
+{
+
+}
@@ -0,0 +1,114 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+#include <cstdint>   // for uint64_t, uintptr_t
+#include <list>      // for list
+#include <map>       // for map
+#include <memory>    // for shared_ptr
+#include <mutex>     // for mutex
+#include <string>    // for string
+#include <tuple>     // for tie
+#include <vector>    // for vector
+
+namespace annis { class DB; }
+
+namespace annis
+{
+
+  /**
+   * @brief The decisions of the optimizer for a single alternative.
+   *
+   * These only describe the order and the operand sides of the joins and which joins are executed in parallel.
+   * Any plan created from them returns the same results, even if the literals or the corpus changed.
+   */
+  struct CachedPlan
+  {
+    struct Join
+    {
+      size_t originalOrder;
+      size_t idxLeft;
+      size_t idxRight;
+    };
+
+    std::vector<Join> operators;
+    std::map<size_t, size_t> parallelizationMapping;
+  };
+
+  struct PlanCacheKey
+  {
+    std::uintptr_t db;
+    std::uint64_t changeID;
+    size_t numOfBackgroundTasks;
+    /** The query with all literal values replaced by a placeholder */
+    std::string shape;
+    /** The replaced literal values */
+    std::string literals;
+  };
+
+  inline bool operator<(const struct PlanCacheKey &a, const struct PlanCacheKey &b)
+  {
+    return std::tie(a.db, a.changeID, a.numOfBackgroundTasks, a.shape, a.literals)
+        < std::tie(b.db, b.changeID, b.numOfBackgroundTasks, b.shape, b.literals);
+  }
+
+  /**
+   * @brief Remembers the optimized plans of query alternatives so they don't need to be planned again.
+   *
+   * The entries are valid for a version of a DB. If a query with the same shape but different literals is planned,
+   * the plan of the other literals can be re-used instead (see QueryConfig::planCacheRebindLiterals).
+   * All functions can be called concurrently.
+   */
+  class PlanCache
+  {
+  public:
+    PlanCache(size_t maxEntries = 1000);
+    PlanCache(const PlanCache& orig) = delete;
+
+    static PlanCacheKey createKey(const DB& db, size_t numOfBackgroundTasks,
+                                  const std::string& shape, const std::string& literals);
+
+    /**
+     * @brief Get the plan for this key.
+     * @param anyLiterals If true, return the plan of any query with the same shape when there is none with these literals.
+     * @return An empty pointer if there is no matching plan.
+     */
+    std::shared_ptr<const CachedPlan> get(const PlanCacheKey& key, bool anyLiterals);
+    void put(const PlanCacheKey& key, std::shared_ptr<const CachedPlan> plan);
+
+    void clear();
+    size_t size();
+
+    virtual ~PlanCache();
+
+  private:
+    struct Entry
+    {
+      std::shared_ptr<const CachedPlan> plan;
+      std::list<PlanCacheKey>::iterator itLRU;
+    };
+
+    const size_t maxEntries;
+
+    std::mutex mutex_cache;
+    std::map<PlanCacheKey, Entry> entries;
+    /** The most recently used key is at the front of the list */
+    std::list<PlanCacheKey> lru;
+  };
+
+} // end namespace annis
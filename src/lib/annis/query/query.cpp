@@ -1,26 +1,50 @@
 #include "query.h"
 
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <thread>
 
+#include <annis/util/boundedqueue.h>
 #include <annis/util/plan.h>
+#include <annis/util/threadpool.h>
 
 using namespace  annis;
 
-Query::Query(std::vector<std::shared_ptr<SingleAlternativeQuery>> alternatives)
-  : alternatives(alternatives), proxyMode(alternatives.size() == 1), currentAlternativeIdx(0)
+namespace
 {
+  /** Number of result batches per alternative which can be queued before the tasks have to wait for the consumer */
+  const size_t queuedBatchesPerAlternative = 2;
+  const size_t numOfResultSetShards = 64;
+}
 
+Query::Query(std::vector<std::shared_ptr<SingleAlternativeQuery>> alternatives, const QueryConfig config)
+  : alternatives(alternatives), proxyMode(alternatives.size() == 1), currentAlternativeIdx(0),
+    parallelMode(false), ordered(config.orderedAlternatives), maxActiveAlternatives(0),
+    runBackgroundThreads(false), activeAlternatives(0), nextAlternativeToStart(0), currentBatchPos(0)
+{
+  if(!proxyMode && config.enableParallelAlternatives)
+  {
+    // The alternatives wait for the results of their joins and for free space in the result queues.
+    // They are executed by their own workers, so they never block the workers of a pool which is shared with the joins.
+    const size_t numOfThreads = config.threadPool ? config.threadPool->numOfThreads()
+                                                  : std::max<size_t>(std::thread::hardware_concurrency(), 2);
+    maxActiveAlternatives = std::min<size_t>(alternatives.size(), std::max<size_t>(numOfThreads, 1));
+    parallelMode = maxActiveAlternatives > 0;
+  }
 }
 
 Query::Query(std::shared_ptr<SingleAlternativeQuery> alternative)
-  : proxyMode(true), currentAlternativeIdx(0)
+  : proxyMode(true), currentAlternativeIdx(0),
+    parallelMode(false), ordered(false), maxActiveAlternatives(0),
+    runBackgroundThreads(false), activeAlternatives(0), nextAlternativeToStart(0), currentBatchPos(0)
 {
   alternatives.push_back(alternative);
 }
 
 Query::~Query()
 {
-
+  waitForAlternatives();
 }
 
 bool Query::next()
@@ -30,6 +54,10 @@ bool Query::next()
     // just act as an proxy
     return alternatives[0]->next();
   }
+  else if(parallelMode)
+  {
+    return nextParallel();
+  }
   else
   {
     for(;currentAlternativeIdx < alternatives.size(); currentAlternativeIdx++)
@@ -50,6 +78,192 @@ bool Query::next()
   return false;
 }
 
+bool Query::nextParallel()
+{
+  if(!runBackgroundThreads)
+  {
+    startAlternatives();
+  }
+
+  while(true)
+  {
+    if(currentBatchPos < currentBatch.size())
+    {
+      currentBatch.get(currentBatchPos++, currentResult);
+      // the unordered results have already been filtered by the tasks
+      if(!ordered || uniqueResultSet.insert(currentResult).second)
+      {
+        return true;
+      }
+    }
+    else
+    {
+      currentBatchPos = 0;
+      if(ordered)
+      {
+        // only switch to the next alternative when all results of the current one have been fetched
+        while(currentAlternativeIdx < results.size() && !results[currentAlternativeIdx]->pop(currentBatch))
+        {
+          currentAlternativeIdx++;
+        }
+        if(currentAlternativeIdx >= results.size())
+        {
+          return false;
+        }
+      }
+      else if(!results[0]->pop(currentBatch))
+      {
+        return false;
+      }
+    }
+  }
+}
+
+void Query::startAlternatives()
+{
+  const size_t numOfQueues = ordered ? alternatives.size() : 1;
+  const size_t queueCapacity = queuedBatchesPerAlternative * (ordered ? 1 : maxActiveAlternatives);
+  for(size_t i=0; i < numOfQueues; i++)
+  {
+    results.emplace_back(new BoundedQueue<MatchBatch>(queueCapacity));
+  }
+  if(!ordered)
+  {
+    sharedResultSet = std::unique_ptr<ConcurrentResultSet>(new ConcurrentResultSet(numOfResultSetShards));
+  }
+
+  if(!alternativePool)
+  {
+    alternativePool = std::unique_ptr<ThreadPool>(new ThreadPool(maxActiveAlternatives));
+  }
+
+  runBackgroundThreads = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex_activeAlternatives);
+    activeAlternatives = std::min(maxActiveAlternatives, alternatives.size());
+    nextAlternativeToStart = activeAlternatives;
+  }
+  for(size_t i=0; i < std::min(maxActiveAlternatives, alternatives.size()); i++)
+  {
+    alternativePool->enqueue([this, i]() {this->processAlternative(i);});
+  }
+}
+
+void Query::processAlternative(size_t idx)
+{
+  std::shared_ptr<SingleAlternativeQuery>& alt = alternatives[idx];
+
+  MatchBatch output;
+  bool hasMore = false;
+  while(runBackgroundThreads && !output.full() && (hasMore = (alt && alt->next())))
+  {
+    const std::vector<Match>& tuple = alt->getCurrent();
+    if(ordered || sharedResultSet->insert(tuple))
+    {
+      output.add(tuple);
+    }
+  }
+
+  if(!output.empty())
+  {
+    // this will wait until the consumer has fetched enough results
+    results[ordered ? idx : 0]->push(std::move(output));
+  }
+
+  if(hasMore && runBackgroundThreads)
+  {
+    // give other tasks the chance to run before the next batch is processed
+    alternativePool->enqueue([this, idx]() {this->processAlternative(idx);});
+  }
+  else
+  {
+    finishAlternative(idx);
+  }
+}
+
+void Query::finishAlternative(size_t idx)
+{
+  if(ordered)
+  {
+    results[idx]->shutdown();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_activeAlternatives);
+  if(runBackgroundThreads && nextAlternativeToStart < alternatives.size())
+  {
+    // re-use this slot for the next alternative
+    const size_t nextIdx = nextAlternativeToStart++;
+    alternativePool->enqueue([this, nextIdx]() {this->processAlternative(nextIdx);});
+  }
+  else
+  {
+    activeAlternatives--;
+    if(activeAlternatives == 0)
+    {
+      if(!ordered)
+      {
+        results[0]->shutdown();
+      }
+      cond_activeAlternatives.notify_all();
+    }
+  }
+}
+
+void Query::waitForAlternatives()
+{
+  runBackgroundThreads = false;
+  // tasks which wait for free space in the queues have to be woken up
+  for(auto& r : results)
+  {
+    r->shutdown();
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_activeAlternatives);
+  cond_activeAlternatives.wait(lock, [this] {return activeAlternatives == 0;});
+}
+
+std::uint64_t Query::count()
+{
+  if(proxyMode)
+  {
+    return alternatives[0]->count();
+  }
+
+  // tuples of alternatives with a different number of nodes can never be equal
+  std::map<size_t, size_t> alternativesPerWidth;
+  for(const auto& alt : alternatives)
+  {
+    if(alt)
+    {
+      alternativesPerWidth[alt->getNumOfNodes()]++;
+    }
+  }
+
+  std::uint64_t result = 0;
+  std::unordered_set<std::vector<Match>, MatchVectorHash> overlappingResults;
+  for(const auto& alt : alternatives)
+  {
+    if(alt)
+    {
+      if(alternativesPerWidth[alt->getNumOfNodes()] == 1)
+      {
+        result += alt->count();
+      }
+      else
+      {
+        while(alt->next())
+        {
+          if(overlappingResults.insert(alt->getCurrent()).second)
+          {
+            result++;
+          }
+        }
+      }
+    }
+  }
+  return result;
+}
+
 std::string Query::debugString()
 {
   if(proxyMode)
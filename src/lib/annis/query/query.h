@@ -1,23 +1,48 @@
 #pragma once
 
 #include <annis/query/singlealternativequery.h>
+#include <annis/iterators.h>
+#include <annis/queryconfig.h>
 
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <unordered_set>
 #include <boost/functional/hash.hpp>
 #include <google/btree_set.h>
 
+namespace annis { class ThreadPool; }
+namespace annis { template <typename T> class BoundedQueue; }
+
 namespace annis {
 
 
 class Query
 {
 public:
-  Query(std::vector<std::shared_ptr<SingleAlternativeQuery>> alternatives);
+  /**
+   * @brief Create a query which returns the union of the results of all alternatives.
+   *
+   * If QueryConfig::enableParallelAlternatives is set the alternatives are executed at the same time
+   * by an own thread pool of this query, which is not shared with the joins.
+   */
+  Query(std::vector<std::shared_ptr<SingleAlternativeQuery>> alternatives, const QueryConfig config = QueryConfig());
   Query(std::shared_ptr<SingleAlternativeQuery> alternative);
   virtual ~Query();
 
   bool next();
+
+  /**
+   * @brief Count all unique results.
+   *
+   * Only the results of alternatives which might return the same tuples are materialized for removing the duplicates.
+   * Must not be mixed with next().
+   */
+  std::uint64_t count();
+
   const std::vector<Match>& getCurrent()
   {
     if(proxyMode)
@@ -34,6 +59,13 @@ public:
   std::string debugString();
 private:
 
+  bool nextParallel();
+  void startAlternatives();
+  /** Execute a single alternative until a batch is full and enqueue a task for the next batch. */
+  void processAlternative(size_t idx);
+  void finishAlternative(size_t idx);
+  void waitForAlternatives();
+
   struct MatchVectorHash
   {
     std::size_t operator()(std::vector<Match> const& v) const
@@ -53,6 +85,37 @@ private:
   };
 
 
+  /**
+   * @brief Set of already found results which can be used by several tasks at the same time.
+   *
+   * The set is split into shards which are protected by their own mutex.
+   */
+  class ConcurrentResultSet
+  {
+  public:
+    ConcurrentResultSet(size_t numOfShards) : shards(numOfShards) {}
+
+    /**
+     * @return True if the tuple was not already included in the set.
+     */
+    bool insert(const std::vector<Match>& tuple)
+    {
+      const std::size_t h = MatchVectorHash()(tuple);
+      // don't use the same bits as the hash set of the shard
+      Shard& s = shards[(h ^ (h >> 16)) % shards.size()];
+      std::lock_guard<std::mutex> lock(s.mutex);
+      return s.set.insert(tuple).second;
+    }
+
+  private:
+    struct Shard
+    {
+      std::mutex mutex;
+      std::unordered_set<std::vector<Match>, MatchVectorHash> set;
+    };
+    std::vector<Shard> shards;
+  };
+
 private:
   std::vector<std::shared_ptr<SingleAlternativeQuery>> alternatives;
   const bool proxyMode;
@@ -61,6 +124,28 @@ private:
   std::vector<Match> currentResult;
 
   std::unordered_set<std::vector<Match>, MatchVectorHash> uniqueResultSet;
+
+  /** True if the alternatives are executed in parallel */
+  bool parallelMode;
+  const bool ordered;
+  /** Executes the alternatives, the joins of the alternatives use the pool of the QueryConfig */
+  std::unique_ptr<ThreadPool> alternativePool;
+  /** Maximal number of alternatives which are executed at the same time */
+  size_t maxActiveAlternatives;
+
+  std::atomic_bool runBackgroundThreads;
+  size_t activeAlternatives;
+  size_t nextAlternativeToStart;
+  std::mutex mutex_activeAlternatives;
+  std::condition_variable cond_activeAlternatives;
+
+  /** A single queue for all alternatives or one for each alternative in the ordered mode */
+  std::vector<std::unique_ptr<BoundedQueue<MatchBatch>>> results;
+  /** Used by the tasks to filter duplicates in the unordered mode */
+  std::unique_ptr<ConcurrentResultSet> sharedResultSet;
+
+  MatchBatch currentBatch;
+  size_t currentBatchPos;
 };
 
 
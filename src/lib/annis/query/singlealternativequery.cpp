@@ -17,19 +17,27 @@
 #include "singlealternativequery.h"
 #include <annis/annosearch/estimatedsearch.h>      // for EstimatedSearch
 #include <annis/annosearch/nodebyedgeannosearch.h>  // for NodeByEdgeAnnoSearch
+#include <annis/annosearch/parallelsearch.h>        // for ParallelSearch
 #include <annis/annosearch/exactannokeysearch.h>
 #include <annis/annosearch/regexannosearch.h>
 #include <annis/db.h>                               // for DB
 #include <annis/iterators.h>                        // for AnnoIt
+#include <annis/join/multiwayjoin.h>                // for MultiwayJoin
 #include <annis/operators/abstractedgeoperator.h>   // for AbstractEdgeOperator
 #include <annis/operators/operator.h>               // for Operator
+#include <annis/query/plancache.h>                  // for PlanCache, CachedPlan
+#include <annis/util/materializediterator.h>        // for MaterializedIterator
 #include <annis/wrapper.h>                          // for ConstAnnoWrapper
 #include <stdint.h>                                 // for int64_t
 #include <algorithm>                                // for next_permutation
+#include <bitset>                                   // for bitset
 #include <boost/optional/optional.hpp>              // for optional
 #include <iostream>                                 // for operator<<, basic...
+#include <limits>                                   // for numeric_limits
 #include <list>                                     // for list
 #include <random>                                   // for mt19937, uniform_...
+#include <set>                                      // for set
+#include <unordered_map>                            // for unordered_map
 #include <utility>                                  // for pair
 #include <vector>                                   // for vector
 #include "annis/annostorage.h"                      // for AnnoStorage
@@ -39,8 +47,137 @@
 
 using namespace annis;
 
+namespace
+{
+
+/**
+ * @brief Enumerates all pairs of connected sub-graphs which are connected to each other.
+ *
+ * This is the enumeration of the DPccp algorithm from "Analysis of Two Existing and One New Dynamic Programming
+ * Algorithm for the Generation of Optimal Bushy Join Trees without Cross Products" (Moerkotte and Neumann, 2006).
+ * Each pair is emitted only once and before any pair which contains one of its sub-graphs as part of a larger one.
+ * The nodes must be numbered in breadth-first order, a set of nodes is represented by the bits of an integer.
+ */
+class ConnectedSubgraphEnumerator
+{
+public:
+  ConnectedSubgraphEnumerator(const std::vector<std::uint64_t>& neighbors,
+                              std::function<void(std::uint64_t, std::uint64_t)> emitPair)
+    : neighbors(neighbors), emitPair(emitPair)
+  {
+  }
+
+  void enumerate()
+  {
+    for(size_t i = neighbors.size(); i-- > 0;)
+    {
+      emitCsg(bit(i));
+      enumerateCsgRec(bit(i), lowerOrEqual(i));
+    }
+  }
+
+private:
+  const std::vector<std::uint64_t>& neighbors;
+  std::function<void(std::uint64_t, std::uint64_t)> emitPair;
+
+private:
+
+  static std::uint64_t bit(size_t i)
+  {
+    return std::uint64_t(1) << i;
+  }
+
+  /** All nodes with a number less or equal to i */
+  static std::uint64_t lowerOrEqual(size_t i)
+  {
+    return i >= 63 ? std::numeric_limits<std::uint64_t>::max() : bit(i+1) - 1;
+  }
+
+  static size_t lowest(std::uint64_t s)
+  {
+    size_t i = 0;
+    while(!(s & bit(i)))
+    {
+      i++;
+    }
+    return i;
+  }
+
+  std::uint64_t neighborhood(std::uint64_t s) const
+  {
+    std::uint64_t result = 0;
+    for(size_t i = 0; i < neighbors.size(); i++)
+    {
+      if(s & bit(i))
+      {
+        result |= neighbors[i];
+      }
+    }
+    return result & ~s;
+  }
+
+  /** All non-empty subsets of s, the smaller ones first */
+  static std::vector<std::uint64_t> subsets(std::uint64_t s)
+  {
+    std::vector<std::uint64_t> result;
+    for(std::uint64_t sub = s; sub != 0; sub = (sub - 1) & s)
+    {
+      result.push_back(sub);
+    }
+    std::stable_sort(result.begin(), result.end(), [](std::uint64_t a, std::uint64_t b)
+    {
+      return std::bitset<64>(a).count() < std::bitset<64>(b).count();
+    });
+    return result;
+  }
+
+  void enumerateCsgRec(std::uint64_t s, std::uint64_t excluded)
+  {
+    const std::uint64_t n = neighborhood(s) & ~excluded;
+    const std::vector<std::uint64_t> extensions = subsets(n);
+    for(std::uint64_t sub : extensions)
+    {
+      emitCsg(s | sub);
+    }
+    for(std::uint64_t sub : extensions)
+    {
+      enumerateCsgRec(s | sub, excluded | n);
+    }
+  }
+
+  void emitCsg(std::uint64_t s1)
+  {
+    const std::uint64_t excluded = s1 | lowerOrEqual(lowest(s1));
+    const std::uint64_t n = neighborhood(s1) & ~excluded;
+    for(size_t i = neighbors.size(); i-- > 0;)
+    {
+      if(n & bit(i))
+      {
+        emitPair(s1, bit(i));
+        enumerateCmpRec(s1, bit(i), excluded | (lowerOrEqual(i) & n));
+      }
+    }
+  }
+
+  void enumerateCmpRec(std::uint64_t s1, std::uint64_t s2, std::uint64_t excluded)
+  {
+    const std::uint64_t n = neighborhood(s2) & ~excluded;
+    const std::vector<std::uint64_t> extensions = subsets(n);
+    for(std::uint64_t sub : extensions)
+    {
+      emitPair(s1, s2 | sub);
+    }
+    for(std::uint64_t sub : extensions)
+    {
+      enumerateCmpRec(s1, s2 | sub, excluded | n);
+    }
+  }
+};
+
+}
+
 SingleAlternativeQuery::SingleAlternativeQuery(const DB &db, QueryConfig config)
-  : db(db), config(config)
+  : db(db), config(config), adaptiveReoptimizationChecked(false)
 {
 }
 
@@ -84,6 +221,12 @@ void SingleAlternativeQuery::addOperator(std::shared_ptr<Operator> op, size_t id
   operators.push_back(entry);
 }
 
+void SingleAlternativeQuery::setPlanCacheKey(std::string shape, std::string literals)
+{
+  planCacheShape = shape;
+  planCacheLiterals = literals;
+}
+
 void SingleAlternativeQuery::optimizeOperandOrder()
 {
   if(!bestPlan && db.nodeAnnos.hasStatistics())
@@ -147,6 +290,141 @@ void SingleAlternativeQuery::optimizeEdgeAnnoUsage()
   }
 }
 
+void SingleAlternativeQuery::collectScannedBaseNodes(std::shared_ptr<ExecutionNode> node,
+                                                     std::map<size_t, std::shared_ptr<ExecutionNode>>& scanned)
+{
+  if(!node)
+  {
+    return;
+  }
+  if(node->type == ExecutionNodeType::base)
+  {
+    scanned[node->nodePos.begin()->first] = node;
+  }
+  else if(node->type == ExecutionNodeType::index_join)
+  {
+    // the inner side is never scanned, its matches are retrieved from the operator for each outer match
+    collectScannedBaseNodes(node->lhs, scanned);
+  }
+  else if(node->type == ExecutionNodeType::nested_loop || node->type == ExecutionNodeType::hash_join
+          || node->type == ExecutionNodeType::band_join || node->type == ExecutionNodeType::filter)
+  {
+    collectScannedBaseNodes(node->lhs, scanned);
+    collectScannedBaseNodes(node->rhs, scanned);
+  }
+}
+
+void SingleAlternativeQuery::optimizeSemiJoinReduction()
+{
+  if(!bestPlan || !db.nodeAnnos.hasStatistics())
+  {
+    return;
+  }
+
+  // Only a base search which is completely scanned by the plan profits from the filter, otherwise the
+  // operator would be evaluated twice for the matches of the small side.
+  std::map<size_t, std::shared_ptr<ExecutionNode>> scanned;
+  collectScannedBaseNodes(bestPlan->getRoot(), scanned);
+
+  for(const OperatorEntry& e : operators)
+  {
+    if(!e.op || !e.op->valid() || e.idxLeft == e.idxRight
+       || e.idxLeft >= nodes.size() || e.idxRight >= nodes.size())
+    {
+      continue;
+    }
+    std::shared_ptr<EstimatedSearch> lhs = std::dynamic_pointer_cast<EstimatedSearch>(nodes[e.idxLeft]);
+    std::shared_ptr<EstimatedSearch> rhs = std::dynamic_pointer_cast<EstimatedSearch>(nodes[e.idxRight]);
+    if(!lhs || !rhs)
+    {
+      continue;
+    }
+    std::int64_t estimateLHS = lhs->guessMaxCount();
+    std::int64_t estimateRHS = rhs->guessMaxCount();
+
+    // the operator can only be applied from right to left if the operands can be switched
+    size_t idxSmall = e.idxLeft;
+    size_t idxLarge = e.idxRight;
+    if(e.op->isCommutative() && estimateRHS >= 0 && estimateRHS < estimateLHS)
+    {
+      std::swap(idxSmall, idxLarge);
+      std::swap(estimateLHS, estimateRHS);
+    }
+    auto itScannedLarge = scanned.find(idxLarge);
+    if(itScannedLarge == scanned.end()
+       || estimateLHS < 0 || estimateRHS < 0 || estimateLHS >= estimateRHS
+       || static_cast<size_t>(estimateLHS) > config.semi_join_max_size)
+    {
+      continue;
+    }
+
+    // the small side has to respect the filters which are already known for it
+    std::list<std::function<bool(const Match &)>> smallFilters;
+    auto itFilterRange = filtersByNode.equal_range(idxSmall);
+    for(auto it=itFilterRange.first; it != itFilterRange.second; it++)
+    {
+      smallFilters.push_back(it->second.first);
+    }
+
+    std::shared_ptr<std::vector<nodeid_t>> reachable = std::make_shared<std::vector<nodeid_t>>();
+    size_t numOfSmallMatches = 0;
+    bool aborted = false;
+
+    std::shared_ptr<AnnoIt> small = nodes[idxSmall];
+    Match m;
+    while(!aborted && small->next(m))
+    {
+      bool included = true;
+      for(const auto& f : smallFilters)
+      {
+        if(!f(m))
+        {
+          included = false;
+          break;
+        }
+      }
+      if(!included)
+      {
+        continue;
+      }
+      if(++numOfSmallMatches > config.semi_join_max_size)
+      {
+        // the estimation was wrong and scanning the small side is too expensive
+        aborted = true;
+        break;
+      }
+
+      std::unique_ptr<AnnoIt> connected = e.op->retrieveMatches(m);
+      Match target;
+      while(connected && connected->next(target))
+      {
+        reachable->push_back(target.node);
+      }
+      if(reachable->size() >= static_cast<size_t>(estimateRHS))
+      {
+        // the filter would not remove enough nodes to be worth the effort
+        aborted = true;
+      }
+    }
+    small->reset();
+
+    if(!aborted)
+    {
+      std::sort(reachable->begin(), reachable->end());
+      reachable->erase(std::unique(reachable->begin(), reachable->end()), reachable->end());
+      reachable->shrink_to_fit();
+
+      std::shared_ptr<const std::vector<nodeid_t>> sortedReachable = reachable;
+      addFilter(idxLarge, [sortedReachable](const Match& m) -> bool
+      {
+        return std::binary_search(sortedReachable->begin(), sortedReachable->end(), m.node);
+      }, "semi-join #" + std::to_string(idxSmall+1));
+      // the base search of the existing plan is the same iterator, so the filter is applied to it directly
+      itScannedLarge->second->description = applyNodeFilters(idxLarge);
+    }
+  }
+}
+
 std::shared_ptr<const Plan> SingleAlternativeQuery::getBestPlan()
 {
   if(!bestPlan)
@@ -161,14 +439,59 @@ std::shared_ptr<Plan> SingleAlternativeQuery::createPlan(const std::vector<std::
                                                          const std::vector<OperatorEntry>& operators,
                                                          std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache,
                                                          std::map<size_t, size_t> parallelizationMapping)
+{
+  std::shared_ptr<ExecutionNode> root = createExecutionTree(nodes, std::vector<bool>(), operators, baseEstimateCache,
+                                                            parallelizationMapping);
+  if(!root)
+  {
+    return std::shared_ptr<Plan>();
+  }
+
+  // 4. a query with a single node has no join which could be executed in parallel, split the base search instead
+  if(root->type == ExecutionNodeType::base && config.numOfBackgroundTasks >= 2)
+  {
+    std::shared_ptr<EstimatedSearch> baseSearch = std::dynamic_pointer_cast<EstimatedSearch>(root->join);
+    if(baseSearch)
+    {
+      root->join = std::make_shared<ParallelSearch>(baseSearch, config.morselSize,
+                                                    config.numOfBackgroundTasks, config.threadPool);
+    }
+  }
+
+  return std::make_shared<Plan>(root);
+}
+
+std::shared_ptr<ExecutionNode> SingleAlternativeQuery::createExecutionTree(
+    const std::vector<std::shared_ptr<AnnoIt>>& nodes,
+    const std::vector<bool>& includedNodes,
+    const std::vector<OperatorEntry>& operators,
+    std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache,
+    const std::map<size_t, size_t>& parallelizationMapping)
 {
   std::map<nodeid_t, size_t> node2component;
   std::map<size_t, std::shared_ptr<ExecutionNode>> component2exec;
 
+  if(materializedExec
+     && (includedNodes.empty() || includedNodes[materializedExec->nodePos.begin()->first]))
+  {
+    // the component number might have been changed when this execution node was used in another plan
+    materializedExec->componentNr = materializedExec->nodePos.begin()->first;
+    for(const auto& pos : materializedExec->nodePos)
+    {
+      node2component[pos.first] = materializedExec->componentNr;
+    }
+    component2exec[materializedExec->componentNr] = materializedExec;
+  }
+
   // 1. add all nodes
-  size_t i=0;
-  for(auto& n : nodes)
+  for(size_t i=0; i < nodes.size(); i++)
   {
+    if((!includedNodes.empty() && !includedNodes[i]) || node2component.find(i) != node2component.end())
+    {
+      continue;
+    }
+    const std::shared_ptr<AnnoIt>& n = nodes[i];
+
     std::shared_ptr<ExecutionNode> baseNode = std::make_shared<ExecutionNode>();
     baseNode->type = ExecutionNodeType::base;
     baseNode->nodePos[i] = 0;
@@ -190,28 +513,15 @@ std::shared_ptr<Plan> SingleAlternativeQuery::createPlan(const std::vector<std::
     node2component[i] = i;
     component2exec[i] = baseNode;
 
-    // add additional filters
-    auto itFilterRange = filtersByNode.equal_range(i);
-    std::list<std::function<bool(const Match &)>> filterList;
-    for(auto it=itFilterRange.first; it != itFilterRange.second; it++)
-    {
-      filterList.push_back(it->second.first);
-      // TODO: add description
-    }
-    if(!filterList.empty())
-    {
-      n->setOutputFilter(filterList);
-    }
-
-    i++;
+    baseNode->description = applyNodeFilters(i);
   }
-  const size_t numOfNodes = i;
 
   // 2. add the operators which produce the results
   for(size_t operatorIdx=0; operatorIdx < operators.size(); operatorIdx++)
   {
     auto& e = operators[operatorIdx];
-    if(e.idxLeft < numOfNodes && e.idxRight < numOfNodes)
+    if(node2component.find(e.idxLeft) != node2component.end()
+       && node2component.find(e.idxRight) != node2component.end())
     {
       
       size_t componentLeft = node2component[e.idxLeft];
@@ -252,12 +562,164 @@ std::shared_ptr<Plan> SingleAlternativeQuery::createPlan(const std::vector<std::
       if(firstComponentID && *firstComponentID != e.second)
       {
         std::cerr << "Nodes  are not completly connected, failing" << std::endl;
-        return std::shared_ptr<Plan>();
+        return std::shared_ptr<ExecutionNode>();
       }
     }
   }
-  
-  return std::make_shared<Plan>(component2exec[*firstComponentID]);
+  if(!firstComponentID)
+  {
+    return std::shared_ptr<ExecutionNode>();
+  }
+
+  return component2exec[*firstComponentID];
+}
+
+std::string SingleAlternativeQuery::applyNodeFilters(size_t nodeIdx)
+{
+  // add additional filters
+  auto itFilterRange = filtersByNode.equal_range(nodeIdx);
+  std::list<std::function<bool(const Match &)>> filterList;
+  std::string description;
+  for(auto it=itFilterRange.first; it != itFilterRange.second; it++)
+  {
+    filterList.push_back(it->second.first);
+    if(!it->second.second.empty())
+    {
+      if(!description.empty())
+      {
+        description += ", ";
+      }
+      description += it->second.second;
+    }
+  }
+  if(!filterList.empty())
+  {
+    nodes[nodeIdx]->setOutputFilter(filterList);
+  }
+  return description;
+}
+
+bool SingleAlternativeQuery::hasCycle() const
+{
+  // union-find over the query nodes, an operator between two already connected nodes closes a cycle
+  std::vector<size_t> parent(nodes.size());
+  for(size_t i=0; i < parent.size(); i++)
+  {
+    parent[i] = i;
+  }
+  auto findRoot = [&parent](size_t i) -> size_t
+  {
+    while(parent[i] != i)
+    {
+      i = parent[i] = parent[parent[i]];
+    }
+    return i;
+  };
+
+  std::set<std::pair<size_t, size_t>> connectedPairs;
+  for(const OperatorEntry& e : operators)
+  {
+    if(e.idxLeft >= nodes.size() || e.idxRight >= nodes.size() || e.idxLeft == e.idxRight)
+    {
+      continue;
+    }
+    // several operators between the same nodes are not a cycle, they are only additional filters
+    if(!connectedPairs.insert({std::min(e.idxLeft, e.idxRight), std::max(e.idxLeft, e.idxRight)}).second)
+    {
+      continue;
+    }
+    const size_t rootLeft = findRoot(e.idxLeft);
+    const size_t rootRight = findRoot(e.idxRight);
+    if(rootLeft == rootRight)
+    {
+      return true;
+    }
+    parent[rootLeft] = rootRight;
+  }
+  return false;
+}
+
+std::shared_ptr<Plan> SingleAlternativeQuery::createMultiwayPlan(
+    std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache)
+{
+  std::shared_ptr<ExecutionNode> result = std::make_shared<ExecutionNode>();
+  result->type = ExecutionNodeType::multiway_join;
+  result->componentNr = 0;
+
+  std::vector<MultiwayJoin::MatchGenerator> matchGenerators(nodes.size());
+  std::vector<std::uint64_t> baseOutput(nodes.size());
+  for(size_t i=0; i < nodes.size(); i++)
+  {
+    result->nodePos[i] = i;
+    const std::string filterDescription = applyNodeFilters(i);
+    if(!filterDescription.empty())
+    {
+      result->description += (result->description.empty() ? "" : ", ") + filterDescription;
+    }
+
+    auto itBaseEstimate = baseEstimateCache.find(i);
+    if(itBaseEstimate == baseEstimateCache.end())
+    {
+      std::shared_ptr<ExecutionNode> baseNode = std::make_shared<ExecutionNode>();
+      baseNode->type = ExecutionNodeType::base;
+      baseNode->nodePos[i] = 0;
+      baseNode->join = nodes[i];
+      itBaseEstimate = baseEstimateCache.insert({i, Plan::estimateTupleSize(baseNode)}).first;
+    }
+    baseOutput[i] = itBaseEstimate->second->output;
+
+    std::shared_ptr<EstimatedSearch> search = std::dynamic_pointer_cast<EstimatedSearch>(nodes[i]);
+    if(search)
+    {
+      matchGenerators[i] = Plan::createSearchFilter(db, search);
+    }
+  }
+
+  std::vector<MultiwayJoin::Relation> relations;
+  for(const OperatorEntry& e : operators)
+  {
+    relations.push_back({e.op, e.idxLeft, e.idxRight});
+    if(!result->description.empty())
+    {
+      result->description += ", ";
+    }
+    result->description += "#" + std::to_string(e.idxLeft+1) + " " + e.op->description()
+        + " #" + std::to_string(e.idxRight+1);
+  }
+  std::shared_ptr<MultiwayJoin> join = std::make_shared<MultiwayJoin>(nodes, matchGenerators, baseOutput, relations);
+  result->join = join;
+
+  // Estimate the bindings after each level of the join as the product of the base sizes and the selectivities
+  // of all operators between the already bound nodes. A node with a generating operator only processes the nodes
+  // reachable from the bindings of the previous level, otherwise its whole base search is checked for each binding.
+  long double bindings = 1.0;
+  long double intermediateSum = 0.0;
+  std::vector<bool> bound(nodes.size(), false);
+  for(size_t level=0; level < join->getOrder().size(); level++)
+  {
+    const size_t n = join->getOrder()[level];
+    bound[n] = true;
+
+    long double selectivity = 1.0;
+    long double reachable = 0.0;
+    for(const OperatorEntry& e : operators)
+    {
+      if((e.idxLeft == n && bound[e.idxRight]) || (e.idxRight == n && bound[e.idxLeft]))
+      {
+        const long double opSelectivity = Plan::operatorSelectivity(e.op, baseOutput[e.idxLeft], baseOutput[e.idxRight]);
+        selectivity *= opSelectivity;
+        reachable += opSelectivity * baseOutput[n];
+      }
+    }
+
+    intermediateSum += bindings * (join->hasGenerator(level) ? reachable : (long double) baseOutput[n]);
+    bindings = std::max<long double>(1.0, bindings * baseOutput[n] * selectivity);
+  }
+
+  const std::uint64_t sum = static_cast<std::uint64_t>(intermediateSum);
+  result->estimate = std::make_shared<ExecutionEstimate>(static_cast<std::uint64_t>(bindings), sum, sum);
+
+  return std::make_shared<Plan>(result);
 }
 
 void SingleAlternativeQuery::optimizeUnboundRegex()
@@ -331,48 +793,96 @@ void SingleAlternativeQuery::internalInit()
       optimizeUnboundRegex();
     }
 
-    ////////////////////////////////////////////////////////
-    // make sure all smaller operand are on the left side //
-    ////////////////////////////////////////////////////////
-    if(config.optimize_operand_order)
+    // a join tree would create all paths of a cycle before the closing operator can filter them,
+    // thus a multiway join is considered as alternative to the best join tree
+    const bool considerMultiwayJoin = config.enableMultiwayJoin && config.numOfBackgroundTasks == 0 && hasCycle();
+
+    boost::optional<PlanCacheKey> cacheKey;
+    std::shared_ptr<const CachedPlan> cachedPlan;
+    if(config.planCache && !planCacheShape.empty() && !considerMultiwayJoin)
     {
-      optimizeOperandOrder();
+      cacheKey = PlanCache::createKey(db, config.numOfBackgroundTasks, planCacheShape, planCacheLiterals);
+      cachedPlan = config.planCache->get(*cacheKey, config.planCacheRebindLiterals);
     }
 
-    if(config.optimize_nodeby_edgeanno)
+    if(cachedPlan && applyCachedPlan(*cachedPlan))
     {
-      optimizeEdgeAnnoUsage();
+      // the join order is already known, only the base node searches might need to be replaced
+      if(config.optimize_nodeby_edgeanno)
+      {
+        optimizeEdgeAnnoUsage();
+      }
+      bestPlan = createPlan(nodes, operators, baseEstimateCache, cachedPlan->parallelizationMapping);
     }
-
-    if(config.optimize_join_order && operators.size() > 1)
+    else
     {
-      ////////////////////////////////////
-      // 2. optimize the order of joins //
-      ////////////////////////////////////
-      if(operators.size() <= config.all_permutations_threshold)
+      ////////////////////////////////////////////////////////
+      // make sure all smaller operand are on the left side //
+      ////////////////////////////////////////////////////////
+      if(config.optimize_operand_order)
+      {
+        optimizeOperandOrder();
+      }
+
+      if(config.optimize_nodeby_edgeanno)
       {
-        optimizeJoinOrderAllPermutations(baseEstimateCache);
+        optimizeEdgeAnnoUsage();
       }
+
+      if(config.optimize_join_order && operators.size() > 1)
+      {
+        ////////////////////////////////////
+        // 2. optimize the order of joins //
+        ////////////////////////////////////
+        if(optimizeJoinOrderDP(baseEstimateCache))
+        {
+          // the dynamic programming already created the best plan
+        }
+        else if(operators.size() <= config.all_permutations_threshold)
+        {
+          optimizeJoinOrderAllPermutations(baseEstimateCache);
+        }
+        else
+        {
+          optimizeJoinOrderRandom(baseEstimateCache);
+        }
+
+      } // end optimize join order
       else
       {
-        optimizeJoinOrderRandom(baseEstimateCache);
+        bestPlan = createPlan(nodes, operators, baseEstimateCache);
+        // still get the cost so the estimates are calculated
+        bestPlan->getCost();
       }
-      
-    } // end optimize join order
-    else
-    {
-      bestPlan = createPlan(nodes, operators, baseEstimateCache);
-      // still get the cost so the estimates are calculated
-      bestPlan->getCost();
-    }
 
-    if(config.numOfBackgroundTasks >= 2)
-    {
-      std::map<size_t, size_t> parallelizationMapping = bestPlan->getOptimizedParallelizationMapping(db, config);
-      // recreate the plan with the mapping
-      bestPlan = createPlan(nodes, operators, baseEstimateCache, parallelizationMapping);
-      // still get the cost so the estimates are calculated
-      bestPlan->getCost();
+      std::map<size_t, size_t> parallelizationMapping;
+      if(config.numOfBackgroundTasks >= 2)
+      {
+        parallelizationMapping = bestPlan->getOptimizedParallelizationMapping(db, config);
+        // recreate the plan with the mapping
+        bestPlan = createPlan(nodes, operators, baseEstimateCache, parallelizationMapping);
+        // still get the cost so the estimates are calculated
+        bestPlan->getCost();
+      }
+
+      if(cacheKey && bestPlan)
+      {
+        config.planCache->put(*cacheKey, createCachedPlan(parallelizationMapping));
+      }
+
+      if(considerMultiwayJoin && bestPlan)
+      {
+        std::shared_ptr<Plan> multiwayPlan = createMultiwayPlan(baseEstimateCache);
+        if(multiwayPlan->getCost() < bestPlan->getCost())
+        {
+          bestPlan = multiwayPlan;
+        }
+      }
+
+      if(config.semi_join_reduction)
+      {
+        optimizeSemiJoinReduction();
+      }
     }
   }
   else
@@ -499,6 +1009,391 @@ void SingleAlternativeQuery::optimizeJoinOrderAllPermutations(std::map<size_t, s
 }
 
 
+bool SingleAlternativeQuery::optimizeJoinOrderDP(std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache)
+{
+  const size_t numOfNodes = nodes.size();
+
+  // Each node is a base relation of the join. When re-planning after the first join was executed, all nodes of the
+  // materialized part form a single base relation.
+  std::vector<size_t> relationOf(numOfNodes, numOfNodes);
+  size_t numOfRelations = 0;
+  if(materializedExec)
+  {
+    for(const auto& pos : materializedExec->nodePos)
+    {
+      if(pos.first < numOfNodes)
+      {
+        relationOf[pos.first] = 0;
+      }
+    }
+    numOfRelations = 1;
+  }
+  for(size_t n = 0; n < numOfNodes; n++)
+  {
+    if(relationOf[n] == numOfNodes)
+    {
+      relationOf[n] = numOfRelations++;
+    }
+  }
+  if(numOfRelations < 2 || numOfRelations > std::min<size_t>(config.dp_join_order_max_nodes, 64))
+  {
+    return false;
+  }
+
+  // number the relations in breadth-first order
+  std::vector<std::vector<size_t>> adjacent(numOfRelations);
+  for(const OperatorEntry& e : operators)
+  {
+    if(e.idxLeft < numOfNodes && e.idxRight < numOfNodes && relationOf[e.idxLeft] != relationOf[e.idxRight])
+    {
+      adjacent[relationOf[e.idxLeft]].push_back(relationOf[e.idxRight]);
+      adjacent[relationOf[e.idxRight]].push_back(relationOf[e.idxLeft]);
+    }
+  }
+  std::vector<size_t> bfsOrder = {0};
+  std::vector<size_t> bfsPos(numOfRelations, numOfRelations);
+  bfsPos[0] = 0;
+  for(size_t i = 0; i < bfsOrder.size(); i++)
+  {
+    for(size_t a : adjacent[bfsOrder[i]])
+    {
+      if(bfsPos[a] == numOfRelations)
+      {
+        bfsPos[a] = bfsOrder.size();
+        bfsOrder.push_back(a);
+      }
+    }
+  }
+  if(bfsOrder.size() != numOfRelations)
+  {
+    // not connected, there is no valid plan anyway
+    return false;
+  }
+
+  auto relationSet = [&bfsPos](size_t relation) -> std::uint64_t
+  {
+    return std::uint64_t(1) << bfsPos[relation];
+  };
+  auto nodeSet = [&relationSet, &relationOf](size_t node) -> std::uint64_t
+  {
+    return relationSet(relationOf[node]);
+  };
+
+  std::vector<std::uint64_t> neighbors(numOfRelations, 0);
+  for(size_t r = 0; r < numOfRelations; r++)
+  {
+    for(size_t a : adjacent[r])
+    {
+      neighbors[bfsPos[r]] |= relationSet(a);
+    }
+  }
+
+  // the cheapest operator order for each connected sub-graph
+  struct SubPlan
+  {
+    std::vector<OperatorEntry> operators;
+    double cost;
+  };
+  std::unordered_map<std::uint64_t, SubPlan> bestSubPlans;
+  for(size_t r = 0; r < numOfRelations; r++)
+  {
+    // operators inside a single relation are filters on it
+    SubPlan single = {{}, 0.0};
+    for(const OperatorEntry& e : operators)
+    {
+      if(e.idxLeft < numOfNodes && e.idxRight < numOfNodes
+         && relationOf[e.idxLeft] == r && relationOf[e.idxRight] == r)
+      {
+        single.operators.push_back(e);
+      }
+    }
+    bestSubPlans[relationSet(r)] = single;
+  }
+
+  auto calculateCost = [&](const std::vector<OperatorEntry>& subOperators, std::uint64_t s) -> double
+  {
+    std::vector<bool> included(numOfNodes, false);
+    for(size_t n = 0; n < numOfNodes; n++)
+    {
+      included[n] = (s & nodeSet(n)) != 0;
+    }
+    std::shared_ptr<ExecutionNode> root = createExecutionTree(nodes, included, subOperators, baseEstimateCache,
+                                                              std::map<size_t, size_t>());
+    if(!root)
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    return static_cast<double>(Plan::estimateTupleSize(root)->intermediateSum);
+  };
+
+  ConnectedSubgraphEnumerator enumerator(neighbors, [&](std::uint64_t s1, std::uint64_t s2)
+  {
+    auto itLeft = bestSubPlans.find(s1);
+    auto itRight = bestSubPlans.find(s2);
+    if(itLeft == bestSubPlans.end() || itRight == bestSubPlans.end())
+    {
+      return;
+    }
+
+    std::vector<OperatorEntry> connecting;
+    for(const OperatorEntry& e : operators)
+    {
+      if(e.idxLeft < numOfNodes && e.idxRight < numOfNodes
+         && (((s1 & nodeSet(e.idxLeft)) && (s2 & nodeSet(e.idxRight)))
+             || ((s2 & nodeSet(e.idxLeft)) && (s1 & nodeSet(e.idxRight)))))
+      {
+        connecting.push_back(e);
+      }
+    }
+
+    std::vector<OperatorEntry> subOperators = itLeft->second.operators;
+    subOperators.insert(subOperators.end(), itRight->second.operators.begin(), itRight->second.operators.end());
+    const size_t joinPos = subOperators.size();
+
+    bool foundBetter = false;
+    SubPlan best = {{}, std::numeric_limits<double>::infinity()};
+    auto itBest = bestSubPlans.find(s1 | s2);
+    if(itBest != bestSubPlans.end())
+    {
+      best = itBest->second;
+    }
+
+    // each connecting operator can be used as the join, the other ones are filters
+    for(size_t j = 0; j < connecting.size(); j++)
+    {
+      subOperators.resize(joinPos);
+      subOperators.push_back(connecting[j]);
+      for(size_t k = 0; k < connecting.size(); k++)
+      {
+        if(k != j)
+        {
+          subOperators.push_back(connecting[k]);
+        }
+      }
+
+      for(bool switchOperands : {false, true})
+      {
+        if(switchOperands)
+        {
+          if(!subOperators[joinPos].op || !subOperators[joinPos].op->isCommutative())
+          {
+            break;
+          }
+          std::swap(subOperators[joinPos].idxLeft, subOperators[joinPos].idxRight);
+        }
+        const double cost = calculateCost(subOperators, s1 | s2);
+        if(cost < best.cost)
+        {
+          best = {subOperators, cost};
+          foundBetter = true;
+        }
+      }
+    }
+
+    if(foundBetter)
+    {
+      bestSubPlans[s1 | s2] = best;
+    }
+  });
+  enumerator.enumerate();
+
+  const std::uint64_t allNodes = numOfRelations >= 64 ? std::numeric_limits<std::uint64_t>::max()
+                                                      : (std::uint64_t(1) << numOfRelations) - 1;
+  auto itAll = bestSubPlans.find(allNodes);
+  if(itAll == bestSubPlans.end())
+  {
+    return false;
+  }
+
+  std::vector<OperatorEntry> optimizedOperators = itAll->second.operators;
+  for(const OperatorEntry& e : operators)
+  {
+    // keep the operators which don't refer to existing nodes, they are ignored by the plan anyway
+    if(e.idxLeft >= numOfNodes || e.idxRight >= numOfNodes)
+    {
+      optimizedOperators.push_back(e);
+    }
+  }
+
+  std::shared_ptr<Plan> plan = createPlan(nodes, optimizedOperators, baseEstimateCache);
+  if(!plan)
+  {
+    return false;
+  }
+  plan->getCost();
+
+  operators = optimizedOperators;
+  bestPlan = plan;
+  return true;
+}
+
+void SingleAlternativeQuery::reoptimizeWithObservedOutput()
+{
+  adaptiveReoptimizationChecked = true;
+
+  if(!bestPlan || !config.optimize || !config.adaptive_reoptimization || config.numOfBackgroundTasks > 0)
+  {
+    return;
+  }
+
+  // find the first join which only has base nodes as input, prefer the left side since it is executed first
+  std::shared_ptr<ExecutionNode> root = bestPlan->getRoot();
+  std::shared_ptr<ExecutionNode> first = root;
+  while(first)
+  {
+    if(first->lhs && first->lhs->type != ExecutionNodeType::base)
+    {
+      first = first->lhs;
+    }
+    else if(first->rhs && first->rhs->type != ExecutionNodeType::base)
+    {
+      first = first->rhs;
+    }
+    else
+    {
+      break;
+    }
+  }
+  if(!first || first == root || !first->lhs || first->type == ExecutionNodeType::do_nothing)
+  {
+    // there is nothing left to plan after the first join
+    return;
+  }
+
+  const std::uint64_t estimated = Plan::estimateTupleSize(first)->output;
+  const double factor = std::max(config.adaptive_reoptimization_factor, 1.0);
+  const long double upperLimit = static_cast<long double>(estimated) * factor;
+
+  // execute the first join until we know if the estimation was much too small
+  std::shared_ptr<MaterializedIterator> materialized = std::make_shared<MaterializedIterator>(first->join);
+  const std::uint64_t maxObserved = static_cast<std::uint64_t>(
+        std::min(upperLimit + 1.0L, static_cast<long double>(config.adaptive_reoptimization_max_observed)));
+  first->observedOutput = materialized->materialize(maxObserved);
+  first->observationComplete = materialized->isComplete();
+
+  const long double observed = static_cast<long double>(first->observedOutput);
+  const bool tooLarge = observed > upperLimit;
+  const bool tooSmall = first->observationComplete && observed * factor < static_cast<long double>(estimated);
+
+  // replace the already executed part of the plan with its buffered output
+  materializedExec = std::make_shared<ExecutionNode>();
+  materializedExec->type = ExecutionNodeType::materialized;
+  materializedExec->join = materialized;
+  materializedExec->nodePos = first->nodePos;
+  materializedExec->componentNr = first->nodePos.begin()->first;
+  materializedExec->observedOutput = first->observedOutput;
+  materializedExec->observationComplete = first->observationComplete;
+  if(!tooLarge && !tooSmall && !first->observationComplete)
+  {
+    // the observed output is only a part of the results, keep the estimation
+    materializedExec->estimate = std::make_shared<ExecutionEstimate>(estimated, 0, 0);
+  }
+  // show the executed part when debugging the plan
+  materializedExec->lhs = first;
+  materializedExec->description = first->description;
+
+  // all operators of the first join and its children have already been applied
+  std::set<size_t> executedOperators;
+  std::list<std::shared_ptr<ExecutionNode>> toVisit = {first};
+  while(!toVisit.empty())
+  {
+    std::shared_ptr<ExecutionNode> n = toVisit.front();
+    toVisit.pop_front();
+    if(n->type != ExecutionNodeType::base)
+    {
+      executedOperators.insert(n->operatorIdx);
+    }
+    if(n->lhs)
+    {
+      toVisit.push_back(n->lhs);
+    }
+    if(n->rhs)
+    {
+      toVisit.push_back(n->rhs);
+    }
+  }
+  std::vector<OperatorEntry> remainingOperators;
+  for(size_t i = 0; i < operators.size(); i++)
+  {
+    if(executedOperators.find(i) == executedOperators.end())
+    {
+      remainingOperators.push_back(operators[i]);
+    }
+  }
+  operators = remainingOperators;
+
+  std::map<size_t, std::shared_ptr<ExecutionEstimate>> baseEstimateCache;
+  if((tooLarge || tooSmall) && config.optimize_join_order && operators.size() > 1)
+  {
+    if(optimizeJoinOrderDP(baseEstimateCache))
+    {
+      // the materialized part is a base relation of the dynamic programming
+    }
+    else if(operators.size() <= config.all_permutations_threshold)
+    {
+      optimizeJoinOrderAllPermutations(baseEstimateCache);
+    }
+    else
+    {
+      optimizeJoinOrderRandom(baseEstimateCache);
+    }
+  }
+  else
+  {
+    // keep the order of the remaining joins
+    bestPlan = createPlan(nodes, operators, baseEstimateCache);
+  }
+}
+
+bool SingleAlternativeQuery::applyCachedPlan(const CachedPlan& cached)
+{
+  if(cached.operators.size() != operators.size())
+  {
+    return false;
+  }
+
+  std::vector<OperatorEntry> byOriginalOrder = operators;
+  std::sort(byOriginalOrder.begin(), byOriginalOrder.end(), compare_opentry_origorder);
+
+  std::vector<bool> used(operators.size(), false);
+  std::vector<OperatorEntry> cachedOrder;
+  cachedOrder.reserve(operators.size());
+  for(const CachedPlan::Join& j : cached.operators)
+  {
+    if(j.originalOrder >= byOriginalOrder.size() || used[j.originalOrder])
+    {
+      return false;
+    }
+    OperatorEntry e = byOriginalOrder[j.originalOrder];
+    // the operands can only be switched for commutative operators
+    const bool sameSides = e.idxLeft == j.idxLeft && e.idxRight == j.idxRight;
+    const bool switchedSides = e.idxLeft == j.idxRight && e.idxRight == j.idxLeft && e.op && e.op->isCommutative();
+    if(!sameSides && !switchedSides)
+    {
+      return false;
+    }
+    e.idxLeft = j.idxLeft;
+    e.idxRight = j.idxRight;
+    used[j.originalOrder] = true;
+    cachedOrder.push_back(e);
+  }
+
+  operators = cachedOrder;
+  return true;
+}
+
+std::shared_ptr<const CachedPlan> SingleAlternativeQuery::createCachedPlan(
+    const std::map<size_t, size_t>& parallelizationMapping) const
+{
+  std::shared_ptr<CachedPlan> result = std::make_shared<CachedPlan>();
+  for(const OperatorEntry& e : operators)
+  {
+    result->operators.push_back({e.originalOrder, e.idxLeft, e.idxRight});
+  }
+  result->parallelizationMapping = parallelizationMapping;
+  return result;
+}
+
 std::string SingleAlternativeQuery::operatorOrderDebugString(const std::vector<OperatorEntry>& ops)
 {
   std::string result = "";
@@ -525,12 +1420,37 @@ std::string SingleAlternativeQuery::operatorOrderDebugString(const std::vector<O
 
 
 
+std::uint64_t SingleAlternativeQuery::count()
+{
+  if(!bestPlan)
+  {
+    internalInit();
+  }
+  if(!adaptiveReoptimizationChecked)
+  {
+    reoptimizeWithObservedOutput();
+  }
+
+  if(bestPlan)
+  {
+    return bestPlan->count();
+  }
+  else
+  {
+    return 0;
+  }
+}
+
 bool SingleAlternativeQuery::next()
 {
   if(!bestPlan)
   {
     internalInit();
   }
+  if(!adaptiveReoptimizationChecked)
+  {
+    reoptimizeWithObservedOutput();
+  }
   
   if(bestPlan)
   {
@@ -20,6 +20,7 @@
 #include <annis/types.h>        // for AnnotationKey, Match, nodeid_t
 
 #include <stddef.h>             // for size_t
+#include <cstdint>              // for uint64_t
 #include <map>                  // for map
 #include <memory>               // for shared_ptr
 #include <set>                  // for set
@@ -33,6 +34,8 @@ namespace annis { class DB; }
 namespace annis { class Operator; }
 namespace annis { class Plan; }
 namespace annis { class ExecutionEstimate; }
+namespace annis { struct ExecutionNode; }
+namespace annis { struct CachedPlan; }
 
 namespace annis
 {
@@ -69,11 +72,28 @@ public:
    * @param forceNestedLoop if true a nested loop join is used instead of the default "seed join"
    */
   void addOperator(std::shared_ptr<Operator> op, size_t idxLeft, size_t idxRight, bool forceNestedLoop = false);
+
+  /**
+   * @brief Identify this query for the plan cache of the configuration.
+   * @param shape Description of all nodes and operators without the literal values
+   * @param literals The literal values which are not part of the shape
+   */
+  void setPlanCacheKey(std::string shape, std::string literals);
   
   bool next();
   const std::vector<Match>& getCurrent() { return currentResult;}
+
+  /**
+   * @brief Count all results without creating the result tuples.
+   * Must not be mixed with next().
+   */
+  std::uint64_t count();
+
+  size_t getNumOfNodes() const { return nodes.size(); }
   
   std::shared_ptr<const Plan> getBestPlan();
+
+  const QueryConfig& getConfig() const { return config; }
   
   virtual ~SingleAlternativeQuery();
 
@@ -91,6 +111,13 @@ private:
 
   std::set<AnnotationKey> emptyAnnoKeySet;
 
+  std::string planCacheShape;
+  std::string planCacheLiterals;
+
+  bool adaptiveReoptimizationChecked;
+  /** The already executed part of the plan, its nodes are not joined again when creating a new plan */
+  std::shared_ptr<ExecutionNode> materializedExec;
+
   struct CompareOperatorEntryOrigOrder
   {
 
@@ -107,15 +134,78 @@ private:
                                    const std::vector<OperatorEntry>& operators,
                                    std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache,
                                    std::map<size_t, size_t> parallelizationMapping = std::map<size_t,size_t>());
+
+  /**
+   * @brief Join the execution nodes of the query nodes in the order of the operators.
+   * @param includedNodes Only the query nodes where this is true are used, an empty vector includes all nodes.
+   * @return The root execution node or an empty pointer if the nodes are not connected by the operators.
+   */
+  std::shared_ptr<ExecutionNode> createExecutionTree(const std::vector<std::shared_ptr<AnnoIt>>& nodes,
+                                                     const std::vector<bool>& includedNodes,
+                                                     const std::vector<OperatorEntry>& operators,
+                                                     std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache,
+                                                     const std::map<size_t, size_t>& parallelizationMapping);
+  
+  /**
+   * @brief Set the additional filters of a query node as output filter of its base search.
+   * @return The descriptions of the filters, separated by comma.
+   */
+  std::string applyNodeFilters(size_t nodeIdx);
+
+  /**
+   * @brief True if the operators connect the query nodes in a cycle (ignoring the direction of the operators).
+   */
+  bool hasCycle() const;
+
+  /**
+   * @brief Create a plan which joins all query nodes at once with a worst-case optimal multiway join.
+   *
+   * The estimate follows the binding order of the join and uses the product of the operator selectivities
+   * between the bound nodes, so its cost can be compared with the cost of a join tree.
+   */
+  std::shared_ptr<Plan> createMultiwayPlan(std::map<size_t, std::shared_ptr<ExecutionEstimate>>& baseEstimateCache);
   
   void optimizeUnboundRegex();
 
   void optimizeOperandOrder();
 
   void optimizeEdgeAnnoUsage();
+
+  /**
+   * @brief Add a filter to the larger operand of each operator which only accepts the nodes that are reachable from the smaller one.
+   *
+   * Must be called after the best plan was chosen, only operands which are scanned by this plan are filtered.
+   */
+  void optimizeSemiJoinReduction();
+  /**
+   * @brief Collect the base nodes of the execution tree whose search is scanned completely and not only used as
+   * the inner side of an index join.
+   */
+  static void collectScannedBaseNodes(std::shared_ptr<ExecutionNode> node,
+                                      std::map<size_t, std::shared_ptr<ExecutionNode>>& scanned);
   
   void optimizeJoinOrderRandom(std::map<size_t, std::shared_ptr<ExecutionEstimate> > &baseEstimateCache);
   void optimizeJoinOrderAllPermutations(std::map<size_t, std::shared_ptr<ExecutionEstimate> > &baseEstimateCache);
+  /**
+   * @brief Find the cheapest (possibly bushy) join order with dynamic programming over the connected sub-graphs
+   * of the query (DPccp).
+   *
+   * When re-planning after the first join was executed, its materialized output is a single base relation.
+   * @return False if the query has too many nodes or is not connected.
+   */
+  bool optimizeJoinOrderDP(std::map<size_t, std::shared_ptr<ExecutionEstimate> > &baseEstimateCache);
+
+  /**
+   * @brief Execute the first join of the best plan and plan the remaining joins again if its output was not estimated well.
+   */
+  void reoptimizeWithObservedOutput();
+
+  /**
+   * @brief Use the join order and operand sides of a cached plan.
+   * @return False if the cached plan does not fit the operators of this query.
+   */
+  bool applyCachedPlan(const CachedPlan& cached);
+  std::shared_ptr<const CachedPlan> createCachedPlan(const std::map<size_t, size_t>& parallelizationMapping) const;
 
   void updateComponentForNodes(std::map<nodeid_t, size_t>& node2component, size_t from, size_t to);
   
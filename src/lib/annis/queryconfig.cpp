@@ -24,12 +24,26 @@ annis::QueryConfig::QueryConfig()
     optimize_nodeby_edgeanno(true),
     optimize_join_order(true),
     all_permutations_threshold(6),
+    dp_join_order_max_nodes(16),
+    adaptive_reoptimization(true),
+    adaptive_reoptimization_factor(10.0),
+    adaptive_reoptimization_max_observed(4096),
+    semi_join_reduction(false),
+    semi_join_max_size(10000),
     forceGSImpl(""),
     avoidNestedBySwitch(true),
     numOfBackgroundTasks(0),
     enableThreadIndexJoin(true),
     enableSIMDIndexJoin(false),
-    threadPool(nullptr)
+    enableHashJoin(true),
+    enableBandJoin(true),
+    enableMultiwayJoin(true),
+    threadPool(nullptr),
+    morselSize(1024),
+    enableParallelAlternatives(false),
+    orderedAlternatives(false),
+    planCache(nullptr),
+    planCacheRebindLiterals(true)
 
 {
 
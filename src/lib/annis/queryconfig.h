@@ -27,6 +27,7 @@ namespace annis
 {
 
   class ThreadPool;
+  class PlanCache;
 
   enum class NonParallelJoin {index, seed};
   enum class ParallelJoin {task, thread};
@@ -40,6 +41,27 @@ namespace annis
     bool optimize_nodeby_edgeanno;
     bool optimize_join_order;
     bool all_permutations_threshold;
+    /** Maximal number of query nodes for which the dynamic programming join order optimization is used (at most 64) */
+    size_t dp_join_order_max_nodes;
+    /**
+     * Execute the first join of the plan before the other ones and plan the rest of the query again
+     * if its number of results differs from the estimation by more than the given factor.
+     */
+    bool adaptive_reoptimization;
+    double adaptive_reoptimization_factor;
+    /**
+     * Maximal number of results of the first join which are buffered for the comparison with the estimation.
+     * The buffering delays the first result of the query, so this should be small.
+     */
+    size_t adaptive_reoptimization_max_observed;
+    /**
+     * Filter the nodes of a large operand by the nodes which are reachable from a small operand
+     * before they are joined (semi-join reduction).
+     * Only operands which are scanned by the chosen plan are filtered. Disabled by default until it is benchmarked.
+     */
+    bool semi_join_reduction;
+    /** Maximal estimated and actual number of matches of the small operand */
+    size_t semi_join_max_size;
 
     std::string forceGSImpl;
     bool avoidNestedBySwitch;
@@ -49,7 +71,25 @@ namespace annis
     size_t numOfBackgroundTasks;
     bool enableThreadIndexJoin;
     bool enableSIMDIndexJoin;
+    /** Use a hash join for operators with a join key if it is cheaper than the index or nested loop join */
+    bool enableHashJoin;
+    /** Use a sort-merge band join for operators with a band key if it is cheaper than the index or nested loop join */
+    bool enableBandJoin;
+    /** Join all nodes of a query with a cycle in a single worst-case optimal multiway join instead of a join tree */
+    bool enableMultiwayJoin;
     std::shared_ptr<ThreadPool> threadPool;
+    /** Number of index entries of a base search which are processed by a single task */
+    size_t morselSize;
+
+    /** Execute the alternatives of a disjunctive query at the same time */
+    bool enableParallelAlternatives;
+    /** Return the results of parallel alternatives in the same order as the sequential execution */
+    bool orderedAlternatives;
+
+    /** Re-use the optimized plans of queries with the same shape, no plans are cached if empty */
+    std::shared_ptr<PlanCache> planCache;
+    /** Use a cached plan of the same query with other literal values instead of optimizing again */
+    bool planCacheRebindLiterals;
 
   public:
     QueryConfig();
@@ -0,0 +1,190 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "resultcache.h"
+
+#include <annis/json/json.h>  // for Value, Reader, FastWriter
+#include <algorithm>          // for min
+#include <utility>            // for move
+
+using namespace annis;
+
+ResultCache::ResultCache(std::function<size_t()> maxSizeFunc)
+  : maxSizeFunc(maxSizeFunc), currentSize(0)
+{
+}
+
+std::string ResultCache::canonicalQuery(const std::string& queryAsJSON)
+{
+  Json::Value root;
+  Json::Reader reader;
+  if(!reader.parse(queryAsJSON, root, false))
+  {
+    // still usable as key, but only for exactly the same string
+    return queryAsJSON;
+  }
+  // the members of an object are always written sorted by their name and without any whitespace
+  return Json::FastWriter().write(root);
+}
+
+boost::optional<long long> ResultCache::getCount(const ResultCacheKey& key)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  Entry* entry = findEntry(key);
+  if(entry)
+  {
+    if(entry->count)
+    {
+      return entry->count;
+    }
+    else if(entry->matchesComplete)
+    {
+      return static_cast<long long>(entry->matches.size());
+    }
+  }
+  return boost::optional<long long>();
+}
+
+void ResultCache::putCount(const ResultCacheKey& key, long long count)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  Entry& entry = createEntry(key);
+  entry.count = count;
+  updateSize(entry, key);
+}
+
+bool ResultCache::getMatches(const ResultCacheKey& key, long long offset, long long limit,
+                             std::vector<std::vector<Match>>& result)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  Entry* entry = findEntry(key);
+  if(!entry)
+  {
+    return false;
+  }
+
+  const long long numOfCached = static_cast<long long>(entry->matches.size());
+  const bool coversRange = entry->matchesComplete || (limit > 0 && offset + limit <= numOfCached);
+  if(!coversRange)
+  {
+    return false;
+  }
+
+  result.clear();
+  const long long begin = std::min(offset, numOfCached);
+  const long long end = limit > 0 ? std::min(offset + limit, numOfCached) : numOfCached;
+  if(begin < end)
+  {
+    result.assign(entry->matches.begin() + begin, entry->matches.begin() + end);
+  }
+  return true;
+}
+
+void ResultCache::putMatches(const ResultCacheKey& key, std::vector<std::vector<Match>> matches, bool complete)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  Entry& entry = createEntry(key);
+  if(entry.matchesComplete || entry.matches.size() > matches.size())
+  {
+    // we already know more matches
+    return;
+  }
+  entry.matches = std::move(matches);
+  entry.matchesComplete = complete;
+  updateSize(entry, key);
+}
+
+void ResultCache::invalidate(const std::string& corpus)
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  auto it = entries.lower_bound({corpus, 0, ""});
+  while(it != entries.end() && it->first.corpus == corpus)
+  {
+    currentSize -= it->second.size;
+    lru.erase(it->second.itLRU);
+    it = entries.erase(it);
+  }
+}
+
+void ResultCache::shrink()
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  removeLeastRecentlyUsed();
+}
+
+size_t ResultCache::estimateMemorySize()
+{
+  std::lock_guard<std::mutex> lock(mutex_cache);
+  return currentSize;
+}
+
+ResultCache::Entry* ResultCache::findEntry(const ResultCacheKey& key)
+{
+  auto it = entries.find(key);
+  if(it == entries.end())
+  {
+    return nullptr;
+  }
+  lru.splice(lru.begin(), lru, it->second.itLRU);
+  return &(it->second);
+}
+
+ResultCache::Entry& ResultCache::createEntry(const ResultCacheKey& key)
+{
+  Entry* existing = findEntry(key);
+  if(existing)
+  {
+    return *existing;
+  }
+
+  lru.push_front(key);
+  Entry& entry = entries[key];
+  entry.matchesComplete = false;
+  entry.size = 0;
+  entry.itLRU = lru.begin();
+  return entry;
+}
+
+void ResultCache::updateSize(Entry& entry, const ResultCacheKey& key)
+{
+  size_t newSize = sizeof(Entry) + sizeof(ResultCacheKey) + 2 * key.corpus.capacity() + 2 * key.query.capacity()
+      + entry.matches.capacity() * sizeof(std::vector<Match>);
+  for(const std::vector<Match>& m : entry.matches)
+  {
+    newSize += m.capacity() * sizeof(Match);
+  }
+  currentSize = currentSize - entry.size + newSize;
+  entry.size = newSize;
+
+  removeLeastRecentlyUsed();
+}
+
+void ResultCache::removeLeastRecentlyUsed()
+{
+  const size_t maxSize = maxSizeFunc();
+  while(currentSize > maxSize && !lru.empty())
+  {
+    auto it = entries.find(lru.back());
+    currentSize -= it->second.size;
+    entries.erase(it);
+    lru.pop_back();
+  }
+}
+
+ResultCache::~ResultCache()
+{
+
+}
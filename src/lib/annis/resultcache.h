@@ -0,0 +1,131 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/types.h>       // for Match
+#include <boost/optional.hpp>  // for optional
+#include <stddef.h>            // for size_t
+#include <cstdint>             // for uint64_t
+#include <functional>          // for function
+#include <list>                // for list
+#include <map>                 // for map
+#include <mutex>               // for mutex
+#include <string>              // for string
+#include <tuple>               // for tie
+#include <vector>              // for vector
+
+namespace annis {
+
+  struct ResultCacheKey {
+    std::string corpus;
+    std::uint64_t changeID;
+    /** The query in its canonical form, see ResultCache::canonicalQuery() */
+    std::string query;
+  };
+
+  inline bool operator<(const struct ResultCacheKey &a, const struct ResultCacheKey &b)
+  {
+    return std::tie(a.corpus, a.changeID, a.query) < std::tie(b.corpus, b.changeID, b.query);
+  }
+
+  /**
+   * @brief Caches the number of matches and the matched nodes of queries on a single corpus.
+   *
+   * The entries are valid for the change ID of the corpus they were calculated for. If the size of all
+   * entries exceeds the maximal size the least recently used entries are removed.
+   * All functions can be called concurrently.
+   */
+  class ResultCache
+  {
+  public:
+    /**
+     * @param maxSizeFunc Returns the maximal size in bytes, it is called whenever an entry is added or changed
+     * since the available memory can change between the calls.
+     */
+    ResultCache(std::function<size_t()> maxSizeFunc);
+    ResultCache(const ResultCache& orig) = delete;
+
+    /**
+     * @brief Create a representation of the JSON query which does not depend on formatting or the order of the keys.
+     */
+    static std::string canonicalQuery(const std::string& queryAsJSON);
+
+    /**
+     * @return The number of matches or an empty optional if it is unknown.
+     */
+    boost::optional<long long> getCount(const ResultCacheKey& key);
+    void putCount(const ResultCacheKey& key, long long count);
+
+    /**
+     * @brief Get the matches in the range [offset, offset+limit).
+     * @param limit Maximal number of matches, 0 for all remaining matches.
+     * @return False if the matches of this range are not cached.
+     */
+    bool getMatches(const ResultCacheKey& key, long long offset, long long limit,
+                    std::vector<std::vector<Match>>& result);
+
+    /**
+     * @brief Remember the first matches of a query.
+     * @param complete True if these are all matches of the query.
+     */
+    void putMatches(const ResultCacheKey& key, std::vector<std::vector<Match>> matches, bool complete);
+
+    /**
+     * @brief Remove all entries of a corpus, regardless of their change ID.
+     */
+    void invalidate(const std::string& corpus);
+
+    /**
+     * @brief Remove entries until the cache does not exceed the current maximal size.
+     */
+    void shrink();
+
+    size_t estimateMemorySize();
+
+    virtual ~ResultCache();
+
+  private:
+
+    struct Entry
+    {
+      boost::optional<long long> count;
+      /** The first matches of the query */
+      std::vector<std::vector<Match>> matches;
+      bool matchesComplete;
+
+      size_t size;
+      std::list<ResultCacheKey>::iterator itLRU;
+    };
+
+    std::mutex mutex_cache;
+    std::map<ResultCacheKey, Entry> entries;
+    /** The most recently used key is at the front of the list */
+    std::list<ResultCacheKey> lru;
+
+    std::function<size_t()> maxSizeFunc;
+    size_t currentSize;
+
+  private:
+    /** Find an entry and mark it as used, the caller must hold the lock. */
+    Entry* findEntry(const ResultCacheKey& key);
+    /** Get or create an entry and mark it as used, the caller must hold the lock. */
+    Entry& createEntry(const ResultCacheKey& key);
+    void updateSize(Entry& entry, const ResultCacheKey& key);
+    void removeLeastRecentlyUsed();
+  };
+
+}
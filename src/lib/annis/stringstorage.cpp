@@ -15,107 +15,294 @@
 */
 
 #include "stringstorage.h"
-#include <annis/util/size_estimator.h>  // for element_size
 #include <re2/re2.h>                    // for RE2, RE2::CannedOptions::Quiet
 #include <re2/stringpiece.h>            // for StringPiece
+#include <annis/util/threadpool.h>     // for ThreadPool
+#include <algorithm>                    // for sort, min
+#include <future>                       // for future
 #include <iterator>                     // for reverse_iterator
 
 using namespace annis;
 using namespace std;
 
 StringStorage::StringStorage()
+  : byValue(ValueRefCompare(this))
 {
+  clear();
+}
+
+StringStorage::StringStorage(const StringStorage &orig)
+  : offsets(orig.offsets), arena(orig.arena), byValue(ValueRefCompare(this))
+{
+  rebuildValueIndex();
+}
+
+StringStorage &StringStorage::operator=(const StringStorage &orig)
+{
+  if(this != &orig)
+  {
+    offsets = orig.offsets;
+    arena = orig.arena;
+    rebuildValueIndex();
+  }
+  return *this;
 }
 
 std::unordered_set<std::uint32_t> StringStorage::findRegex(const string &str) const
 {
-  using ItType = btree::btree_map<string, uint32_t>::const_iterator;
   std::unordered_set<std::uint32_t> result;
 
   RE2 re(str, RE2::Quiet);
   if(re.ok())
   {
-    // get the size of the last element so we know how large our prefix needs to be
-    size_t prefixSize = 10;
-    const std::string& lastString = byValue.rbegin()->first;
-    size_t lastStringSize = lastString.size()+1;
-    if(lastStringSize > prefixSize)
-    {
-      prefixSize = lastStringSize;
-    }
+    std::vector<std::uint32_t> ids = findRegexIDs(re);
+    result.insert(ids.begin(), ids.end());
+  }
 
-    std::string minPrefix;
-    std::string maxPrefix;
-    re.PossibleMatchRange(&minPrefix, &maxPrefix, prefixSize);
+  return std::move(result);
+}
 
-    ItType upperBound = byValue.upper_bound(maxPrefix);
+std::vector<uint32_t> StringStorage::findRegexIDs(const RE2 &re, std::shared_ptr<ThreadPool> threadPool, size_t numOfTasks) const
+{
+  std::vector<std::uint32_t> result;
+  if(!re.ok())
+  {
+    return result;
+  }
+
+  std::vector<std::uint32_t> candidates;
+  auto range = regexCandidateRange(re);
+  for(auto it=range.first; it != range.second; it++)
+  {
+    candidates.push_back(it->id);
+  }
 
-    for(ItType it=byValue.lower_bound(minPrefix);
-        it != upperBound; it++)
+  auto matchCandidates = [this, &re, &candidates](size_t begin, size_t end) -> std::vector<std::uint32_t>
+  {
+    std::vector<std::uint32_t> matching;
+    for(size_t i=begin; i < end; i++)
     {
-      if(RE2::FullMatch(it->first, re))
+      boost::string_ref val = strRef(candidates[i]);
+      if(RE2::FullMatch(re2::StringPiece(val.data(), val.size()), re))
       {
-        result.insert(it->second);
+        matching.push_back(candidates[i]);
       }
     }
+    return matching;
+  };
+
+  // only distribute the work if each task has a reasonable amount of strings to check
+  const size_t minCandidatesPerTask = 1024;
+  if(threadPool && numOfTasks > 1 && candidates.size() >= 2*minCandidatesPerTask)
+  {
+    numOfTasks = std::min(numOfTasks, candidates.size() / minCandidatesPerTask);
+    const size_t partSize = (candidates.size() / numOfTasks) + 1;
+
+    std::vector<std::future<std::vector<std::uint32_t>>> parts;
+    for(size_t begin=partSize; begin < candidates.size(); begin += partSize)
+    {
+      parts.push_back(threadPool->enqueue(matchCandidates, begin, std::min(begin + partSize, candidates.size())));
+    }
+    // the first part is matched by the calling thread, which might itself be a worker of the pool
+    result = matchCandidates(0, std::min(partSize, candidates.size()));
+    for(auto& p : parts)
+    {
+      std::vector<std::uint32_t> matching = threadPool->waitFor(p);
+      result.insert(result.end(), matching.begin(), matching.end());
+    }
+  }
+  else
+  {
+    result = matchCandidates(0, candidates.size());
   }
 
-  return std::move(result);
+  std::sort(result.begin(), result.end());
+  return result;
 }
 
-uint32_t StringStorage::add(const string &str)
+size_t StringStorage::countRegexCandidates(const RE2 &re, size_t limit) const
 {
-  typedef btree::btree_map<string, uint32_t>::const_iterator ItType;
-  ItType it = byValue.find(str);
-  if(it == byValue.end())
+  size_t result = 0;
+  if(re.ok())
   {
-    // non-existing
-    uint32_t id = byID.size() + 1; // since 0 is taken as ANY value begin with 1
-    // make sure the ID is really not taken yet
-    while(byID.find(id) != byID.end())
+    auto range = regexCandidateRange(re);
+    for(auto it=range.first; it != range.second && result < limit; it++)
     {
-      id++;
+      result++;
     }
-    byID.insert(pair<uint32_t, string>(id, str));
-    byValue.insert(pair<string, uint32_t>(str, id));
+  }
+  return result;
+}
+
+std::pair<StringStorage::ValueIndex::const_iterator, StringStorage::ValueIndex::const_iterator>
+  StringStorage::regexCandidateRange(const RE2 &re) const
+{
+  if(byValue.empty())
+  {
+    return {byValue.end(), byValue.end()};
+  }
+
+  // get the size of the last element so we know how large our prefix needs to be
+  size_t prefixSize = 10;
+  size_t lastStringSize = resolve(*byValue.rbegin()).size()+1;
+  if(lastStringSize > prefixSize)
+  {
+    prefixSize = lastStringSize;
+  }
+
+  std::string minPrefix;
+  std::string maxPrefix;
+  if(!re.PossibleMatchRange(&minPrefix, &maxPrefix, prefixSize))
+  {
+    // no range could be determined, all strings are candidates
+    return {byValue.begin(), byValue.end()};
+  }
+
+  return {byValue.lower_bound(searchKey(minPrefix)), byValue.upper_bound(searchKey(maxPrefix))};
+}
+
+uint32_t StringStorage::add(const string &str)
+{
+  auto it = byValue.find(searchKey(str));
+  if(it == byValue.end())
+  {
+    // non-existing, IDs are dense and the offset vector always contains the end position of the last ID
+    uint32_t id = offsets.size() - 1;
+
+    std::vector<char>& arenaVec = arena.vec();
+    arenaVec.insert(arenaVec.end(), str.begin(), str.end());
+    arenaVec.push_back('\0');
+    offsets.vec().push_back(arenaVec.size());
+
+    byValue.insert({id, 0, nullptr});
     return id;
   }
   else
   {
     // already existing, return the original ID
-    return it->second;
+    return it->id;
   }
 }
 
 void StringStorage::clear()
 {
-
-  byID.clear();
   byValue.clear();
+  arena.clear();
+  offsets.clear();
 
+  // since 0 is taken as ANY value the first real ID is 1, reserve an empty range for it
+  offsets.vec().push_back(0);
+  offsets.vec().push_back(0);
 }
 
 
 double annis::StringStorage::avgLength()
 {
-  size_t sum=0;
-  for(const auto& v : byValue)
+  // each string in the arena is followed by a terminating character
+  size_t sum= arena.size() - byValue.size();
+  return (double) sum / (double) byValue.size();
+}
+
+bool StringStorage::saveMapped(const string &path) const
+{
+  // the IDs in value order, so the index can be filled without comparing the strings when loading
+  std::vector<std::uint32_t> order;
+  order.reserve(byValue.size());
+  for(const ValueRef& ref : byValue)
   {
-    sum += v.first.size();
+    order.push_back(ref.id);
   }
-  return (double) sum / (double) byValue.size();
+
+  MappedFileWriter writer;
+  offsets.addTo(writer, "offsets");
+  arena.addTo(writer, "arena");
+  writer.addSection<std::uint32_t>("order", order.data(), order.size());
+  return writer.write(path);
 }
 
-size_t StringStorage::estimateMemorySize() const
+bool StringStorage::loadMapped(const string &path)
 {
-  size_t strSize = 0;
-  for(const auto& v : byValue)
+  std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+  const std::uint32_t* order;
+  size_t orderSize;
+  if(!file || !file->hasSection("offsets") || !file->hasSection("arena")
+     || !file->section<std::uint32_t>("order", order, orderSize))
   {
-    const std::string& s = v.first;
-    strSize += s.capacity();
+    return false;
   }
+
+  offsets.map(file, "offsets");
+  arena.map(file, "arena");
+
+  byValue.clear();
+  for(size_t i=0; i < orderSize; i++)
+  {
+    if(hasID(order[i]))
+    {
+      // the hint makes the insertion constant if the order is correct
+      byValue.insert(byValue.end(), {order[i], 0, nullptr});
+    }
+  }
+  return true;
+}
+
+size_t StringStorage::estimateMemorySize() const
+{
   return
-      size_estimation::element_size(byID)
-      + size_estimation::element_size(byValue)
-      + (strSize*2);
+      offsets.heapSize()
+      + arena.heapSize()
+      + byValue.bytes_used();
+}
+
+void StringStorage::importLegacy(const std::unordered_map<uint32_t, string> &legacyByID)
+{
+  clear();
+
+  // sort by ID so the arena can be filled in ID order, unused IDs get an empty range
+  std::vector<std::pair<uint32_t, const std::string*>> sorted;
+  sorted.reserve(legacyByID.size());
+  size_t arenaSize = 0;
+  for(const auto& e : legacyByID)
+  {
+    if(e.first == STRING_STORAGE_ANY)
+    {
+      continue;
+    }
+    sorted.push_back({e.first, &e.second});
+    arenaSize += e.second.size() + 1;
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<char>& arenaVec = arena.vec();
+  std::vector<std::uint64_t>& offsetsVec = offsets.vec();
+  arenaVec.reserve(arenaSize);
+  if(!sorted.empty())
+  {
+    offsetsVec.reserve(sorted.back().first + 2);
+  }
+
+  for(const auto& e : sorted)
+  {
+    while(offsetsVec.size() - 1 < e.first)
+    {
+      offsetsVec.push_back(arenaVec.size());
+    }
+    arenaVec.insert(arenaVec.end(), e.second->begin(), e.second->end());
+    arenaVec.push_back('\0');
+    offsetsVec.push_back(arenaVec.size());
+  }
+
+  rebuildValueIndex();
+}
+
+void StringStorage::rebuildValueIndex()
+{
+  byValue.clear();
+  for(uint32_t id=0; id+1 < offsets.size(); id++)
+  {
+    if(hasID(id))
+    {
+      byValue.insert({id, 0, nullptr});
+    }
+  }
 }
@@ -19,36 +19,94 @@
 #include <cereal/cereal.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/unordered_map.hpp>
+#include <cereal/types/vector.hpp>
 #include <annis/serializers.h>
+#include <annis/util/mappablevector.h>
 
 #include <google/btree.h>               // for btree_iterator
 #include <google/btree_container.h>     // for btree_unique_container<>::con...
 #include <google/btree_map.h>           // for btree_map
+#include <google/btree_set.h>           // for btree_set
 #include <stddef.h>                     // for size_t
 #include <boost/optional/optional.hpp>  // for optional
-#include <cstdint>                      // for uint32_t
+#include <boost/utility/string_ref.hpp> // for string_ref
+#include <cstdint>                      // for uint32_t, uint64_t
+#include <limits>                       // for numeric_limits
 #include <set>                          // for set
 #include <string>                       // for string
 #include <unordered_map>                // for unordered_map, _Node_const_it...
+#include <unordered_set>                // for unordered_set
 #include <utility>                      // for pair
+#include <vector>                       // for vector
+#include <memory>                       // for shared_ptr
 
-
+namespace re2 { class RE2; }
 
 namespace annis
 {
+class ThreadPool;
+
 const std::uint32_t STRING_STORAGE_ANY = 0;
 
+/**
+ * @brief Dictionary which maps strings to numeric IDs and back.
+ *
+ * All strings are stored in a single contiguous character arena (each string is terminated with '\0').
+ * The start position of a string inside the arena is stored in a dense vector indexed by the string ID,
+ * thus resolving an ID is a single array access. The value index only holds the IDs and
+ * compares them by looking up their value in the arena.
+ *
+ * When loaded with loadMapped() the arena and the offsets are used directly from the memory mapped file,
+ * they are only copied to the heap when new strings are added.
+ */
 class StringStorage
 {
+private:
+
+  /**
+   * @brief Key of the value index.
+   *
+   * Stored keys only reference a string ID, keys which are only used for searching point to
+   * an external string instead.
+   */
+  struct ValueRef
+  {
+    std::uint32_t id;
+    std::uint32_t externalLength;
+    const char* external;
+  };
+
+  class ValueRefCompare
+  {
+  public:
+    ValueRefCompare() : storage(nullptr) {}
+    ValueRefCompare(const StringStorage* storage) : storage(storage) {}
+
+    bool operator()(const ValueRef& a, const ValueRef& b) const
+    {
+      return storage->resolve(a) < storage->resolve(b);
+    }
+  private:
+    const StringStorage* storage;
+  };
+
+  using ValueIndex = btree::btree_set<ValueRef, ValueRefCompare>;
+
 public:
   StringStorage();
-
-  const std::string& str(std::uint32_t id) const
+  StringStorage(const StringStorage& orig);
+  StringStorage& operator=(const StringStorage& orig);
+
+  /**
+   * @brief Get the string for an ID without copying it.
+   *
+   * The returned reference is only valid until the next call to add() or clear().
+   */
+  boost::string_ref strRef(std::uint32_t id) const
   {
-    auto it = byID.find(id);
-    if(it != byID.end())
+    if(hasID(id))
     {
-      return it->second;
+      return boost::string_ref(arena.data() + offsets[id], offsets[id+1] - offsets[id] - 1);
     }
     else
     {
@@ -56,12 +114,19 @@ public:
     }
   }
 
+  /**
+   * @brief Get a copy of the string for an ID, use strRef() where no owned string is needed.
+   */
+  std::string str(std::uint32_t id) const
+  {
+    return strRef(id).to_string();
+  }
+
   boost::optional<std::string> strOpt(std::uint32_t id) const
   {
-    auto it = byID.find(id);
-    if(it != byID.end())
+    if(hasID(id))
     {
-      return boost::optional<std::string>(it->second);
+      return boost::optional<std::string>(strRef(id).to_string());
     }
     else
     {
@@ -71,36 +136,116 @@ public:
 
   boost::optional<std::uint32_t> findID(const std::string& str) const
   {
-    typedef btree::btree_map<std::string, std::uint32_t>::const_iterator ItType;
     boost::optional<std::uint32_t> result;
-    ItType it = byValue.find(str);
+    auto it = byValue.find(searchKey(str));
     if(it != byValue.end())
     {
-      result = it->second;
+      result = it->id;
     }
     return result;
   }
 
   std::unordered_set<std::uint32_t> findRegex(const std::string& str) const;
 
+  /**
+   * @brief Find the IDs of all strings which fully match a regular expression.
+   *
+   * Only the strings inside the possible match range of the pattern are checked and each of them exactly once.
+   * If a thread pool is given, the candidates are split into (at most) numOfTasks parts which are matched in parallel.
+   *
+   * @return The matching IDs sorted in ascending order.
+   */
+  std::vector<std::uint32_t> findRegexIDs(const re2::RE2& re,
+                                          std::shared_ptr<ThreadPool> threadPool = std::shared_ptr<ThreadPool>(),
+                                          size_t numOfTasks = 0) const;
+
+  /**
+   * @brief Count the strings in the possible match range of a regular expression, but stop counting at the given limit.
+   */
+  size_t countRegexCandidates(const re2::RE2& re, size_t limit) const;
+
   std::uint32_t add(const std::string& str);
 
   void clear();
 
-  size_t size() const {return byID.size();}
+  size_t size() const {return byValue.size();}
   double avgLength();
 
   size_t estimateMemorySize() const;
 
   template<class Archive>
-  void serialize(Archive & archive)
+  void save(Archive & archive) const
+  {
+    archive(offsets, arena);
+  }
+
+  /**
+   * @brief Save the strings as a memory mappable file (see MappedFile).
+   */
+  bool saveMapped(const std::string& path) const;
+
+  /**
+   * @brief Load the strings from a file written by saveMapped() without copying them.
+   * @return False if the file does not exist or has an incompatible format, the storage is not changed in this case.
+   */
+  bool loadMapped(const std::string& path);
+
+  template<class Archive>
+  void load(Archive & archive)
+  {
+    archive(offsets, arena);
+    rebuildValueIndex();
+  }
+
+  /**
+   * @brief Import the string storage from the serialization format used before the arena layout
+   * (separate maps for the IDs and the values).
+   */
+  template<class Archive>
+  void loadLegacy(Archive & archive)
   {
-    archive(byID, byValue);
+    std::unordered_map<std::uint32_t, std::string> legacyByID;
+    btree::btree_map<std::string, std::uint32_t> legacyByValue;
+    archive(legacyByID, legacyByValue);
+    importLegacy(legacyByID);
   }
 
 private:
-  std::unordered_map<std::uint32_t, std::string> byID;
-  btree::btree_map<std::string, std::uint32_t> byValue;
+  /**
+   * @brief Start position of each string ID in the arena.
+   *
+   * The string with ID i occupies the range [offsets[i], offsets[i+1]) including its terminating '\0'.
+   * IDs which are not assigned have an empty range.
+   */
+  MappableVector<std::uint64_t> offsets;
+  MappableVector<char> arena;
+  ValueIndex byValue;
+
+private:
+
+  bool hasID(std::uint32_t id) const
+  {
+    return static_cast<size_t>(id) + 1 < offsets.size() && offsets[id] != offsets[id+1];
+  }
+
+  boost::string_ref resolve(const ValueRef& ref) const
+  {
+    if(ref.external)
+    {
+      return boost::string_ref(ref.external, ref.externalLength);
+    }
+    return strRef(ref.id);
+  }
+
+  static ValueRef searchKey(const std::string& str)
+  {
+    return {STRING_STORAGE_ANY, static_cast<std::uint32_t>(str.size()), str.c_str()};
+  }
+
+  std::pair<ValueIndex::const_iterator, ValueIndex::const_iterator> regexCandidateRange(const re2::RE2& re) const;
+
+  void importLegacy(const std::unordered_map<std::uint32_t, std::string>& legacyByID);
+  void rebuildValueIndex();
 
 };
 }
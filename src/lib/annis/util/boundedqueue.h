@@ -0,0 +1,256 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <stddef.h>            // for size_t
+#include <stdint.h>            // for intptr_t
+#include <atomic>              // for atomic, atomic_bool
+#include <condition_variable>  // for condition_variable
+#include <memory>              // for unique_ptr
+#include <mutex>               // for mutex, lock_guard, unique_lock
+#include <utility>             // for move
+
+namespace annis
+{
+  /**
+   * @brief A bounded multi-producer/multi-consumer queue.
+   *
+   * Adding and retrieving items is lock-free (using a ring buffer where each cell has a sequence number).
+   * The blocking push() and pop() functions only use a mutex to sleep while the queue is full or empty.
+   * Like the SharedQueue it is possible to shutdown the queue, which wakes up all waiting threads.
+   * Since items are moved into the queue it is meant to transport whole batches of results.
+   */
+  template<typename T>
+  class BoundedQueue
+  {
+  public:
+
+    /**
+     * @param capacity Maximal number of items in the queue, will be rounded up to the next power of two.
+     */
+    BoundedQueue(size_t capacity)
+      : enqueuePos(0), dequeuePos(0), isShutdown(false), numOfWaiting(0)
+    {
+      size_t size = 2;
+      while(size < capacity)
+      {
+        size *= 2;
+      }
+      mask = size - 1;
+
+      buffer.reset(new Cell[size]);
+      for(size_t i=0; i < size; i++)
+      {
+        buffer[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    /**
+     * @brief Add an item if the queue is not full. Consumers which wait in pop() are woken up.
+     * @return False if the queue was full, the item is not moved in this case.
+     */
+    bool tryPush(T& item)
+    {
+      size_t pos = enqueuePos.load(std::memory_order_relaxed);
+      while(true)
+      {
+        Cell& cell = buffer[pos & mask];
+        const size_t seq = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if(diff == 0)
+        {
+          if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            cell.data = std::move(item);
+            cell.sequence.store(pos + 1, std::memory_order_release);
+            notifyWaiting();
+            return true;
+          }
+        }
+        else if(diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /**
+     * @brief Retrieve an item if the queue is not empty. Producers which wait in push() are woken up.
+     */
+    bool tryPop(T& item)
+    {
+      size_t pos = dequeuePos.load(std::memory_order_relaxed);
+      while(true)
+      {
+        Cell& cell = buffer[pos & mask];
+        const size_t seq = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if(diff == 0)
+        {
+          if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            item = std::move(cell.data);
+            cell.sequence.store(pos + mask + 1, std::memory_order_release);
+            notifyWaiting();
+            return true;
+          }
+        }
+        else if(diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /**
+     * @brief Add an item, this will block while the queue is full.
+     * @return False if the queue was shut down, the item is discarded in this case.
+     */
+    bool push(T&& item)
+    {
+      while(!isShutdown)
+      {
+        if(tryPush(item))
+        {
+          return true;
+        }
+        wait([this] {return this->isShutdown || this->isWritable();});
+      }
+      return false;
+    }
+
+    /**
+     * @brief Retrieve an item from the queue. This will block until an item is available. If the queue is empty
+     * and shut-down it will return immediatly with "false" as a result.
+     */
+    bool pop(T& item)
+    {
+      while(true)
+      {
+        if(tryPop(item))
+        {
+          return true;
+        }
+        else if(isShutdown)
+        {
+          // items which have been added before the shutdown must still be returned
+          return tryPop(item);
+        }
+        wait([this] {return this->isShutdown || this->isReadable();});
+      }
+    }
+
+    /**
+     * @brief Don't allow any new items and wake up all waiting threads. A shutdown can't be undone.
+     */
+    void shutdown()
+    {
+      isShutdown = true;
+      {
+        std::lock_guard<std::mutex> lock(mutex_wait);
+      }
+      cond_wait.notify_all();
+    }
+
+    /**
+     * @brief Approximate number of items in the queue.
+     */
+    size_t size() const
+    {
+      // load the smaller position first so the difference is never negative
+      const size_t dequeued = dequeuePos.load();
+      return enqueuePos.load() - dequeued;
+    }
+
+  private:
+
+    /** True if the next cell to dequeue has been published by a producer */
+    bool isReadable() const
+    {
+      const size_t pos = dequeuePos.load(std::memory_order_relaxed);
+      return buffer[pos & mask].sequence.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    /** True if the next cell to enqueue has been released by a consumer */
+    bool isWritable() const
+    {
+      const size_t pos = enqueuePos.load(std::memory_order_relaxed);
+      return buffer[pos & mask].sequence.load(std::memory_order_acquire) == pos;
+    }
+
+    template<typename Predicate>
+    void wait(Predicate pred)
+    {
+      numOfWaiting++;
+      // Pairs with the fence in notifyWaiting(): either the notifying thread sees this waiter or the predicate
+      // sees the published cell.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      {
+        std::unique_lock<std::mutex> lock(mutex_wait);
+        cond_wait.wait(lock, pred);
+      }
+      numOfWaiting--;
+    }
+
+    void notifyWaiting()
+    {
+      // the cell was published with a release store, which could otherwise be reordered after this load
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(numOfWaiting.load(std::memory_order_relaxed) > 0)
+      {
+        // synchronize with threads which are about to wait
+        {
+          std::lock_guard<std::mutex> lock(mutex_wait);
+        }
+        cond_wait.notify_all();
+      }
+    }
+
+  private:
+
+    struct Cell
+    {
+      std::atomic<size_t> sequence;
+      T data;
+    };
+
+    std::unique_ptr<Cell[]> buffer;
+    size_t mask;
+
+    /** Producers and consumers should not share a cache line */
+    char padding1[64];
+    std::atomic<size_t> enqueuePos;
+    char padding2[64];
+    std::atomic<size_t> dequeuePos;
+    char padding3[64];
+
+    std::atomic_bool isShutdown;
+
+    std::atomic<size_t> numOfWaiting;
+    std::mutex mutex_wait;
+    std::condition_variable cond_wait;
+
+  };
+}
@@ -9,6 +9,7 @@
 
 #include <annis/db.h>
 #include <annis/graphstorage/graphstorage.h>
+#include <annis/util/tokenindex.h>
 
 #ifdef WIN32
 #include <windows.h>
@@ -28,6 +29,7 @@ class TokenHelper
 public:
 
   TokenHelper(DB::GetGSFuncT getGSFunc, const DB& db) : db(db),
+    tokenIndex(db.getTokenIndex(getGSFunc)),
     leftEdges(getGSFunc(ComponentType::LEFT_TOKEN, annis_ns, "")),
     rightEdges(getGSFunc(ComponentType::RIGHT_TOKEN, annis_ns, "")),
     covEdges(getGSFunc(ComponentType::COVERAGE, annis_ns, ""))
@@ -37,7 +39,11 @@ public:
   
   std::pair<nodeid_t, nodeid_t> leftRightTokenForNode(const nodeid_t& n)
   {
-    if(isToken(n))
+    if(tokenIndex && tokenIndex->contains(n))
+    {
+      return {tokenIndex->left(n), tokenIndex->right(n)};
+    }
+    else if(isToken(n))
     {
       return {n, n};
     }
@@ -49,7 +55,11 @@ public:
 
   nodeid_t leftTokenForNode(const nodeid_t& n)
   {
-    if(isToken(n))
+    if(tokenIndex && tokenIndex->contains(n))
+    {
+      return tokenIndex->left(n);
+    }
+    else if(isToken(n))
     {
       return n;
     }
@@ -61,7 +71,11 @@ public:
 
   nodeid_t rightTokenForNode(const nodeid_t& n)
   {
-    if(isToken(n))
+    if(tokenIndex && tokenIndex->contains(n))
+    {
+      return tokenIndex->right(n);
+    }
+    else if(isToken(n))
     {
       return n;
     }
@@ -73,12 +87,30 @@ public:
 
   bool inline isToken(const nodeid_t& n)
   {
+    if(tokenIndex && tokenIndex->contains(n))
+    {
+      return tokenIndex->isToken(n);
+    }
     return  db.nodeAnnos.getAnnotations(n, db.getNamespaceStringID(), db.getTokStringID())
             && covEdges->getOutgoingEdges(n).empty();
   }
 
+  /**
+   * @brief Get the token index if it can replace the default ORDERING component for distance queries.
+   * @return An empty pointer if the ORDERING component must be used.
+   */
+  std::shared_ptr<const TokenIndex> getOrderIndex() const
+  {
+    if(tokenIndex && tokenIndex->hasPositions())
+    {
+      return tokenIndex;
+    }
+    return std::shared_ptr<const TokenIndex>();
+  }
+
 private:
   const DB& db;
+  std::shared_ptr<const TokenIndex> tokenIndex;
   std::shared_ptr<const ReadableGraphStorage> leftEdges;
   std::shared_ptr<const ReadableGraphStorage> rightEdges;
   std::shared_ptr<const ReadableGraphStorage> covEdges;
@@ -0,0 +1,173 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/util/mappedfile.h>  // for MappedFile
+#include <cereal/types/vector.hpp>  // for vector serialization
+#include <stddef.h>                 // for size_t
+#include <memory>                   // for shared_ptr
+#include <string>                   // for string
+#include <type_traits>              // for is_trivially_copyable
+#include <vector>                   // for vector
+
+namespace annis
+{
+
+/**
+ * @brief An array which either owns its elements or uses a section of a MappedFile in place.
+ *
+ * Reading is possible in both states. Requesting write access with vec() copies mapped data
+ * to the heap first, the mapping is released afterwards.
+ */
+template<typename T>
+class MappableVector
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be used from a memory mapped file");
+
+public:
+  MappableVector() : mappedData(nullptr), mappedSize(0) {}
+
+  size_t size() const
+  {
+    return file ? mappedSize : owned.size();
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  const T* data() const
+  {
+    return file ? mappedData : owned.data();
+  }
+
+  const T& operator[](size_t idx) const
+  {
+    return data()[idx];
+  }
+
+  const T* begin() const
+  {
+    return data();
+  }
+
+  const T* end() const
+  {
+    return data() + size();
+  }
+
+  const T& back() const
+  {
+    return data()[size()-1];
+  }
+
+  bool isMapped() const
+  {
+    return file ? true : false;
+  }
+
+  /**
+   * @brief Get write access to the elements, which are copied to the heap if they are currently mapped.
+   */
+  std::vector<T>& vec()
+  {
+    if(file)
+    {
+      owned.assign(mappedData, mappedData + mappedSize);
+      unmap();
+    }
+    return owned;
+  }
+
+  void clear()
+  {
+    unmap();
+    owned.clear();
+  }
+
+  /**
+   * @brief Use the elements of a section of the file in place.
+   * @return False if there is no fitting section in the file, the content is not changed in this case.
+   */
+  bool map(std::shared_ptr<const MappedFile> newFile, const std::string& sectionName)
+  {
+    const T* sectionData;
+    size_t count;
+    if(newFile && newFile->section<T>(sectionName, sectionData, count))
+    {
+      owned.clear();
+      owned.shrink_to_fit();
+      file = newFile;
+      mappedData = sectionData;
+      mappedSize = count;
+      return true;
+    }
+    return false;
+  }
+
+  void addTo(MappedFileWriter& writer, const std::string& sectionName) const
+  {
+    writer.addSection<T>(sectionName, data(), size());
+  }
+
+  /**
+   * @brief Number of bytes allocated on the heap, mapped elements are not included.
+   */
+  size_t heapSize() const
+  {
+    return owned.capacity() * sizeof(T);
+  }
+
+  template<class Archive>
+  void save(Archive & archive) const
+  {
+    if(file)
+    {
+      std::vector<T> copy(begin(), end());
+      archive(copy);
+    }
+    else
+    {
+      archive(owned);
+    }
+  }
+
+  template<class Archive>
+  void load(Archive & archive)
+  {
+    unmap();
+    archive(owned);
+  }
+
+private:
+
+  void unmap()
+  {
+    file.reset();
+    mappedData = nullptr;
+    mappedSize = 0;
+  }
+
+  std::vector<T> owned;
+
+  std::shared_ptr<const MappedFile> file;
+  const T* mappedData;
+  size_t mappedSize;
+};
+
+} // end namespace annis
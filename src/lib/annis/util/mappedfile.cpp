@@ -0,0 +1,190 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "mappedfile.h"
+
+#include <boost/filesystem.hpp>                  // for rename, exists
+#include <boost/interprocess/exceptions.hpp>     // for interprocess_exception
+#include <cstring>                               // for memcpy, strncmp
+#include <fstream>                               // for ofstream
+#include <vector>                                // for vector
+
+using namespace annis;
+
+namespace
+{
+  const char fileMagic[8] = {'A', 'N', 'N', 'I', 'S', 'M', 'A', 'P'};
+  const size_t sectionNameLength = 32;
+  const size_t sectionAlignment = 64;
+
+  struct FileHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t numOfSections;
+  };
+
+  struct SectionHeader
+  {
+    char name[sectionNameLength];
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  std::uint64_t alignOffset(std::uint64_t offset)
+  {
+    return ((offset + sectionAlignment - 1) / sectionAlignment) * sectionAlignment;
+  }
+}
+
+const std::uint32_t MappedFile::formatVersion = 1;
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string &path)
+{
+  if(!boost::filesystem::is_regular_file(path) || boost::filesystem::file_size(path) < sizeof(FileHeader))
+  {
+    return std::shared_ptr<const MappedFile>();
+  }
+
+  std::shared_ptr<MappedFile> result(new MappedFile());
+  try
+  {
+    result->mapping = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+    result->region = boost::interprocess::mapped_region(result->mapping, boost::interprocess::read_only);
+  }
+  catch(boost::interprocess::interprocess_exception& ex)
+  {
+    return std::shared_ptr<const MappedFile>();
+  }
+
+  const char* base = static_cast<const char*>(result->region.get_address());
+  const size_t fileSize = result->region.get_size();
+
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(FileHeader));
+  if(std::strncmp(header.magic, fileMagic, sizeof(fileMagic)) != 0 || header.version != formatVersion
+     || sizeof(FileHeader) + header.numOfSections * sizeof(SectionHeader) > fileSize)
+  {
+    return std::shared_ptr<const MappedFile>();
+  }
+
+  for(std::uint32_t i=0; i < header.numOfSections; i++)
+  {
+    SectionHeader s;
+    std::memcpy(&s, base + sizeof(FileHeader) + i*sizeof(SectionHeader), sizeof(SectionHeader));
+    if(s.offset > fileSize || s.size > fileSize - s.offset)
+    {
+      // truncated file
+      return std::shared_ptr<const MappedFile>();
+    }
+    std::string name(s.name, strnlen(s.name, sectionNameLength));
+    result->sections[name] = {s.offset, s.size};
+  }
+
+  return result;
+}
+
+bool MappedFile::rawSection(const std::string &name, const char *&data, size_t &size) const
+{
+  auto it = sections.find(name);
+  if(it != sections.end())
+  {
+    data = static_cast<const char*>(region.get_address()) + it->second.first;
+    size = it->second.second;
+    return true;
+  }
+  return false;
+}
+
+std::string MappedFile::sectionString(const std::string &name) const
+{
+  const char* data;
+  size_t size;
+  if(rawSection(name, data, size))
+  {
+    return std::string(data, size);
+  }
+  return "";
+}
+
+bool MappedFileWriter::write(const std::string &path) const
+{
+  FileHeader header;
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version = MappedFile::formatVersion;
+  header.numOfSections = static_cast<std::uint32_t>(entries.size());
+
+  std::vector<SectionHeader> sectionHeaders;
+  std::uint64_t offset = alignOffset(sizeof(FileHeader) + entries.size() * sizeof(SectionHeader));
+  for(const Entry& e : entries)
+  {
+    if(e.name.size() >= sectionNameLength)
+    {
+      return false;
+    }
+    SectionHeader s;
+    std::memset(s.name, 0, sectionNameLength);
+    std::memcpy(s.name, e.name.c_str(), e.name.size());
+    s.offset = offset;
+    s.size = e.size;
+    sectionHeaders.push_back(s);
+
+    offset = alignOffset(offset + e.size);
+  }
+
+  boost::filesystem::path tmpPath = boost::filesystem::unique_path(path + ".tmp-%%%%-%%%%");
+  {
+    std::ofstream os(tmpPath.string(), std::ios::binary);
+    if(!os.is_open())
+    {
+      return false;
+    }
+    os.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    os.write(reinterpret_cast<const char*>(sectionHeaders.data()), sectionHeaders.size() * sizeof(SectionHeader));
+
+    std::uint64_t pos = sizeof(FileHeader) + sectionHeaders.size() * sizeof(SectionHeader);
+    auto itHeader = sectionHeaders.begin();
+    for(const Entry& e : entries)
+    {
+      // pad until the section begins
+      for(; pos < itHeader->offset; pos++)
+      {
+        os.put('\0');
+      }
+      const char* data = e.data == nullptr ? e.ownedData.data() : e.data;
+      os.write(data, e.size);
+      pos += e.size;
+      itHeader++;
+    }
+
+    if(!os.good())
+    {
+      os.close();
+      boost::filesystem::remove(tmpPath);
+      return false;
+    }
+  }
+
+  // renaming is atomic and the old file stays valid for anyone who still has mapped it
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmpPath, path, ec);
+  if(ec)
+  {
+    boost::filesystem::remove(tmpPath);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,185 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>   // for file_mapping
+#include <boost/interprocess/mapped_region.hpp>  // for mapped_region
+#include <cereal/archives/binary.hpp>            // for BinaryInputArchive
+#include <stddef.h>                              // for size_t
+#include <cstdint>                               // for uint32_t, uint64_t
+#include <list>                                  // for list
+#include <map>                                   // for map
+#include <memory>                                // for shared_ptr
+#include <sstream>                               // for ostringstream
+#include <streambuf>                             // for streambuf
+#include <string>                                // for string
+#include <utility>                               // for pair
+
+namespace annis
+{
+
+/**
+ * @brief A read-only memory mapped file in the versioned section format of graphANNIS.
+ *
+ * The file consists of a header (magic bytes and format version), a table of named sections and the
+ * section data. Each section starts at a 64 byte aligned offset, so arrays of plain values can be used in place
+ * without copying them to the heap. The data is stored in the native byte order.
+ *
+ * Pages are only loaded by the operating system when they are accessed and can be
+ * dropped from the page cache when the memory is needed elsewhere.
+ */
+class MappedFile
+{
+public:
+
+  static const std::uint32_t formatVersion;
+
+  /**
+   * @brief Map a file into memory.
+   * @return An empty pointer if the file does not exist or has a different format (version).
+   */
+  static std::shared_ptr<const MappedFile> open(const std::string& path);
+
+  bool hasSection(const std::string& name) const
+  {
+    return sections.find(name) != sections.end();
+  }
+
+  /**
+   * @brief Get a pointer to the raw data of a section.
+   * @return False if there is no such section.
+   */
+  bool rawSection(const std::string& name, const char*& data, size_t& size) const;
+
+  /**
+   * @brief Get a section as array of elements, the data is not copied.
+   * @return False if there is no such section or its size does not fit the element type.
+   */
+  template<typename T>
+  bool section(const std::string& name, const T*& data, size_t& count) const
+  {
+    const char* raw;
+    size_t size;
+    if(rawSection(name, raw, size) && size % sizeof(T) == 0)
+    {
+      data = reinterpret_cast<const T*>(raw);
+      count = size / sizeof(T);
+      return true;
+    }
+    return false;
+  }
+
+  std::string sectionString(const std::string& name) const;
+
+  /**
+   * @brief Deserialize objects from a section which was written with MappedFileWriter::addCerealSection().
+   */
+  template<typename... Types>
+  bool loadCereal(const std::string& name, Types&... objs) const
+  {
+    const char* raw;
+    size_t size;
+    if(rawSection(name, raw, size))
+    {
+      InputBuffer buffer(raw, size);
+      std::istream is(&buffer);
+      cereal::BinaryInputArchive ar(is);
+      ar(objs...);
+      return true;
+    }
+    return false;
+  }
+
+private:
+
+  /** Stream buffer which reads directly from the mapped memory */
+  class InputBuffer : public std::streambuf
+  {
+  public:
+    InputBuffer(const char* data, size_t size)
+    {
+      char* p = const_cast<char*>(data);
+      setg(p, p, p + size);
+    }
+  };
+
+  MappedFile() {}
+
+  boost::interprocess::file_mapping mapping;
+  boost::interprocess::mapped_region region;
+  /** Offset and size of each section */
+  std::map<std::string, std::pair<std::uint64_t, std::uint64_t>> sections;
+};
+
+/**
+ * @brief Writes a file in the section format which can be read by MappedFile.
+ */
+class MappedFileWriter
+{
+public:
+
+  /**
+   * @brief Add an array as section.
+   *
+   * The data is not copied and must be valid until write() has been called.
+   */
+  template<typename T>
+  void addSection(const std::string& name, const T* data, size_t count)
+  {
+    entries.push_back({name, reinterpret_cast<const char*>(data), count * sizeof(T), std::string()});
+  }
+
+  void addSection(const std::string& name, const std::string& value)
+  {
+    entries.push_back({name, nullptr, value.size(), value});
+  }
+
+  /**
+   * @brief Add a section containing the cereal binary serialization of the given objects.
+   */
+  template<typename... Types>
+  void addCerealSection(const std::string& name, const Types&... objs)
+  {
+    std::ostringstream os;
+    {
+      cereal::BinaryOutputArchive ar(os);
+      ar(objs...);
+    }
+    addSection(name, os.str());
+  }
+
+  /**
+   * @brief Write all sections to a file.
+   *
+   * The content is written to a temporary file first which then replaces the file at the given path.
+   * This way an existing file which is still mapped by a MappedFile is never changed.
+   */
+  bool write(const std::string& path) const;
+
+private:
+  struct Entry
+  {
+    std::string name;
+    const char* data;
+    size_t size;
+    std::string ownedData;
+  };
+
+  std::list<Entry> entries;
+};
+
+} // end namespace annis
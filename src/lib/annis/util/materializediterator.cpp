@@ -0,0 +1,75 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "materializediterator.h"
+
+using namespace annis;
+
+MaterializedIterator::MaterializedIterator(std::shared_ptr<Iterator> source)
+  : source(source), numOfBuffered(0), sourceExhausted(false), bufferedPos(0)
+{
+}
+
+std::uint64_t MaterializedIterator::materialize(std::uint64_t minTuples)
+{
+  while(!sourceExhausted && numOfBuffered < minTuples)
+  {
+    buffered.emplace_back();
+    if(source->nextBatch(buffered.back()))
+    {
+      numOfBuffered += buffered.back().size();
+    }
+    else
+    {
+      buffered.pop_back();
+      sourceExhausted = true;
+    }
+  }
+  return numOfBuffered;
+}
+
+bool MaterializedIterator::nextBatch(MatchBatch& batch)
+{
+  if(bufferedPos < buffered.size())
+  {
+    batch = buffered[bufferedPos++];
+    return true;
+  }
+  else if(!sourceExhausted)
+  {
+    return source->nextBatch(batch);
+  }
+  batch.clear();
+  return false;
+}
+
+void MaterializedIterator::reset()
+{
+  BatchIterator::reset();
+  if(!sourceExhausted)
+  {
+    // the buffered tuples are only the beginning of the results, start again with the source
+    source->reset();
+    buffered.clear();
+    numOfBuffered = 0;
+  }
+  bufferedPos = 0;
+}
+
+MaterializedIterator::~MaterializedIterator()
+{
+
+}
@@ -0,0 +1,69 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/iterators.h>  // for BatchIterator, MatchBatch
+#include <stddef.h>           // for size_t
+#include <cstdint>            // for uint64_t
+#include <memory>             // for shared_ptr
+#include <vector>             // for vector
+
+namespace annis
+{
+
+/**
+ * @brief Buffers the first results of another iterator and returns them before the remaining ones.
+ *
+ * This allows to inspect how many results a part of a plan produces and to continue the
+ * execution with the same iterator afterwards.
+ */
+class MaterializedIterator : public BatchIterator
+{
+public:
+  MaterializedIterator(std::shared_ptr<Iterator> source);
+
+  /**
+   * @brief Fetch batches from the source until at least the given number of tuples is buffered.
+   * @return The number of buffered tuples.
+   */
+  std::uint64_t materialize(std::uint64_t minTuples);
+
+  /**
+   * @brief True if the source is exhausted and all its tuples are buffered.
+   */
+  bool isComplete() const
+  {
+    return sourceExhausted;
+  }
+
+  virtual bool nextBatch(MatchBatch& batch) override;
+  virtual void reset() override;
+
+  virtual ~MaterializedIterator();
+
+private:
+  std::shared_ptr<Iterator> source;
+
+  std::vector<MatchBatch> buffered;
+  std::uint64_t numOfBuffered;
+  bool sourceExhausted;
+
+  /** Position of the next buffered batch to return */
+  size_t bufferedPos;
+};
+
+} // end namespace annis
@@ -0,0 +1,244 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/iterators.h>          // for MatchBatch
+#include <annis/util/boundedqueue.h>  // for BoundedQueue
+#include <annis/util/threadpool.h>    // for ThreadPool
+#include <stddef.h>                   // for size_t
+#include <atomic>                     // for atomic_bool
+#include <condition_variable>         // for condition_variable
+#include <deque>                      // for deque
+#include <functional>                 // for function
+#include <memory>                     // for shared_ptr, unique_ptr
+#include <mutex>                      // for mutex, lock_guard, unique_lock
+#include <utility>                    // for move
+#include <vector>                     // for vector
+
+namespace annis
+{
+  /**
+   * @brief The state of a morsel task which is kept while the task is parked.
+   */
+  struct MorselTaskState
+  {
+    /** Full output batches which could not be added to the queue yet */
+    std::deque<MatchBatch> pending;
+  };
+
+  /**
+   * @brief Executes the morsels of a parallel operator as tasks of a thread pool.
+   *
+   * Each task processes one morsel and enqueues a task for the next morsel when it is finished. The results are
+   * transported as batches in a bounded queue. If the consumer is too slow and the queue is full, a task does not
+   * wait but parks its state and returns the worker to the pool. The consumer enqueues the parked tasks again after
+   * it has fetched a batch. Thus the workers are never blocked by a single operator and can be shared with other
+   * queries.
+   *
+   * The state type must be derived from MorselTaskState, it can hold a partially processed morsel.
+   */
+  template<typename State = MorselTaskState>
+  class MorselTasks
+  {
+  public:
+    /**
+     * @brief Function which is executed by a task. The state is empty if the task should start with a new morsel,
+     * otherwise it is the state of a resumed task.
+     */
+    using TaskFunc = std::function<void(std::shared_ptr<State>)>;
+
+    /**
+     * @param task The function which processes the morsels.
+     * @param numOfTasks Number of morsels which are processed in parallel.
+     * @param threadPool The pool which executes the tasks, a new one is created when the tasks are started if empty.
+     * @param queuedBatchesPerTask Number of result batches per task which can be queued before the tasks are parked.
+     */
+    MorselTasks(TaskFunc task, size_t numOfTasks, std::shared_ptr<ThreadPool> threadPool,
+                size_t queuedBatchesPerTask = 2)
+      : task(task), numOfTasks(numOfTasks), queueCapacity(queuedBatchesPerTask * numOfTasks),
+        threadPool(threadPool), running(false), activeTasks(0),
+        results(new BoundedQueue<MatchBatch>(queueCapacity))
+    {
+    }
+
+    MorselTasks(const MorselTasks&) = delete;
+    MorselTasks& operator=(const MorselTasks&) = delete;
+
+    /** True if the tasks were started and not stopped yet */
+    bool isRunning() const
+    {
+      return running;
+    }
+
+    void start()
+    {
+      running = true;
+      // Make sure the number of active tasks is correct before actually running them.
+      // Thus if a task immediatly returns since there is no result only the very last
+      // task will trigger a shutdown.
+      {
+        std::lock_guard<std::mutex> lock(mutex_activeTasks);
+        activeTasks = numOfTasks;
+      }
+
+      if(!threadPool)
+      {
+        threadPool = std::make_shared<ThreadPool>(numOfTasks);
+      }
+
+      for(size_t i=0; i < numOfTasks; i++)
+      {
+        threadPool->enqueue([this]() {task(nullptr);});
+      }
+    }
+
+    /**
+     * @brief Called by a task when its morsel is finished.
+     *
+     * A new task for the next morsel is enqueued, thus other tasks get the chance to run before.
+     */
+    void continueWithNextMorsel()
+    {
+      threadPool->enqueue([this]() {task(nullptr);});
+    }
+
+    /** Called by a task if there are no morsels left. */
+    void finishTask()
+    {
+      std::lock_guard<std::mutex> lock(mutex_activeTasks);
+      activeTasks--;
+
+      if(activeTasks == 0)
+      {
+        // if this was the last task shutdown the queue to message that there are no more results to fetch
+        results->shutdown();
+        cond_activeTasks.notify_all();
+      }
+    }
+
+    /**
+     * @brief Add the pending output of a task to the queue or park the task if the queue is full.
+     * @return False if the task was parked or finished and must not continue.
+     */
+    bool flushOrPark(std::shared_ptr<State>& state)
+    {
+      while(!state->pending.empty())
+      {
+        if(!running)
+        {
+          finishTask();
+          return false;
+        }
+        if(!results->tryPush(state->pending.front()))
+        {
+          std::lock_guard<std::mutex> lock(mutex_parked);
+          // The consumer resumes the parked tasks under the same lock after it fetched a batch, so either
+          // the queue has space now or the consumer will see this task.
+          if(!running)
+          {
+            finishTask();
+            return false;
+          }
+          if(!results->tryPush(state->pending.front()))
+          {
+            parked.emplace_back(std::move(state));
+            return false;
+          }
+        }
+        state->pending.pop_front();
+      }
+      return true;
+    }
+
+    /**
+     * @brief Wait for the next result batch and resume the parked tasks.
+     * @return False if all tasks are finished and there are no results left.
+     */
+    bool pop(MatchBatch& batch)
+    {
+      //  wait for next batch in queue or return immediatly if queue was shutdown
+      if(results->pop(batch))
+      {
+        // there is space in the queue again
+        resumeParked();
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * @brief Stop all tasks and wait until they are finished. The tasks can be started again afterwards.
+     */
+    void stop()
+    {
+      running = false;
+      results->shutdown();
+
+      // parked tasks are not resumed anymore
+      std::vector<std::shared_ptr<State>> stopped;
+      {
+        std::lock_guard<std::mutex> lock(mutex_parked);
+        stopped.swap(parked);
+      }
+      for(size_t i=0; i < stopped.size(); i++)
+      {
+        finishTask();
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_activeTasks);
+      cond_activeTasks.wait(lock, [this] {return activeTasks == 0;});
+
+      results = std::unique_ptr<BoundedQueue<MatchBatch>>(new BoundedQueue<MatchBatch>(queueCapacity));
+    }
+
+    ~MorselTasks()
+    {
+      stop();
+    }
+
+  private:
+    const TaskFunc task;
+    const size_t numOfTasks;
+    const size_t queueCapacity;
+    std::shared_ptr<ThreadPool> threadPool;
+
+    std::atomic_bool running;
+    size_t activeTasks;
+    std::mutex mutex_activeTasks;
+    std::condition_variable cond_activeTasks;
+
+    std::unique_ptr<BoundedQueue<MatchBatch>> results;
+
+    /** Tasks which are waiting for free space in the result queue */
+    std::vector<std::shared_ptr<State>> parked;
+    std::mutex mutex_parked;
+
+  private:
+    void resumeParked()
+    {
+      std::vector<std::shared_ptr<State>> resumed;
+      {
+        std::lock_guard<std::mutex> lock(mutex_parked);
+        resumed.swap(parked);
+      }
+      for(auto& state : resumed)
+      {
+        threadPool->enqueue([this, state]() {task(state);});
+      }
+    }
+  };
+}
@@ -18,8 +18,10 @@
 
 #include <annis/annosearch/nodebyedgeannosearch.h>  // for NodeByEdgeAnnoSearch
 #include <annis/db.h>                               // for DB
+#include <annis/join/bandjoin.h>                    // for BandJoin
 #include <annis/filter/binaryfilter.h>              // for BinaryFilter
 #include <annis/join/donothingjoin.h>
+#include <annis/join/hashjoin.h>                    // for HashJoin
 #include <annis/join/indexjoin.h>                   // for IndexJoin
 #include <annis/join/nestedloop.h>                  // for NestedLoopJoin
 #include <annis/join/threadindexjoin.h>             // for ThreadIndexJoin
@@ -30,6 +32,7 @@
 #include <annis/operators/operator.h>               // for Operator
 #include <annis/wrapper.h>                          // for ConstAnnoWrapper
 #include <boost/container/vector.hpp>               // for operator!=
+#include <cmath>                                    // for log2
 #include <cstdint>                                  // for uint64_t, int64_t
 #include <map>                                      // for _Rb_tree_iterator
 #include <memory>                                   // for shared_ptr, __sha...
@@ -46,11 +49,12 @@
 using namespace annis;
 
 Plan::Plan(std::shared_ptr<ExecutionNode> root)
-  : root(root)
+  : root(root), resultBatchPos(0)
 {
 }
 
 Plan::Plan(const Plan& orig)
+  : resultBatchPos(0)
 {
   root = orig.root;
 }
@@ -112,6 +116,39 @@ std::shared_ptr<ExecutionNode> Plan::join(std::shared_ptr<Operator> op,
     type = ExecutionNodeType::do_nothing;
   }
 
+  const bool useHashJoin = config.enableHashJoin && op->hasJoinKey();
+  const bool useBandJoin = config.enableBandJoin && op->hasBandKey();
+  if((type == ExecutionNodeType::index_join || type == ExecutionNodeType::nested_loop)
+     && (useHashJoin || useBandJoin) && !forceNestedLoop && numOfBackgroundTasks == 0)
+  {
+    // a hash or band join has to read both inputs completely, use it when this is cheaper than the other join
+    auto leftEst = estimateTupleSize(lhs);
+    auto rightEst = estimateTupleSize(rhs);
+
+    std::uint64_t processedByJoin;
+    if(type == ExecutionNodeType::nested_loop)
+    {
+      processedByJoin = calculateNestedLoopProcessed(leftEst->output, rightEst->output);
+    }
+    else if(op->estimationType() == Operator::EstimationType::SELECTIVITY)
+    {
+      processedByJoin = calculateIndexJoinProcessed(op->selectivity(), leftEst->output, rightEst->output);
+    }
+    else
+    {
+      processedByJoin = leftEst->output;
+    }
+
+    if(useHashJoin && calculateHashJoinProcessed(leftEst->output, rightEst->output) < processedByJoin)
+    {
+      type = ExecutionNodeType::hash_join;
+    }
+    else if(useBandJoin && calculateBandJoinProcessed(leftEst->output, rightEst->output) < processedByJoin)
+    {
+      type = ExecutionNodeType::band_join;
+    }
+  }
+
   boost::optional<std::string> extraDescription;
   
   // create the join iterator
@@ -127,6 +164,25 @@ std::shared_ptr<ExecutionNode> Plan::join(std::shared_ptr<Operator> op,
     result->type = ExecutionNodeType::do_nothing;
     join = std::make_shared<DoNothingJoin>();
   }
+  else if(type == ExecutionNodeType::hash_join)
+  {
+    result->type = ExecutionNodeType::hash_join;
+
+    // the smaller input is inserted into the hash table
+    auto leftEst = estimateTupleSize(lhs);
+    auto rightEst = estimateTupleSize(rhs);
+
+    bool leftIsBuild = leftEst->output <= rightEst->output;
+    extraDescription = leftIsBuild ? "build lhs" : "build rhs";
+
+    join = std::make_shared<HashJoin>(op, lhs->join, rhs->join,
+                                      mappedPosLHS->second, mappedPosRHS->second, leftIsBuild);
+  }
+  else if(type == ExecutionNodeType::band_join)
+  {
+    result->type = ExecutionNodeType::band_join;
+    join = std::make_shared<BandJoin>(op, lhs->join, rhs->join, mappedPosLHS->second, mappedPosRHS->second);
+  }
   else if(type == ExecutionNodeType::index_join)
   {
     result->type = ExecutionNodeType::index_join;
@@ -142,7 +198,8 @@ std::shared_ptr<ExecutionNode> Plan::join(std::shared_ptr<Operator> op,
         join = std::make_shared<ThreadIndexJoin>(lhs->join, mappedPosLHS->second, op,
                                                  createSearchFilter(db, estSearch),
                                                  numOfBackgroundTasks,
-                                                 config.threadPool);
+                                                 config.threadPool,
+                                                 config.morselSize);
       }
       #ifdef ENABLE_SIMD_SUPPORT
       else if(config.enableSIMDIndexJoin
@@ -252,22 +309,23 @@ bool Plan::executeStep(std::vector<Match>& result)
 {
   if(root && root->join)
   {
-    std::vector<Match> tmp;
-    if(root->join->next(tmp))
+    if(resultBatchPos >= resultBatch.size())
     {
-      // re-order the matched nodes by the original node position of the query
-      result.resize(tmp.size());
-      for(const auto& nodeMapping : root->nodePos)
+      resultBatchPos = 0;
+      if(!root->join->nextBatch(resultBatch))
       {
-        result[nodeMapping.first] = tmp[nodeMapping.second];
+        return false;
       }
-      return true;
     }
-    else
+
+    // re-order the matched nodes by the original node position of the query
+    result.resize(resultBatch.width());
+    for(const auto& nodeMapping : root->nodePos)
     {
-      return false;
+      result[nodeMapping.first] = resultBatch.get(resultBatchPos, nodeMapping.second);
     }
-
+    resultBatchPos++;
+    return true;
   }
   else
   {
@@ -275,6 +333,15 @@ bool Plan::executeStep(std::vector<Match>& result)
   }
 }
 
+std::uint64_t Plan::count()
+{
+  if(root && root->join)
+  {
+    return root->join->count();
+  }
+  return 0;
+}
+
 double Plan::getCost() 
 {
   // the estimation is cached in the root so multiple calls to getCost() won't do any harm
@@ -310,6 +377,37 @@ std::map<size_t, size_t> Plan::getOptimizedParallelizationMapping(const DB &db,
   return mapping;
 }
 
+long double Plan::operatorSelectivity(std::shared_ptr<Operator> op, std::uint64_t outputLHS, std::uint64_t outputRHS)
+{
+  static const double defaultSelectivity = 0.1;
+  if(!op)
+  {
+    return defaultSelectivity;
+  }
+  const long double lhs = std::max<std::uint64_t>(1, outputLHS);
+  const long double rhs = std::max<std::uint64_t>(1, outputRHS);
+  switch(op->estimationType())
+  {
+  case Operator::EstimationType::SELECTIVITY:
+  {
+    long double selectivity = op->selectivity();
+    const double edgeAnnoSelectivity = op->edgeAnnoSelectivity();
+    if(edgeAnnoSelectivity >= 0.0)
+    {
+      selectivity = selectivity * edgeAnnoSelectivity;
+    }
+    return selectivity;
+  }
+  case Operator::EstimationType::MIN:
+    // the output is the smaller operand
+    return 1.0 / std::max(lhs, rhs);
+  case Operator::EstimationType::MAX:
+    // the output is the larger operand
+    return 1.0 / std::min(lhs, rhs);
+  }
+  return defaultSelectivity;
+}
+
 std::shared_ptr<ExecutionEstimate> Plan::estimateTupleSize(std::shared_ptr<ExecutionNode> node)
 {
   static const std::uint64_t defaultBaseTuples = 100000;
@@ -321,6 +419,12 @@ std::shared_ptr<ExecutionEstimate> Plan::estimateTupleSize(std::shared_ptr<Execu
       // return the cached estimate
       return node->estimate;
     } 
+    else if(node->type == ExecutionNodeType::materialized)
+    {
+      // the tuples of this node have already been calculated
+      node->estimate = std::make_shared<ExecutionEstimate>(node->observedOutput, 0, 0);
+      return node->estimate;
+    }
     else
     {
       std::shared_ptr<EstimatedSearch> baseEstimate =
@@ -393,6 +497,14 @@ std::shared_ptr<ExecutionEstimate> Plan::estimateTupleSize(std::shared_ptr<Execu
         {
           processedInStep = calculateIndexJoinProcessed(operatorSelectivity, estLHS->output, estRHS->output);
         } 
+        else if(node->type == ExecutionNodeType::hash_join)
+        {
+          processedInStep = calculateHashJoinProcessed(estLHS->output, estRHS->output);
+        }
+        else if(node->type == ExecutionNodeType::band_join)
+        {
+          processedInStep = calculateBandJoinProcessed(estLHS->output, estRHS->output);
+        }
         else if(node->type == ExecutionNodeType::do_nothing)
         {
           processedInStep = 0;
@@ -652,7 +764,7 @@ std::function<std::list<Annotation> (nodeid_t)> Plan::createRegexAnnoSearchFilte
       auto foundAnno =
           db.nodeAnnos.getAnnotations(rhsNode, rightAnnoKey.ns, rightAnnoKey.name);
 
-      if(foundAnno && regexSearch->valueMatches(db.strings.str(foundAnno->val)) && outputFilter({rhsNode, *foundAnno}))
+      if(foundAnno && regexSearch->valueMatches(foundAnno->val) && outputFilter({rhsNode, *foundAnno}))
       {
         if(constAnno)
         {
@@ -677,7 +789,7 @@ std::function<std::list<Annotation> (nodeid_t)> Plan::createRegexAnnoSearchFilte
       for(AnnotationKey key : validAnnoKeys)
       {
        auto found = db.nodeAnnos.getAnnotations(rhsNode, key.ns, key.name);
-       if(found && regexSearch->valueMatches(db.strings.str(found->val)) && outputFilter({rhsNode, *found}))
+       if(found && regexSearch->valueMatches(found->val) && outputFilter({rhsNode, *found}))
        {
          if(constAnno)
          {
@@ -829,6 +941,20 @@ uint64_t Plan::calculateIndexJoinProcessed(long double operatorSelectivity, uint
       );
 }
 
+uint64_t Plan::calculateHashJoinProcessed(uint64_t outputLHS, uint64_t outputRHS)
+{
+  // each tuple of both sides is read and hashed once
+  return outputLHS + outputRHS;
+}
+
+uint64_t Plan::calculateBandJoinProcessed(uint64_t outputLHS, uint64_t outputRHS)
+{
+  // each tuple of both sides is read and sorted, the sweep itself only visits the tuples inside the band
+  long double sortLHS = outputLHS > 1 ? (long double) outputLHS * std::log2((long double) outputLHS) : outputLHS;
+  long double sortRHS = outputRHS > 1 ? (long double) outputRHS * std::log2((long double) outputRHS) : outputRHS;
+  return static_cast<std::uint64_t>(sortLHS + sortRHS);
+}
+
 
 
 
@@ -900,6 +1026,10 @@ std::string Plan::debugStringForNode(std::shared_ptr<const ExecutionNode> node,
       + std::to_string((std::uint64_t) node->estimate->processedInStep)
       + "]";
   }
+  if(node->type == ExecutionNodeType::materialized)
+  {
+    result += "[observed: " + std::to_string(node->observedOutput) + (node->observationComplete ? "" : "+") + "]";
+  }
   if(node->op)
   {
     Operator::EstimationType estType = node->op->estimationType();
@@ -963,6 +1093,14 @@ std::string Plan::typeToString(ExecutionNodeType type) const
       return "index_join";
   case ExecutionNodeType::do_nothing:
     return "do_nothing";
+  case ExecutionNodeType::materialized:
+    return "materialized";
+  case ExecutionNodeType::hash_join:
+    return "hash_join";
+  case ExecutionNodeType::band_join:
+    return "band_join";
+  case ExecutionNodeType::multiway_join:
+    return "multiway_join";
     default:
       return "<unknown>";
   }
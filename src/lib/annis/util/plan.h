@@ -27,13 +27,13 @@
 #include <utility>                      // for pair
 #include <vector>                       // for vector
 #include "annis/types.h"                // for Annotation, nodeid_t, Match (...
+#include "annis/iterators.h"            // for MatchBatch
 
 namespace annis { class ExactAnnoKeySearch; }
 namespace annis { class ExactAnnoValueSearch; }
 namespace annis { class RegexAnnoSearch; }
 namespace annis { class DB; }
 namespace annis { class EstimatedSearch; }
-namespace annis { class Iterator; }
 namespace annis { class Operator; }
 namespace annis { struct QueryConfig; }
 
@@ -47,6 +47,10 @@ enum ExecutionNodeType
   index_join,
   do_nothing,
   filter,
+  materialized,
+  hash_join,
+  band_join,
+  multiway_join,
   num_of_ExecutionNodeType
 };
 
@@ -84,6 +88,11 @@ struct ExecutionNode
   std::shared_ptr<ExecutionNode> rhs;
 
   std::shared_ptr<ExecutionEstimate> estimate;
+
+  /** Number of tuples this node produced while its output was observed during the execution */
+  std::uint64_t observedOutput;
+  /** True if the observed output are all tuples of this node */
+  bool observationComplete;
   
   std::string description;
 };
@@ -98,8 +107,18 @@ public:
   virtual ~Plan();
   
   bool executeStep(std::vector<Match>& result);
+  /**
+   * @brief Count all results of the plan without creating the result tuples.
+   * Must not be mixed with executeStep().
+   */
+  std::uint64_t count();
   double getCost();
 
+  std::shared_ptr<ExecutionNode> getRoot() const
+  {
+    return root;
+  }
+
   std::map<size_t, size_t> getOptimizedParallelizationMapping(const DB &db, QueryConfig config);
   
   static std::shared_ptr<ExecutionNode> join(std::shared_ptr<Operator> op,
@@ -118,8 +137,17 @@ public:
   static bool searchFilterReturnsNothing(std::shared_ptr<EstimatedSearch> search);
   
   static std::shared_ptr<ExecutionEstimate> estimateTupleSize(std::shared_ptr<ExecutionNode> node);
+
+  /**
+   * @brief The estimated fraction of the cross product of both operands which is included by the operator.
+   */
+  static long double operatorSelectivity(std::shared_ptr<Operator> op, std::uint64_t outputLHS, std::uint64_t outputRHS);
 private:
   std::shared_ptr<ExecutionNode> root;
+
+  /** The results of the root are fetched batch-wise and returned one by one by executeStep() */
+  MatchBatch resultBatch;
+  size_t resultBatchPos;
   
 private:
   static void clearCachedEstimate(std::shared_ptr<ExecutionNode> node);
@@ -147,6 +175,10 @@ private:
   static uint64_t calculateNestedLoopProcessed(uint64_t outputLHS, uint64_t outputRHS);
 
   static uint64_t calculateIndexJoinProcessed(long double operatorSelectivity, uint64_t outputLHS, uint64_t outputRHS);
+
+  static uint64_t calculateHashJoinProcessed(uint64_t outputLHS, uint64_t outputRHS);
+
+  static uint64_t calculateBandJoinProcessed(uint64_t outputLHS, uint64_t outputRHS);
 };
 
 } // end namespace annis
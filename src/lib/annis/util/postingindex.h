@@ -0,0 +1,341 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/util/postinglist.h>  // for PostingList
+#include <annis/util/size_estimator.h> // for element_size
+#include <annis/serializers.h>
+#include <google/btree_map.h>         // for btree_map
+#include <cstdint>                    // for uint32_t
+#include <stddef.h>                   // for size_t
+#include <iterator>                   // for forward_iterator_tag
+#include <utility>                    // for pair
+
+namespace annis
+{
+
+/**
+ * @brief Inverted index which maps a key to a sorted set of IDs.
+ *
+ * Keys with only one ID are stored in a plain map, keys with several IDs are stored as a delta-coded PostingList.
+ * The index can be iterated like a multimap of (key, ID) pairs ordered by key and ID, thus it can be used as a replacement
+ * for the inverse annotation map of an AnnoStorage.
+ */
+template<typename Key>
+class PostingIndex
+{
+  using SingleMap = btree::btree_map<Key, std::uint32_t>;
+  using MultiMap = btree::btree_map<Key, PostingList>;
+
+public:
+  using key_type = Key;
+  using value_type = std::pair<Key, std::uint32_t>;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PostingIndex::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() {}
+    const_iterator(typename SingleMap::const_iterator itSingle, typename SingleMap::const_iterator endSingle,
+                   typename MultiMap::const_iterator itMulti, typename MultiMap::const_iterator endMulti)
+      : itSingle(itSingle), endSingle(endSingle), itMulti(itMulti), endMulti(endMulti)
+    {
+      enterEntry();
+    }
+
+    reference operator*() const {return current;}
+    pointer operator->() const {return &current;}
+
+    const_iterator& operator++()
+    {
+      if(inMulti)
+      {
+        itList++;
+        if(itList != itMulti->second.end())
+        {
+          current.second = *itList;
+          return *this;
+        }
+        itMulti++;
+      }
+      else
+      {
+        itSingle++;
+      }
+      enterEntry();
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      const_iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return itSingle == other.itSingle && itMulti == other.itMulti
+          && (!inMulti || itList == other.itList);
+    }
+    bool operator!=(const const_iterator& other) const {return !(*this == other);}
+
+  private:
+    typename SingleMap::const_iterator itSingle;
+    typename SingleMap::const_iterator endSingle;
+    typename MultiMap::const_iterator itMulti;
+    typename MultiMap::const_iterator endMulti;
+    PostingList::const_iterator itList;
+    bool inMulti = false;
+    value_type current;
+
+  private:
+    /// Position the iterator on the smaller key of both maps.
+    void enterEntry()
+    {
+      inMulti = itMulti != endMulti && (itSingle == endSingle || itMulti->first < itSingle->first);
+      if(inMulti)
+      {
+        itList = itMulti->second.begin();
+        current = value_type(itMulti->first, *itList);
+      }
+      else if(itSingle != endSingle)
+      {
+        current = value_type(itSingle->first, itSingle->second);
+      }
+    }
+  };
+
+  using iterator = const_iterator;
+
+public:
+
+  PostingIndex() : numOfEntries(0) {}
+
+  const_iterator begin() const {return makeIterator(single.begin(), multi.begin());}
+  const_iterator end() const {return makeIterator(single.end(), multi.end());}
+
+  const_iterator lower_bound(const Key& key) const
+  {
+    return makeIterator(single.lower_bound(key), multi.lower_bound(key));
+  }
+
+  const_iterator upper_bound(const Key& key) const
+  {
+    return makeIterator(single.upper_bound(key), multi.upper_bound(key));
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(const Key& key) const
+  {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  const_iterator find(const Key& key) const
+  {
+    auto itSingle = single.find(key);
+    if(itSingle != single.end())
+    {
+      return makeIterator(itSingle, multi.lower_bound(key));
+    }
+    auto itMulti = multi.find(key);
+    if(itMulti != multi.end())
+    {
+      return makeIterator(single.lower_bound(key), itMulti);
+    }
+    return end();
+  }
+
+  /**
+   * @brief Get all IDs for a key as posting list.
+   */
+  PostingList postings(const Key& key) const
+  {
+    auto itSingle = single.find(key);
+    if(itSingle != single.end())
+    {
+      return PostingList(itSingle->second);
+    }
+    auto itMulti = multi.find(key);
+    if(itMulti != multi.end())
+    {
+      return itMulti->second;
+    }
+    return PostingList();
+  }
+
+  void insert(const value_type& entry)
+  {
+    auto itMulti = multi.find(entry.first);
+    if(itMulti != multi.end())
+    {
+      if(itMulti->second.add(entry.second))
+      {
+        numOfEntries++;
+      }
+      return;
+    }
+
+    auto itSingle = single.find(entry.first);
+    if(itSingle == single.end())
+    {
+      single.insert(entry);
+      numOfEntries++;
+    }
+    else if(itSingle->second != entry.second)
+    {
+      // convert to a posting list
+      PostingList l(itSingle->second);
+      l.add(entry.second);
+      single.erase(itSingle);
+      multi.insert({entry.first, l});
+      numOfEntries++;
+    }
+  }
+
+  template<typename InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    for(InputIterator it=first; it != last; it++)
+    {
+      insert(value_type(it->first, it->second));
+    }
+  }
+
+  /**
+   * @brief Remove all IDs of the given key.
+   * @return Number of removed entries.
+   */
+  size_t erase(const Key& key)
+  {
+    size_t removed = single.erase(key);
+    auto itMulti = multi.find(key);
+    if(itMulti != multi.end())
+    {
+      removed += itMulti->second.size();
+      multi.erase(itMulti);
+    }
+    numOfEntries -= removed;
+    return removed;
+  }
+
+  /**
+   * @brief Remove a single ID from the postings of a key.
+   */
+  bool erase(const Key& key, std::uint32_t id)
+  {
+    auto itSingle = single.find(key);
+    if(itSingle != single.end() && itSingle->second == id)
+    {
+      single.erase(itSingle);
+      numOfEntries--;
+      return true;
+    }
+    auto itMulti = multi.find(key);
+    if(itMulti != multi.end() && itMulti->second.remove(id))
+    {
+      if(itMulti->second.size() == 1)
+      {
+        std::uint32_t remaining = *(itMulti->second.begin());
+        multi.erase(itMulti);
+        single.insert({key, remaining});
+      }
+      numOfEntries--;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Number of IDs for all keys in the range [lower, upper].
+   *
+   * The posting lists are not decoded, only their sizes are used.
+   */
+  size_t count(const Key& lower, const Key& upper) const
+  {
+    size_t result = 0;
+    for(auto it = single.lower_bound(lower); it != single.end() && !(upper < it->first); it++)
+    {
+      result++;
+    }
+    for(auto it = multi.lower_bound(lower); it != multi.end() && !(upper < it->first); it++)
+    {
+      result += it->second.size();
+    }
+    return result;
+  }
+
+  size_t count(const Key& key) const
+  {
+    return count(key, key);
+  }
+
+  size_t size() const {return numOfEntries;}
+  bool empty() const {return numOfEntries == 0;}
+
+  void clear()
+  {
+    single.clear();
+    multi.clear();
+    numOfEntries = 0;
+  }
+
+  size_t estimateMemorySize() const
+  {
+    size_t listSize = 0;
+    for(const auto& e : multi)
+    {
+      listSize += e.second.estimateMemorySize() - sizeof(PostingList);
+    }
+    return single.bytes_used() + multi.bytes_used() + listSize;
+  }
+
+  template<class Archive>
+  void serialize(Archive & archive)
+  {
+    archive(numOfEntries, single, multi);
+  }
+
+private:
+  SingleMap single;
+  MultiMap multi;
+  size_t numOfEntries;
+
+private:
+  const_iterator makeIterator(typename SingleMap::const_iterator itSingle, typename MultiMap::const_iterator itMulti) const
+  {
+    return const_iterator(itSingle, single.end(), itMulti, multi.end());
+  }
+
+};
+
+namespace size_estimation
+{
+
+template<typename Key>
+size_t element_size(const PostingIndex<Key>& m)
+{
+  return m.estimateMemorySize();
+}
+
+}
+
+} // end namespace annis
@@ -0,0 +1,271 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "postinglist.h"
+
+#include <algorithm>  // for lower_bound, binary_search
+
+using namespace annis;
+
+const size_t PostingList::skipInterval;
+
+PostingList::PostingList()
+  : count(0), encodedCount(0), first(0), last(0)
+{
+}
+
+PostingList::PostingList(std::uint32_t id)
+  : count(1), encodedCount(1), first(id), last(id)
+{
+}
+
+PostingList PostingList::fromSorted(const std::vector<std::uint32_t> &ids)
+{
+  PostingList result;
+  for(std::uint32_t id : ids)
+  {
+    result.appendEncoded(id);
+  }
+  result.count = result.encodedCount;
+  return result;
+}
+
+bool PostingList::add(std::uint32_t id)
+{
+  auto itRemoved = std::lower_bound(pendingRemove.begin(), pendingRemove.end(), id);
+  if(itRemoved != pendingRemove.end() && *itRemoved == id)
+  {
+    // the ID is still part of the encoded list
+    pendingRemove.erase(itRemoved);
+    count++;
+    return true;
+  }
+
+  if(pendingAdd.empty() && (encodedCount == 0 || id > last))
+  {
+    appendEncoded(id);
+    count++;
+    return true;
+  }
+
+  if(encodedContains(id))
+  {
+    return false;
+  }
+  auto itAdded = std::lower_bound(pendingAdd.begin(), pendingAdd.end(), id);
+  if(itAdded != pendingAdd.end() && *itAdded == id)
+  {
+    return false;
+  }
+  pendingAdd.insert(itAdded, id);
+  count++;
+
+  if(pendingAdd.size() > maxPending())
+  {
+    merge();
+  }
+  return true;
+}
+
+bool PostingList::remove(std::uint32_t id)
+{
+  auto itAdded = std::lower_bound(pendingAdd.begin(), pendingAdd.end(), id);
+  if(itAdded != pendingAdd.end() && *itAdded == id)
+  {
+    pendingAdd.erase(itAdded);
+    count--;
+    return true;
+  }
+
+  if(!encodedContains(id))
+  {
+    return false;
+  }
+  auto itRemoved = std::lower_bound(pendingRemove.begin(), pendingRemove.end(), id);
+  if(itRemoved != pendingRemove.end() && *itRemoved == id)
+  {
+    return false;
+  }
+  pendingRemove.insert(itRemoved, id);
+  count--;
+
+  if(pendingRemove.size() > maxPending())
+  {
+    merge();
+  }
+  return true;
+}
+
+bool PostingList::contains(std::uint32_t id) const
+{
+  if(std::binary_search(pendingAdd.begin(), pendingAdd.end(), id))
+  {
+    return true;
+  }
+  if(std::binary_search(pendingRemove.begin(), pendingRemove.end(), id))
+  {
+    return false;
+  }
+  return encodedContains(id);
+}
+
+bool PostingList::encodedContains(std::uint32_t id) const
+{
+  if(encodedCount == 0 || id < first || id > last)
+  {
+    return false;
+  }
+
+  // start decoding at the last skip entry which is not larger than the ID
+  auto itSkip = std::upper_bound(skips.begin(), skips.end(), id,
+                                 [](std::uint32_t val, const Skip& skip) {return val < skip.value;});
+  std::uint32_t current = first;
+  size_t pos = 0;
+  size_t idx = 0;
+  if(itSkip != skips.begin())
+  {
+    itSkip--;
+    current = itSkip->value;
+    pos = itSkip->dataPos;
+    idx = (static_cast<size_t>(itSkip - skips.begin()) + 1) * skipInterval;
+  }
+
+  while(current < id && idx + 1 < encodedCount)
+  {
+    current += decodeDelta(pos);
+    idx++;
+  }
+  return current == id;
+}
+
+std::vector<std::uint32_t> PostingList::decode() const
+{
+  std::vector<std::uint32_t> result;
+  result.reserve(count);
+  result.insert(result.end(), begin(), end());
+  return result;
+}
+
+PostingList PostingList::intersect(const PostingList &a, const PostingList &b)
+{
+  PostingList result;
+  if(a.empty() || b.empty() || a.maxBound() < b.minBound() || b.maxBound() < a.minBound())
+  {
+    return result;
+  }
+
+  const_iterator itA = a.begin();
+  const_iterator itB = b.begin();
+  while(itA != a.end() && itB != b.end())
+  {
+    if(*itA < *itB)
+    {
+      itA++;
+    }
+    else if(*itB < *itA)
+    {
+      itB++;
+    }
+    else
+    {
+      result.add(*itA);
+      itA++;
+      itB++;
+    }
+  }
+  return result;
+}
+
+PostingList PostingList::unite(const PostingList &a, const PostingList &b)
+{
+  PostingList result;
+
+  const_iterator itA = a.begin();
+  const_iterator itB = b.begin();
+  while(itA != a.end() || itB != b.end())
+  {
+    if(itB == b.end() || (itA != a.end() && *itA < *itB))
+    {
+      result.add(*itA);
+      itA++;
+    }
+    else if(itA == a.end() || *itB < *itA)
+    {
+      result.add(*itB);
+      itB++;
+    }
+    else
+    {
+      result.add(*itA);
+      itA++;
+      itB++;
+    }
+  }
+  return result;
+}
+
+void PostingList::appendEncoded(std::uint32_t id)
+{
+  if(encodedCount == 0)
+  {
+    first = last = id;
+    encodedCount = 1;
+    deltas.clear();
+    skips.clear();
+    return;
+  }
+
+  appendDelta(id - last);
+  last = id;
+  if(encodedCount % skipInterval == 0)
+  {
+    skips.push_back({id, static_cast<std::uint32_t>(deltas.size())});
+  }
+  encodedCount++;
+}
+
+void PostingList::rebuildSkips()
+{
+  skips.clear();
+  size_t pos = 0;
+  std::uint32_t current = first;
+  for(size_t idx=1; idx < encodedCount; idx++)
+  {
+    current += decodeDelta(pos);
+    if(idx % skipInterval == 0)
+    {
+      skips.push_back({current, static_cast<std::uint32_t>(pos)});
+    }
+  }
+}
+
+void PostingList::merge()
+{
+  if(!pendingAdd.empty() || !pendingRemove.empty())
+  {
+    *this = fromSorted(decode());
+  }
+}
+
+void PostingList::appendDelta(std::uint32_t delta)
+{
+  while(delta >= 0x80)
+  {
+    deltas.push_back(static_cast<std::uint8_t>(delta & 0x7F) | 0x80);
+    delta >>= 7;
+  }
+  deltas.push_back(static_cast<std::uint8_t>(delta));
+}
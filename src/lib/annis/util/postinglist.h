@@ -0,0 +1,282 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>                // for max, min
+#include <cstdint>                  // for uint32_t, uint8_t
+#include <stddef.h>                 // for size_t
+#include <iterator>                 // for forward_iterator_tag
+#include <vector>                   // for vector
+
+#include <cereal/types/vector.hpp>
+
+namespace annis
+{
+
+/**
+ * @brief A sorted set of IDs which is stored as a delta-coded list.
+ *
+ * The first (smallest) ID is stored uncompressed, each following ID is stored as the variable-length
+ * encoded difference to its predecessor. A list with a single entry does not allocate any additional memory.
+ *
+ * For every skipInterval-th entry the value and the position in the delta array are stored as skip entry,
+ * thus contains() only has to decode a single block. IDs which are inserted out of order or removed are
+ * collected in small sorted buffers which are merged into the encoded list once they get too large.
+ */
+class PostingList
+{
+public:
+
+  static const size_t skipInterval = 64;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::uint32_t*;
+    using reference = const std::uint32_t&;
+
+    const_iterator() : list(nullptr), idx(0), encodedIdx(0), dataPos(0), currentEncoded(0),
+      addPos(0), removePos(0), fromAdded(false), current(0) {}
+    const_iterator(const PostingList* list, size_t idx)
+      : list(list), idx(idx), encodedIdx(0), dataPos(0), currentEncoded(list->first),
+        addPos(0), removePos(0), fromAdded(false), current(0)
+    {
+      if(idx < list->count)
+      {
+        select();
+      }
+    }
+
+    reference operator*() const {return current;}
+    pointer operator->() const {return &current;}
+
+    const_iterator& operator++()
+    {
+      idx++;
+      if(fromAdded)
+      {
+        addPos++;
+      }
+      else
+      {
+        nextEncoded();
+      }
+      if(idx < list->count)
+      {
+        select();
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      const_iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const const_iterator& other) const {return list == other.list && idx == other.idx;}
+    bool operator!=(const const_iterator& other) const {return !(*this == other);}
+
+  private:
+    const PostingList* list;
+    size_t idx;
+
+    size_t encodedIdx;
+    size_t dataPos;
+    std::uint32_t currentEncoded;
+    size_t addPos;
+    size_t removePos;
+    bool fromAdded;
+
+    std::uint32_t current;
+
+  private:
+    void nextEncoded()
+    {
+      encodedIdx++;
+      if(encodedIdx < list->encodedCount)
+      {
+        currentEncoded += list->decodeDelta(dataPos);
+      }
+    }
+
+    /// Merge the encoded entries which have not been removed with the buffered ones.
+    void select()
+    {
+      const std::vector<std::uint32_t>& removed = list->pendingRemove;
+      while(encodedIdx < list->encodedCount)
+      {
+        while(removePos < removed.size() && removed[removePos] < currentEncoded)
+        {
+          removePos++;
+        }
+        if(removePos < removed.size() && removed[removePos] == currentEncoded)
+        {
+          nextEncoded();
+        }
+        else
+        {
+          break;
+        }
+      }
+
+      const std::vector<std::uint32_t>& added = list->pendingAdd;
+      fromAdded = addPos < added.size()
+          && (encodedIdx >= list->encodedCount || added[addPos] < currentEncoded);
+      current = fromAdded ? added[addPos] : currentEncoded;
+    }
+  };
+
+public:
+  PostingList();
+  PostingList(std::uint32_t id);
+
+  /**
+   * @brief Create a list from IDs which are already sorted and unique.
+   */
+  static PostingList fromSorted(const std::vector<std::uint32_t>& ids);
+
+  /**
+   * @brief Adds an ID. Appending an ID which is larger than all existing ones is cheap, all other inserts
+   * are buffered until the list is re-encoded.
+   * @return false if the ID already existed.
+   */
+  bool add(std::uint32_t id);
+  /**
+   * @return false if the ID did not exist.
+   */
+  bool remove(std::uint32_t id);
+  bool contains(std::uint32_t id) const;
+
+  size_t size() const {return count;}
+  bool empty() const {return count == 0;}
+
+  const_iterator begin() const {return const_iterator(this, 0);}
+  const_iterator end() const {return const_iterator(this, count);}
+
+  std::vector<std::uint32_t> decode() const;
+
+  static PostingList intersect(const PostingList& a, const PostingList& b);
+  static PostingList unite(const PostingList& a, const PostingList& b);
+
+  size_t estimateMemorySize() const
+  {
+    return sizeof(PostingList) + deltas.capacity() + (skips.capacity() * sizeof(Skip))
+        + ((pendingAdd.capacity() + pendingRemove.capacity()) * sizeof(std::uint32_t));
+  }
+
+  template<class Archive>
+  void save(Archive & archive) const
+  {
+    if(pendingAdd.empty() && pendingRemove.empty())
+    {
+      archive(count, first, last, deltas);
+    }
+    else
+    {
+      PostingList merged = fromSorted(decode());
+      archive(merged.count, merged.first, merged.last, merged.deltas);
+    }
+  }
+
+  template<class Archive>
+  void load(Archive & archive)
+  {
+    archive(count, first, last, deltas);
+    encodedCount = count;
+    pendingAdd.clear();
+    pendingRemove.clear();
+    rebuildSkips();
+  }
+
+private:
+
+  struct Skip
+  {
+    std::uint32_t value;
+    /** Position of the delta of the entry after this one */
+    std::uint32_t dataPos;
+  };
+
+  /** Number of IDs including the buffered changes */
+  std::uint32_t count;
+
+  std::uint32_t encodedCount;
+  std::uint32_t first;
+  std::uint32_t last;
+  std::vector<std::uint8_t> deltas;
+  /** Skip entry for each encoded entry with an index of k*skipInterval (k > 0) */
+  std::vector<Skip> skips;
+
+  /** Sorted IDs which are not part of the encoded list yet */
+  std::vector<std::uint32_t> pendingAdd;
+  /** Sorted IDs of the encoded list which have been removed */
+  std::vector<std::uint32_t> pendingRemove;
+
+private:
+  void appendEncoded(std::uint32_t id);
+  void appendDelta(std::uint32_t delta);
+  void rebuildSkips();
+  bool encodedContains(std::uint32_t id) const;
+  /** Re-encode the list with the buffered changes. */
+  void merge();
+
+  size_t maxPending() const
+  {
+    return std::max<size_t>(skipInterval, std::min<size_t>(encodedCount / 8, 4096));
+  }
+
+  /** An ID which is not larger than the smallest ID of the list. */
+  std::uint32_t minBound() const
+  {
+    if(encodedCount > 0 && (pendingAdd.empty() || first < pendingAdd.front()))
+    {
+      return first;
+    }
+    return pendingAdd.empty() ? 0 : pendingAdd.front();
+  }
+
+  /** An ID which is not smaller than the largest ID of the list. */
+  std::uint32_t maxBound() const
+  {
+    if(encodedCount > 0 && (pendingAdd.empty() || last > pendingAdd.back()))
+    {
+      return last;
+    }
+    return pendingAdd.empty() ? 0 : pendingAdd.back();
+  }
+
+  std::uint32_t decodeDelta(size_t& pos) const
+  {
+    std::uint32_t result = 0;
+    int shift = 0;
+    std::uint8_t b;
+    do
+    {
+      b = deltas[pos++];
+      result |= static_cast<std::uint32_t>(b & 0x7F) << shift;
+      shift += 7;
+    } while(b & 0x80);
+    return result;
+  }
+};
+
+} // end namespace annis
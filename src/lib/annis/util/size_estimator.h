@@ -2,6 +2,7 @@
 
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
@@ -9,6 +10,8 @@
 #include <google/btree_map.h>
 #include <google/btree_set.h>
 
+#include <annis/util/mappablevector.h>
+
 namespace annis
 {
 /**
@@ -26,6 +29,18 @@ size_t element_size(const std::unordered_map<Key, Value>& m)
 ;
 }
 
+template<typename Value>
+size_t element_size(const std::vector<Value>& m)
+{
+  return (m.capacity() * sizeof(Value)); // allocated elements
+}
+
+template<typename Value>
+size_t element_size(const MappableVector<Value>& m)
+{
+  return m.heapSize(); // mapped elements are part of the page cache
+}
+
 template<typename Key>
 size_t element_size(const boost::container::flat_set<Key>& m)
 {
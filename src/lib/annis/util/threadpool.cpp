@@ -18,52 +18,121 @@
 
 using namespace annis;
 
+thread_local const ThreadPool* ThreadPool::currentPool = nullptr;
+thread_local size_t ThreadPool::currentWorkerIdx = 0;
+
 ThreadPool::ThreadPool(size_t numOfThreads)
-  : tasksClosed(false)
+  : tasksClosed(false), numOfQueuedTasks(0), nextQueue(0)
 {
-  worker.reserve(numOfThreads);
+  // there is always at least one queue, even if there is no worker to execute the tasks
+  queues.reserve(std::max<size_t>(numOfThreads, 1));
+  for(size_t i=0; i < std::max<size_t>(numOfThreads, 1); i++)
+  {
+    queues.emplace_back(new WorkerQueue());
+  }
 
+  worker.reserve(numOfThreads);
   for(size_t i=0; i < numOfThreads; i++)
   {
-    worker.emplace_back([this]()
+    worker.emplace_back([this, i]()
     {
-
-      std::function<void()> f;
-      while(true)
-      {
-        // test if there is a new task available or if the task list was closed
-        {
-          std::unique_lock<std::mutex> lock(this->mutex_tasks);
-
-          // only wait if the task list is empty right now
-          if(!this->tasksClosed && this->tasks.empty())
-          {
-            this->cond_tasks.wait(lock, [this] {return this->tasksClosed || !this->tasks.empty();});
-          }
-          if(this->tasksClosed)
-          {
-            return;
-          }
-
-
-          f = std::move(this->tasks.front());
-          this->tasks.pop_front();
-        }
-        f();
-
-      }
+      workerLoop(i);
     });
   }
 }
 
+void ThreadPool::push(std::function<void()>&& task)
+{
+  const size_t queueIdx = currentPool == this ? currentWorkerIdx : (nextQueue++ % queues.size());
+
+  numOfQueuedTasks++;
+  {
+    std::lock_guard<std::mutex> lock(queues[queueIdx]->mutex);
+    queues[queueIdx]->tasks.emplace_back(std::move(task));
+  }
+
+  {
+    // synchronize with workers which are about to wait
+    std::lock_guard<std::mutex> lock(mutex_idle);
+  }
+  cond_idle.notify_one();
+}
+
+bool ThreadPool::pop(size_t workerIdx, std::function<void()>& task)
+{
+  // own queue: newest task first since its data is most likely still in the cache
+  {
+    WorkerQueue& q = *queues[workerIdx];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if(!q.tasks.empty())
+    {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      numOfQueuedTasks--;
+      return true;
+    }
+  }
+
+  // steal the oldest task from the other queues
+  for(size_t i=1; i < queues.size(); i++)
+  {
+    WorkerQueue& q = *queues[(workerIdx + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if(!q.tasks.empty())
+    {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      numOfQueuedTasks--;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::runPendingTask()
+{
+  std::function<void()> f;
+  if(pop(currentPool == this ? currentWorkerIdx : 0, f))
+  {
+    f();
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(size_t workerIdx)
+{
+  currentPool = this;
+  currentWorkerIdx = workerIdx;
+
+  std::function<void()> f;
+  while(true)
+  {
+    if(pop(workerIdx, f))
+    {
+      f();
+      f = nullptr;
+    }
+    else if(tasksClosed)
+    {
+      // all queued tasks have been executed
+      break;
+    }
+    else
+    {
+      // only wait if there is no task in any queue right now
+      std::unique_lock<std::mutex> lock(mutex_idle);
+      cond_idle.wait(lock, [this] {return tasksClosed || numOfQueuedTasks > 0;});
+    }
+  }
+}
+
 annis::ThreadPool::~ThreadPool()
 {
   {
-    std::lock_guard<std::mutex> lock(mutex_tasks);
+    std::lock_guard<std::mutex> lock(mutex_idle);
     tasksClosed = true;
-    tasks.clear();
-
-    cond_tasks.notify_all();
+    cond_idle.notify_all();
   }
 
   // make sure each thread is actually finished
@@ -74,4 +143,13 @@ annis::ThreadPool::~ThreadPool()
       worker[i].join();
     }
   }
+
+  // The workers execute all queued tasks before they finish, but a pool without workers or a task which was enqueued
+  // after its worker finished still leaves tasks in the queues. Execute them here so no one waits forever for a result.
+  std::function<void()> f;
+  while(pop(0, f))
+  {
+    f();
+    f = nullptr;
+  }
 }
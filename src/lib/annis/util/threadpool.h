@@ -18,11 +18,13 @@
 
 #include <stddef.h>            // for size_t
 #include <algorithm>           // for forward
+#include <chrono>              // for seconds, microseconds
+#include <atomic>              // for atomic
 #include <condition_variable>  // for condition_variable
 #include <deque>               // for deque
 #include <functional>          // for function, bind
 #include <future>              // for future, packaged_task
-#include <memory>              // for make_shared
+#include <memory>              // for make_shared, unique_ptr
 #include <mutex>               // for mutex, lock_guard
 #include <thread>              // for thread
 #include <type_traits>         // for result_of
@@ -31,6 +33,16 @@
 namespace annis
 {
 
+/**
+ * @brief A work-stealing thread pool.
+ *
+ * Each worker has its own task queue. Tasks which are enqueued by a worker of this pool are added to the queue
+ * of this worker (task affinity), other tasks are distributed round-robin. A worker executes the newest task of its
+ * own queue first and steals the oldest task of another queue if its own queue is empty.
+ *
+ * Long running tasks should be split into smaller tasks which enqueue their continuation, so several
+ * queries can share the workers.
+ */
 class ThreadPool
 {
 public:
@@ -48,28 +60,71 @@ public:
 
     std::future<return_type> res = newTask->get_future();
 
-    {
-      std::lock_guard<std::mutex> lock(mutex_tasks);
-      tasks.emplace_back([newTask](){ (*newTask)(); });
+    push([newTask](){ (*newTask)(); });
+
+    return res;
+  }
 
+  /**
+   * @brief Wait for the result of a task and execute other queued tasks of this pool in the meantime.
+   *
+   * This must be used instead of std::future::get() if the waiting thread might be a worker of this pool,
+   * otherwise all workers could block while waiting for tasks which are never started.
+   */
+  template<class T>
+  T waitFor(std::future<T>& f)
+  {
+    while(f.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+      if(!runPendingTask())
+      {
+        f.wait_for(std::chrono::microseconds(100));
+      }
     }
-    cond_tasks.notify_one();
+    return f.get();
+  }
 
-    return res;
+  size_t numOfThreads() const
+  {
+    return worker.size();
   }
 
+  /**
+   * @brief Executes all tasks which are still queued and waits for the workers to finish.
+   */
   ~ThreadPool();
 
 private:
 
-  bool tasksClosed;
-  std::deque<std::function<void()>> tasks;
-  std::mutex mutex_tasks;
-  std::condition_variable cond_tasks;
+  struct WorkerQueue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void push(std::function<void()>&& task);
+  bool pop(size_t workerIdx, std::function<void()>& task);
+  /** Execute a single queued task in the current thread, returns false if there was none. */
+  bool runPendingTask();
+  void workerLoop(size_t workerIdx);
+
+private:
+
+  std::atomic_bool tasksClosed;
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+  /** Number of tasks in all queues, is increased before and decreased after a task is added or removed */
+  std::atomic<size_t> numOfQueuedTasks;
+  std::atomic<size_t> nextQueue;
 
+  std::mutex mutex_idle;
+  std::condition_variable cond_idle;
 
   std::vector<std::thread> worker;
 
+  /** The pool and queue index of the current thread if it is a worker */
+  static thread_local const ThreadPool* currentPool;
+  static thread_local size_t currentWorkerIdx;
 
 };
 } // end namespace annis
@@ -0,0 +1,346 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "tokenindex.h"
+
+#include <annis/annosearch/exactannokeysearch.h>  // for ExactAnnoKeySearch
+#include <annis/db.h>                             // for DB
+#include <annis/graphstorage/graphstorage.h>      // for ReadableGraphStorage
+#include <algorithm>                              // for sort, lower_bound
+#include <tuple>                                  // for tie
+
+using namespace annis;
+
+const nodeid_t TokenIndex::noToken = std::numeric_limits<nodeid_t>::max();
+const std::uint32_t TokenIndex::noTreeNode = std::numeric_limits<std::uint32_t>::max();
+
+std::shared_ptr<const TokenIndex> TokenIndex::build(const DB &db)
+{
+  std::shared_ptr<TokenIndex> result(new TokenIndex());
+
+  std::shared_ptr<const ReadableGraphStorage> gsLeft = db.f_getGraphStorage(ComponentType::LEFT_TOKEN, annis_ns, "");
+  std::shared_ptr<const ReadableGraphStorage> gsRight = db.f_getGraphStorage(ComponentType::RIGHT_TOKEN, annis_ns, "");
+  std::shared_ptr<const ReadableGraphStorage> gsCoverage = db.f_getGraphStorage(ComponentType::COVERAGE, annis_ns, "");
+  std::shared_ptr<const ReadableGraphStorage> gsOrder = db.f_getGraphStorage(ComponentType::ORDERING, annis_ns, "");
+
+  const size_t numOfNodes = db.nextFreeNodeID();
+  result->isTokenBitmap.assign(numOfNodes, false);
+  result->leftToken.assign(numOfNodes, noToken);
+  result->rightToken.assign(numOfNodes, noToken);
+
+  std::vector<nodeid_t> tokens;
+
+  // a token has the token annotation and does not cover any other node
+  ExactAnnoKeySearch tokenSearch(db, annis_ns, annis_tok);
+  Match m;
+  while(tokenSearch.next(m))
+  {
+    const nodeid_t n = m.node;
+    if(n < numOfNodes && !result->isTokenBitmap[n] && (!gsCoverage || gsCoverage->getOutgoingEdges(n).empty()))
+    {
+      result->isTokenBitmap[n] = true;
+      result->leftToken[n] = n;
+      result->rightToken[n] = n;
+      tokens.push_back(n);
+    }
+  }
+
+  ExactAnnoKeySearch nodeSearch(db, annis_ns, annis_node_name);
+  while(nodeSearch.next(m))
+  {
+    const nodeid_t n = m.node;
+    if(n < numOfNodes && !result->isTokenBitmap[n])
+    {
+      if(gsLeft)
+      {
+        std::vector<nodeid_t> out = gsLeft->getOutgoingEdges(n);
+        if(!out.empty())
+        {
+          result->leftToken[n] = out[0];
+        }
+      }
+      if(gsRight)
+      {
+        std::vector<nodeid_t> out = gsRight->getOutgoingEdges(n);
+        if(!out.empty())
+        {
+          result->rightToken[n] = out[0];
+        }
+      }
+    }
+  }
+
+  // calculate the position of each token in its text, this is only possible if the order is a set of linear chains
+  bool valid = gsOrder ? true : false;
+  std::vector<nodeid_t> nextToken;
+  std::vector<bool> hasPredecessor;
+  if(valid)
+  {
+    nextToken.assign(numOfNodes, noToken);
+    hasPredecessor.assign(numOfNodes, false);
+    for(auto it = tokens.begin(); valid && it != tokens.end(); it++)
+    {
+      std::vector<nodeid_t> out = gsOrder->getOutgoingEdges(*it);
+      if(out.size() > 1)
+      {
+        valid = false;
+      }
+      else if(out.size() == 1)
+      {
+        const nodeid_t target = out[0];
+        if(target >= numOfNodes || !result->isTokenBitmap[target] || hasPredecessor[target])
+        {
+          valid = false;
+        }
+        else
+        {
+          nextToken[*it] = target;
+          hasPredecessor[target] = true;
+        }
+      }
+    }
+  }
+
+  if(valid)
+  {
+    result->text.assign(numOfNodes, noToken);
+    result->position.assign(numOfNodes, 0);
+
+    size_t numOfVisited = 0;
+    for(nodeid_t t : tokens)
+    {
+      if(!hasPredecessor[t])
+      {
+        std::uint32_t pos = 0;
+        for(nodeid_t current = t; current != noToken; current = nextToken[current])
+        {
+          result->text[current] = t;
+          result->position[current] = pos++;
+          numOfVisited++;
+        }
+      }
+    }
+    // tokens which are not reachable from a first token must be part of a cycle
+    valid = numOfVisited == tokens.size();
+  }
+
+  if(valid)
+  {
+    result->positionsValid = true;
+    result->buildIntervals();
+  }
+  else
+  {
+    result->text.clear();
+    result->text.shrink_to_fit();
+    result->position.clear();
+    result->position.shrink_to_fit();
+  }
+
+  return result;
+}
+
+void TokenIndex::buildIntervals()
+{
+  intervals.clear();
+  intervalsByText.clear();
+  tree.clear();
+  treeByStart.clear();
+  treeByEnd.clear();
+
+  // every node with a left and right token in the same text is a range of token positions
+  for(nodeid_t n=0; n < leftToken.size(); n++)
+  {
+    const nodeid_t l = leftToken[n];
+    const nodeid_t r = rightToken[n];
+    if(l != noToken && r != noToken && text[l] != noToken && text[l] == text[r] && position[l] <= position[r])
+    {
+      intervals.push_back({position[l], position[r], n});
+    }
+  }
+
+  std::sort(intervals.begin(), intervals.end(), [this](const Interval& a, const Interval& b)
+  {
+    const nodeid_t textA = text[leftToken[a.node]];
+    const nodeid_t textB = text[leftToken[b.node]];
+    return std::tie(textA, a.start, a.end, a.node) < std::tie(textB, b.start, b.end, b.node);
+  });
+
+  for(size_t i=0; i < intervals.size(); i++)
+  {
+    const nodeid_t t = text[leftToken[intervals[i].node]];
+    auto itText = intervalsByText.find(t);
+    if(itText == intervalsByText.end())
+    {
+      itText = intervalsByText.insert({t, {i, i, noTreeNode}}).first;
+    }
+    itText->second.end = i + 1;
+  }
+  for(auto& t : intervalsByText)
+  {
+    t.second.tree = buildTree(std::vector<Interval>(intervals.begin() + t.second.begin,
+                                                    intervals.begin() + t.second.end));
+  }
+
+  intervals.shrink_to_fit();
+  tree.shrink_to_fit();
+  treeByStart.shrink_to_fit();
+  treeByEnd.shrink_to_fit();
+}
+
+std::uint32_t TokenIndex::buildTree(std::vector<Interval> items)
+{
+  if(items.empty())
+  {
+    return noTreeNode;
+  }
+
+  // the start of the median interval is contained in its own interval, so each node has at least one interval
+  // and each subtree at most half of the intervals
+  const std::uint32_t center = items[items.size() / 2].start;
+  std::vector<Interval> leftItems;
+  std::vector<Interval> rightItems;
+
+  const std::uint32_t nodeIdx = static_cast<std::uint32_t>(tree.size());
+  tree.push_back({center, treeByStart.size(), treeByStart.size(), noTreeNode, noTreeNode});
+  for(const Interval& i : items)
+  {
+    if(i.end < center)
+    {
+      leftItems.push_back(i);
+    }
+    else if(i.start > center)
+    {
+      rightItems.push_back(i);
+    }
+    else
+    {
+      // the items are already sorted by their start
+      treeByStart.push_back(i);
+      treeByEnd.push_back(i);
+    }
+  }
+  tree[nodeIdx].end = treeByStart.size();
+  std::sort(treeByEnd.begin() + tree[nodeIdx].begin, treeByEnd.end(), [](const Interval& a, const Interval& b)
+  {
+    return a.end > b.end;
+  });
+  items.clear();
+  items.shrink_to_fit();
+
+  const std::uint32_t left = buildTree(std::move(leftItems));
+  tree[nodeIdx].left = left;
+  const std::uint32_t right = buildTree(std::move(rightItems));
+  tree[nodeIdx].right = right;
+  return nodeIdx;
+}
+
+const TokenIndex::TextIntervals* TokenIndex::findTextIntervals(nodeid_t leftToken, nodeid_t rightToken) const
+{
+  const nodeid_t t = textOf(leftToken);
+  if(t == noToken || textOf(rightToken) != t || position[leftToken] > position[rightToken])
+  {
+    return nullptr;
+  }
+  auto itText = intervalsByText.find(t);
+  if(itText == intervalsByText.end())
+  {
+    return nullptr;
+  }
+  return &itText->second;
+}
+
+bool TokenIndex::findOverlapping(nodeid_t leftToken, nodeid_t rightToken, std::vector<nodeid_t>& result) const
+{
+  const TextIntervals* textIntervals = findTextIntervals(leftToken, rightToken);
+  if(!textIntervals)
+  {
+    return false;
+  }
+  const std::uint32_t start = position[leftToken];
+  const std::uint32_t end = position[rightToken];
+
+  // all intervals which start inside the range overlap it
+  auto it = std::lower_bound(intervals.begin() + textIntervals->begin, intervals.begin() + textIntervals->end, start,
+                             [](const Interval& i, std::uint32_t pos) {return i.start < pos;});
+  for(; it != intervals.begin() + textIntervals->end && it->start <= end; it++)
+  {
+    result.push_back(it->node);
+  }
+
+  // the ones which start before the range overlap it if they contain its start
+  std::uint32_t nodeIdx = textIntervals->tree;
+  while(nodeIdx != noTreeNode)
+  {
+    const TreeNode& n = tree[nodeIdx];
+    if(start <= n.center)
+    {
+      // all intervals of the node end at or after the center
+      for(size_t i=n.begin; i < n.end && treeByStart[i].start < start; i++)
+      {
+        result.push_back(treeByStart[i].node);
+      }
+      // the intervals of the right subtree start after the center
+      nodeIdx = start < n.center ? n.left : noTreeNode;
+    }
+    else
+    {
+      // all intervals of the node start at or before the center
+      for(size_t i=n.begin; i < n.end && treeByEnd[i].end >= start; i++)
+      {
+        result.push_back(treeByEnd[i].node);
+      }
+      nodeIdx = n.right;
+    }
+  }
+  return true;
+}
+
+bool TokenIndex::findIncluded(nodeid_t leftToken, nodeid_t rightToken, std::vector<nodeid_t>& result) const
+{
+  const TextIntervals* textIntervals = findTextIntervals(leftToken, rightToken);
+  if(!textIntervals)
+  {
+    return false;
+  }
+  const std::uint32_t start = position[leftToken];
+  const std::uint32_t end = position[rightToken];
+
+  auto it = std::lower_bound(intervals.begin() + textIntervals->begin, intervals.begin() + textIntervals->end, start,
+                             [](const Interval& i, std::uint32_t pos) {return i.start < pos;});
+  for(; it != intervals.begin() + textIntervals->end && it->start <= end; it++)
+  {
+    if(it->end <= end)
+    {
+      result.push_back(it->node);
+    }
+  }
+  return true;
+}
+
+size_t TokenIndex::estimateMemorySize() const
+{
+  return (isTokenBitmap.capacity() / 8)
+      + (leftToken.capacity() * sizeof(nodeid_t))
+      + (rightToken.capacity() * sizeof(nodeid_t))
+      + (text.capacity() * sizeof(nodeid_t))
+      + (position.capacity() * sizeof(std::uint32_t))
+      + (intervals.capacity() * sizeof(Interval))
+      + (tree.capacity() * sizeof(TreeNode))
+      + ((treeByStart.capacity() + treeByEnd.capacity()) * sizeof(Interval))
+      + (intervalsByText.size() * (sizeof(nodeid_t) + sizeof(TextIntervals)))
+      + sizeof(TokenIndex);
+}
@@ -0,0 +1,208 @@
+/*
+   Copyright 2017 Thomas Krause <thomaskrause@posteo.de>
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#pragma once
+
+#include <annis/types.h>  // for nodeid_t
+#include <stddef.h>       // for size_t
+#include <cstdint>        // for uint32_t
+#include <limits>         // for numeric_limits
+#include <memory>         // for shared_ptr
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+namespace annis { class DB; }
+
+namespace annis
+{
+
+/**
+ * @brief Dense per-node index of the token related information.
+ *
+ * For each node ID it stores if the node is a token, its left and right token and for each token
+ * its text (the first token of its chain in the default ORDERING component) and its position inside this text.
+ * This allows to answer the questions of the TokenHelper and the token order with array lookups
+ * instead of searching the graph storages.
+ *
+ * If the positions are valid, the token range of every node is also stored as interval of positions in its text.
+ * The intervals are sorted by their start, which allows to find included nodes by scanning only the intervals that
+ * start inside the searched range. Intervals which start before the searched range and still overlap it are found
+ * with a centered interval tree per text, so both searches only depend on the size of their result.
+ *
+ * The index is a snapshot and has to be rebuilt whenever the node annotations or the token related components change.
+ */
+class TokenIndex
+{
+public:
+
+  static const nodeid_t noToken;
+
+  /**
+   * @brief Create the index from the node annotations and the COVERAGE, LEFT_TOKEN, RIGHT_TOKEN and ORDERING components.
+   */
+  static std::shared_ptr<const TokenIndex> build(const DB& db);
+
+  /**
+   * @brief True if this node is included in the index, any other node must be checked with the graph storages.
+   */
+  bool contains(nodeid_t n) const
+  {
+    return n < leftToken.size();
+  }
+
+  bool isToken(nodeid_t n) const
+  {
+    return isTokenBitmap[n];
+  }
+
+  /**
+   * @return The left-most covered token or noToken if there is none.
+   */
+  nodeid_t left(nodeid_t n) const
+  {
+    return leftToken[n];
+  }
+
+  /**
+   * @return The right-most covered token or noToken if there is none.
+   */
+  nodeid_t right(nodeid_t n) const
+  {
+    return rightToken[n];
+  }
+
+  /**
+   * @brief True if each text has a single linear token order and thus the token positions are valid.
+   */
+  bool hasPositions() const
+  {
+    return positionsValid;
+  }
+
+  /**
+   * @brief Number of ORDERING edges from one token to another.
+   * @return -1 if the second token is not reachable from the first one.
+   */
+  int distance(nodeid_t fromToken, nodeid_t toToken) const
+  {
+    if(fromToken < text.size() && toToken < text.size()
+       && text[fromToken] != noToken && text[fromToken] == text[toToken] && position[fromToken] <= position[toToken])
+    {
+      return static_cast<int>(position[toToken] - position[fromToken]);
+    }
+    return -1;
+  }
+
+  bool isConnected(nodeid_t fromToken, nodeid_t toToken, unsigned int minDistance, unsigned int maxDistance) const
+  {
+    const int dist = distance(fromToken, toToken);
+    return dist >= 0 && static_cast<unsigned int>(dist) >= minDistance && static_cast<unsigned int>(dist) <= maxDistance;
+  }
+
+  /**
+   * @return The first token of the text of this token or noToken if the token has no valid position.
+   */
+  nodeid_t textOf(nodeid_t token) const
+  {
+    return token < text.size() ? text[token] : noToken;
+  }
+
+  /**
+   * @brief Position of a token inside its text, only valid if textOf() is not noToken.
+   */
+  std::uint32_t positionOf(nodeid_t token) const
+  {
+    return position[token];
+  }
+
+  /**
+   * @brief Find all nodes whose token range overlaps the range from the left to the right token.
+   * @return False if the range is not part of the interval index and the nodes must be searched in the graph storages.
+   */
+  bool findOverlapping(nodeid_t leftToken, nodeid_t rightToken, std::vector<nodeid_t>& result) const;
+
+  /**
+   * @brief Find all nodes whose token range is included in the range from the left to the right token.
+   * @return False if the range is not part of the interval index and the nodes must be searched in the graph storages.
+   */
+  bool findIncluded(nodeid_t leftToken, nodeid_t rightToken, std::vector<nodeid_t>& result) const;
+
+  size_t estimateMemorySize() const;
+
+private:
+  TokenIndex() : positionsValid(false) {}
+
+  std::vector<bool> isTokenBitmap;
+  std::vector<nodeid_t> leftToken;
+  std::vector<nodeid_t> rightToken;
+
+  /** The first token of the text (noToken for non-token nodes) */
+  std::vector<nodeid_t> text;
+  std::vector<std::uint32_t> position;
+
+  struct Interval
+  {
+    std::uint32_t start;
+    std::uint32_t end;
+    nodeid_t node;
+  };
+
+  struct TextIntervals
+  {
+    /** Range of the intervals of this text in the interval array */
+    size_t begin;
+    size_t end;
+    /** Root of the interval tree of this text, noTreeNode if there are no intervals */
+    std::uint32_t tree;
+  };
+
+  /**
+   * @brief A node of a centered interval tree.
+   *
+   * The node holds all intervals which contain its center position, intervals which end before the center are
+   * in the left and intervals which start after the center in the right subtree.
+   */
+  struct TreeNode
+  {
+    std::uint32_t center;
+    /** Range of the intervals of this node in treeByStart and treeByEnd */
+    size_t begin;
+    size_t end;
+    std::uint32_t left;
+    std::uint32_t right;
+  };
+  static const std::uint32_t noTreeNode;
+
+  /** All intervals sorted by text and start position */
+  std::vector<Interval> intervals;
+  std::unordered_map<nodeid_t, TextIntervals> intervalsByText;
+
+  std::vector<TreeNode> tree;
+  /** The intervals of each tree node sorted ascending by their start */
+  std::vector<Interval> treeByStart;
+  /** The intervals of each tree node sorted descending by their end */
+  std::vector<Interval> treeByEnd;
+
+  bool positionsValid;
+
+private:
+  void buildIntervals();
+  /** Add the tree for the given intervals, which must be sorted by their start, and return the index of its root */
+  std::uint32_t buildTree(std::vector<Interval> items);
+  const TextIntervals* findTextIntervals(nodeid_t leftToken, nodeid_t rightToken) const;
+};
+
+} // end namespace annis
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/util/plan.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class AdaptiveReoptimizationTest : public TokenSequenceTest
+{
+};
+
+TEST_F(AdaptiveReoptimizationTest, FirstJoinTooLarge)
+{
+  // without statistics the estimation for each join is only a single result
+  auto createSequence = [this](const QueryConfig& config)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    for(size_t i=0; i < 4; i++)
+    {
+      q->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t" + std::to_string(i+1)));
+    }
+    for(size_t i=1; i < 4; i++)
+    {
+      q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1), i-1, i);
+    }
+    return q;
+  };
+  // the number of buffered results of the first join as shown in the plan
+  auto observedOutput = [](std::shared_ptr<SingleAlternativeQuery> q) -> long long
+  {
+    const std::string plan = q->getBestPlan()->debugString();
+    const size_t pos = plan.find("[observed: ");
+    return pos == std::string::npos ? -1 : std::stoll(plan.substr(pos + 11));
+  };
+
+  QueryConfig configStatic;
+  configStatic.adaptive_reoptimization = false;
+  std::shared_ptr<SingleAlternativeQuery> queryStatic = createSequence(configStatic);
+  const std::vector<std::vector<nodeid_t>> expected = sequenceTuples(1, 4);
+  ASSERT_EQ(numOfToken / 10, expected.size());
+  EXPECT_EQ(expected, collectNodeTuples(queryStatic));
+  EXPECT_EQ(-1, observedOutput(queryStatic));
+
+  std::shared_ptr<SingleAlternativeQuery> q = createSequence(QueryConfig());
+  EXPECT_EQ(expected, collectNodeTuples(q));
+  // the first join has 300 instead of a single result, the buffering stops after the first batch which
+  // exceeds the estimation by the factor
+  const long long observed = observedOutput(q);
+  EXPECT_GT(observed, 10);
+  EXPECT_LE(observed, static_cast<long long>(MatchBatch::defaultCapacity));
+
+  // a much larger tolerance is limited by the maximal number of buffered results
+  auto createTokenSequence = [this](const QueryConfig& config)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    for(size_t i=0; i < 3; i++)
+    {
+      q->addNode(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok));
+    }
+    for(size_t i=1; i < 3; i++)
+    {
+      q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1), i-1, i);
+    }
+    return q;
+  };
+  QueryConfig configUnlimited;
+  configUnlimited.adaptive_reoptimization_factor = 100000.0;
+  configUnlimited.adaptive_reoptimization_max_observed = 100000;
+  std::shared_ptr<SingleAlternativeQuery> queryUnlimited = createTokenSequence(configUnlimited);
+  // each token except the last two starts a sequence of three token
+  std::vector<std::vector<nodeid_t>> expectedTokens;
+  for(nodeid_t n=1; n + 2 <= numOfToken; n++)
+  {
+    expectedTokens.push_back({n, n+1, n+2});
+  }
+  EXPECT_EQ(expectedTokens, collectNodeTuples(queryUnlimited));
+  EXPECT_EQ(numOfToken - 1, observedOutput(queryUnlimited));
+
+  QueryConfig configLimited = configUnlimited;
+  configLimited.adaptive_reoptimization_max_observed = 5;
+  std::shared_ptr<SingleAlternativeQuery> queryLimited = createTokenSequence(configLimited);
+  EXPECT_EQ(expectedTokens, collectNodeTuples(queryLimited));
+  EXPECT_GE(observedOutput(queryLimited), 5);
+  EXPECT_LE(observedOutput(queryLimited), static_cast<long long>(MatchBatch::defaultCapacity));
+
+  EXPECT_EQ(expected.size(), createSequence(QueryConfig())->count());
+}
+
+TEST_F(AdaptiveReoptimizationTest, RemainingJoinsWithDP)
+{
+  // more remaining joins than all permutations are tested for, without statistics the first join is too large
+  auto createSequence = [this](const QueryConfig& config)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    for(size_t i=0; i < 9; i++)
+    {
+      q->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t" + std::to_string(i+1)));
+    }
+    for(size_t i=1; i < 9; i++)
+    {
+      q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1), i-1, i);
+    }
+    return q;
+  };
+  const std::vector<std::vector<nodeid_t>> expected = sequenceTuples(1, 9);
+  ASSERT_EQ(numOfToken / 10, expected.size());
+
+  QueryConfig configRandom;
+  configRandom.dp_join_order_max_nodes = 0;
+  std::shared_ptr<SingleAlternativeQuery> queryRandom = createSequence(configRandom);
+  EXPECT_EQ(expected, collectNodeTuples(queryRandom));
+
+  std::shared_ptr<SingleAlternativeQuery> queryDP = createSequence(QueryConfig());
+  EXPECT_EQ(expected, collectNodeTuples(queryDP));
+
+  // both queries were re-planned with the materialized first join as input
+  Plan planRandom(*queryRandom->getBestPlan());
+  Plan planDP(*queryDP->getBestPlan());
+  EXPECT_NE(std::string::npos, planRandom.debugString().find("[observed: "));
+  EXPECT_NE(std::string::npos, planDP.debugString().find("[observed: "));
+  EXPECT_LE(planDP.getCost(), planRandom.getCost());
+}
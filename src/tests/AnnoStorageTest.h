@@ -0,0 +1,80 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/annostorage.h>
+#include <annis/db.h>
+#include <annis/annosearch/exactannovaluesearch.h>
+
+using namespace annis;
+
+TEST(AnnoStorage, DenseColumns)
+{
+  AnnoStorage<nodeid_t> annos;
+
+  const std::uint32_t ns = 1;
+  const std::uint32_t tok = 2;
+  const std::uint32_t rare = 3;
+  // every node has a "tok" annotation, but only node 5 has the rare one
+  for(nodeid_t n=0; n < 10; n++)
+  {
+    annos.addAnnotation(n, {tok, ns, 100 + n});
+  }
+  annos.addAnnotation(5, {rare, ns, 200});
+
+  annos.optimizeColumns();
+
+  EXPECT_EQ(11, annos.numberOfAnnotations());
+  EXPECT_EQ(9, *annos.maxItem());
+
+  auto found = annos.getAnnotations(4, ns, tok);
+  ASSERT_TRUE(found.is_initialized());
+  EXPECT_EQ(104, found->val);
+  EXPECT_FALSE(annos.getAnnotations(4, ns, rare).is_initialized());
+
+  std::vector<Annotation> all = annos.getAnnotations(5);
+  ASSERT_EQ(2, all.size());
+  EXPECT_EQ(tok, all[0].name);
+  EXPECT_EQ(105, all[0].val);
+  EXPECT_EQ(rare, all[1].name);
+
+  // changes after the conversion must also be visible
+  annos.addAnnotation(12, {tok, ns, 112});
+  EXPECT_EQ(12, *annos.maxItem());
+  EXPECT_EQ(112, annos.getAnnotations(12, ns, tok)->val);
+
+  annos.deleteAnnotation(3, {tok, ns});
+  EXPECT_FALSE(annos.getAnnotations(3, ns, tok).is_initialized());
+  EXPECT_EQ(11, annos.numberOfAnnotations());
+}
+
+TEST(AnnoStorage, DeleteSharedAnnotation)
+{
+  DB db;
+  const Annotation anno = {db.strings.add("anno"), db.strings.add("test"), db.strings.add("val")};
+  db.nodeAnnos.addAnnotation(1, anno);
+  db.nodeAnnos.addAnnotation(2, anno);
+  db.nodeAnnos.addAnnotation(3, anno);
+
+  auto findNodes = [&db]()
+  {
+    ExactAnnoValueSearch search(db, "test", "anno", "val");
+    std::vector<nodeid_t> result;
+    Match m;
+    while(search.next(m))
+    {
+      result.push_back(m.node);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+
+  // only the deleted node must be removed from the inverse annotations
+  db.nodeAnnos.deleteAnnotation(2, {anno.name, anno.ns});
+  EXPECT_FALSE(db.nodeAnnos.getAnnotations(2, anno.ns, anno.name).is_initialized());
+  EXPECT_EQ(std::vector<nodeid_t>({1, 3}), findNodes());
+
+  db.nodeAnnos.deleteAnnotation(1, {anno.name, anno.ns});
+  EXPECT_EQ(std::vector<nodeid_t>({3}), findNodes());
+  EXPECT_EQ(1, db.nodeAnnos.numberOfAnnotations());
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/join/bandjoin.h>
+#include <annis/join/nestedloop.h>
+#include <annis/util/plan.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class BandJoinTest : public TokenSequenceTest
+{
+protected:
+  virtual void SetUp() override
+  {
+    TokenSequenceTest::SetUp();
+    db.nodeAnnos.calculateStatistics(db.strings);
+    db.createWritableGraphStorage(ComponentType::ORDERING, annis_ns, "")->calculateStatistics(db.strings);
+    // the token positions are needed for the band key
+    db.updateTokenIndex();
+  }
+};
+
+TEST_F(BandJoinTest, SameResultAsNestedLoop)
+{
+  // the band join must return the same tuples as the nested loop join
+  std::shared_ptr<Operator> op = std::make_shared<Precedence>(db, db.f_getGraphStorage, 2, 5);
+  ASSERT_TRUE(op->hasBandKey());
+  std::vector<std::vector<Match>> expected = collectTuples(std::make_shared<NestedLoopJoin>(op,
+    std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"),
+    std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_node_name), 0, 0));
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(4 * (numOfToken / 10), expected.size());
+
+  std::shared_ptr<Iterator> join = std::make_shared<BandJoin>(op,
+    std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"),
+    std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_node_name), 0, 0);
+  std::vector<std::vector<Match>> result = collectTuples(join);
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(expected, result);
+
+  // the sorted inputs are re-used after a reset
+  join->reset();
+  result = collectTuples(join);
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(expected, result);
+}
+
+TEST_F(BandJoinTest, ChosenByPlanner)
+{
+  // a large distance between two frequent operands is cheaper to execute with a band join
+  std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db);
+  q->addNode(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok));
+  q->addNode(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_node_name));
+  q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 50), 0, 1);
+  EXPECT_NE(std::string::npos, q->getBestPlan()->debugString().find("band_join"));
+
+  // each token is followed by the next 50 token, except at the end of the text
+  std::vector<std::vector<nodeid_t>> expected;
+  for(nodeid_t n=1; n <= numOfToken; n++)
+  {
+    for(nodeid_t following=n+1; following <= std::min<nodeid_t>(n+50, numOfToken); following++)
+    {
+      expected.push_back({n, following});
+    }
+  }
+  EXPECT_EQ(expected, collectNodeTuples(q));
+}
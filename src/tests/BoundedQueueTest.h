@@ -0,0 +1,167 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/util/boundedqueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace annis;
+
+TEST(BoundedQueue, FullAndEmpty)
+{
+  BoundedQueue<int> queue(3);
+
+  // the capacity is rounded up to 4
+  for(int i=0; i < 4; i++)
+  {
+    int val = i;
+    EXPECT_TRUE(queue.tryPush(val));
+  }
+  int val = 4;
+  EXPECT_FALSE(queue.tryPush(val));
+  EXPECT_EQ(4u, queue.size());
+
+  for(int i=0; i < 4; i++)
+  {
+    ASSERT_TRUE(queue.tryPop(val));
+    EXPECT_EQ(i, val);
+  }
+  EXPECT_FALSE(queue.tryPop(val));
+
+  queue.shutdown();
+  EXPECT_FALSE(queue.pop(val));
+  EXPECT_FALSE(queue.push(5));
+}
+
+TEST(BoundedQueue, ShutdownWakesWaiting)
+{
+  BoundedQueue<int> emptyQueue(2);
+  BoundedQueue<int> fullQueue(2);
+  for(int i=0; i < 2; i++)
+  {
+    int item = i;
+    EXPECT_TRUE(fullQueue.push(std::move(item)));
+  }
+
+  // both threads block until the queues are shut down
+  std::atomic<bool> consumerResult(true);
+  std::atomic<bool> producerResult(true);
+  std::thread consumer([&emptyQueue, &consumerResult]()
+  {
+    int item;
+    consumerResult = emptyQueue.pop(item);
+  });
+  std::thread producer([&fullQueue, &producerResult]()
+  {
+    producerResult = fullQueue.push(3);
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  emptyQueue.shutdown();
+  fullQueue.shutdown();
+  consumer.join();
+  producer.join();
+
+  EXPECT_FALSE(consumerResult.load());
+  EXPECT_FALSE(producerResult.load());
+}
+
+TEST(BoundedQueue, MultipleProducers)
+{
+  BoundedQueue<std::vector<int>> queue(2);
+
+  const int numOfProducers = 4;
+  const int itemsPerProducer = 1000;
+
+  std::vector<std::thread> producers;
+  for(int p=0; p < numOfProducers; p++)
+  {
+    producers.emplace_back([&queue, p, itemsPerProducer]()
+    {
+      for(int i=0; i < itemsPerProducer; i++)
+      {
+        queue.push({p, i});
+      }
+    });
+  }
+
+  std::thread closer([&producers, &queue]()
+  {
+    for(auto& t : producers)
+    {
+      t.join();
+    }
+    queue.shutdown();
+  });
+
+  std::vector<int> lastItem(numOfProducers, -1);
+  size_t numOfItems = 0;
+  std::vector<int> item;
+  while(queue.pop(item))
+  {
+    ASSERT_EQ(2u, item.size());
+    // the items of a single producer are returned in order
+    EXPECT_EQ(lastItem[item[0]] + 1, item[1]);
+    lastItem[item[0]] = item[1];
+    numOfItems++;
+  }
+  closer.join();
+
+  EXPECT_EQ(static_cast<size_t>(numOfProducers * itemsPerProducer), numOfItems);
+}
+
+TEST(BoundedQueue, ManyProducersAndConsumers)
+{
+  // a small queue forces both sides to wait often, a lost wakeup would block this test forever
+  BoundedQueue<int> queue(2);
+
+  const int numOfProducers = 8;
+  const int numOfConsumers = 8;
+  const int itemsPerProducer = 20000;
+
+  std::vector<std::thread> producers;
+  for(int p=0; p < numOfProducers; p++)
+  {
+    producers.emplace_back([&queue, itemsPerProducer]()
+    {
+      for(int i=1; i <= itemsPerProducer; i++)
+      {
+        int item = i;
+        queue.push(std::move(item));
+      }
+    });
+  }
+
+  std::atomic<long long> sum(0);
+  std::atomic<size_t> numOfItems(0);
+  std::vector<std::thread> consumers;
+  for(int c=0; c < numOfConsumers; c++)
+  {
+    consumers.emplace_back([&queue, &sum, &numOfItems]()
+    {
+      int item;
+      while(queue.pop(item))
+      {
+        sum += item;
+        numOfItems++;
+      }
+    });
+  }
+
+  for(auto& t : producers)
+  {
+    t.join();
+  }
+  queue.shutdown();
+  for(auto& t : consumers)
+  {
+    t.join();
+  }
+
+  EXPECT_EQ(static_cast<size_t>(numOfProducers * itemsPerProducer), numOfItems.load());
+  EXPECT_EQ(static_cast<long long>(numOfProducers) * itemsPerProducer * (itemsPerProducer + 1) / 2, sum.load());
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/db.h>
+#include <annis/graphstorage/adjacencyliststorage.h>
+#include <annis/graphstorage/csrstorage.h>
+#include <annis/util/mappedfile.h>
+#include <annis/util/threadpool.h>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <future>
+
+using namespace annis;
+
+class CSRStorageTest : public ::testing::Test
+{
+protected:
+  DB db;
+  AdjacencyListStorage orig;
+
+  virtual void SetUp() override
+  {
+    for(nodeid_t n=1; n <= 6; n++)
+    {
+      Annotation nodeName = {db.getNodeNameStringID(), db.getNamespaceStringID(),
+                             db.strings.add("n" + std::to_string(n))};
+      db.nodeAnnos.addAnnotation(n, nodeName);
+    }
+
+    // node 6 has no edges at all
+    orig.addEdge({1, 2});
+    orig.addEdge({2, 3});
+    orig.addEdge({3, 4});
+    orig.addEdge({1, 3});
+    orig.addEdge({4, 5});
+    orig.addEdge({5, 3});
+
+    orig.addEdgeAnnotation({1, 3}, {db.strings.add("func"), db.strings.add("test"), db.strings.add("subj")});
+    orig.calculateStatistics(db.strings);
+  }
+};
+
+TEST_F(CSRStorageTest, CopyFromAdjacencyList)
+{
+  CSRStorage gs;
+  gs.copy(db, orig);
+
+  EXPECT_EQ(6, gs.numberOfEdges());
+  EXPECT_EQ(1, gs.numberOfEdgeAnnotations());
+
+  std::vector<nodeid_t> out1 = gs.getOutgoingEdges(1);
+  ASSERT_EQ(2, out1.size());
+  EXPECT_EQ(2, out1[0]);
+  EXPECT_EQ(3, out1[1]);
+
+  EXPECT_TRUE(gs.getOutgoingEdges(6).empty());
+  EXPECT_TRUE(gs.getOutgoingEdges(0).empty());
+  EXPECT_TRUE(gs.getOutgoingEdges(100).empty());
+
+  EXPECT_TRUE(gs.isConnected({1, 3}, 1, 1));
+  EXPECT_FALSE(gs.isConnected({3, 1}, 1, 1));
+  EXPECT_FALSE(gs.isConnected({6, 1}, 1, 1));
+
+  std::vector<Annotation> annos = gs.getEdgeAnnotations({1, 3});
+  ASSERT_EQ(1, annos.size());
+  EXPECT_EQ("subj", db.strings.str(annos[0].val));
+}
+
+TEST_F(CSRStorageTest, Traversal)
+{
+  CSRStorage gs;
+  gs.copy(db, orig);
+
+  std::vector<nodeid_t> found;
+  auto it = gs.findConnected(1,3,3);
+  for(auto n=it->next(); n; n = it->next())
+  {
+    found.push_back(*n);
+  }
+  std::sort(found.begin(),found.end());
+  ASSERT_EQ(2, found.size());
+  EXPECT_EQ(4, found[0]);
+  EXPECT_EQ(5, found[1]);
+
+  found.clear();
+  it = gs.findConnected(1);
+  for(auto n=it->next(); n; n = it->next())
+  {
+    found.push_back(*n);
+  }
+  ASSERT_EQ(2, found.size());
+  EXPECT_EQ(2, found[0]);
+  EXPECT_EQ(3, found[1]);
+
+  // the cycle 3 -> 4 -> 5 -> 3 must not prevent the traversal from terminating
+  EXPECT_TRUE(gs.isConnected({3, 5}, 1, uintmax));
+  EXPECT_EQ(2, gs.distance({3, 5}));
+  EXPECT_EQ(-1, gs.distance({3, 1}));
+}
+
+TEST_F(CSRStorageTest, SourceNodeIterator)
+{
+  CSRStorage gs;
+  gs.copy(db, orig);
+
+  Annotation anyAnno = {0,0,0};
+  auto nodeIt = gs.getSourceNodeIterator([anyAnno](nodeid_t) -> std::list<Annotation> {return {anyAnno};},
+                                         true, false);
+  std::vector<nodeid_t> sources;
+  Match m;
+  while(nodeIt->next(m))
+  {
+    sources.push_back(m.node);
+  }
+  ASSERT_EQ(5, sources.size());
+  EXPECT_EQ(1, sources[0]);
+  EXPECT_EQ(5, sources[4]);
+}
+
+TEST_F(CSRStorageTest, SaveAndLoadMapped)
+{
+  CSRStorage gs;
+  gs.copy(db, orig);
+
+  boost::filesystem::path path = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("annis-csr-%%%%-%%%%.annis");
+  MappedFileWriter writer;
+  ASSERT_TRUE(gs.saveMapped(writer));
+  ASSERT_TRUE(writer.write(path.string()));
+
+  CSRStorage mapped;
+  ASSERT_TRUE(mapped.loadMapped(MappedFile::open(path.string())));
+  boost::filesystem::remove(path);
+
+  EXPECT_EQ(6, mapped.numberOfEdges());
+  EXPECT_EQ(1, mapped.numberOfEdgeAnnotations());
+  EXPECT_EQ(gs.getStatistics().nodes, mapped.getStatistics().nodes);
+  for(nodeid_t n=0; n <= 7; n++)
+  {
+    EXPECT_EQ(gs.getOutgoingEdges(n), mapped.getOutgoingEdges(n));
+  }
+  EXPECT_EQ(2, mapped.distance({3, 5}));
+}
+
+TEST_F(CSRStorageTest, DBSaveAndLoad)
+{
+  std::shared_ptr<WriteableGraphStorage> gs = db.createWritableGraphStorage(ComponentType::POINTING, "test", "dep");
+  gs->copy(db, orig);
+  db.optimizeAll();
+
+  boost::filesystem::path dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("annis-db-%%%%-%%%%");
+  ASSERT_TRUE(db.save(dir.string()));
+  EXPECT_TRUE(boost::filesystem::is_regular_file(dir / "current" / "gs" / "POINTING" / "test" / "dep" / "component.annis"));
+
+  DB loaded;
+  ASSERT_TRUE(loaded.load(dir.string(), false));
+  std::shared_ptr<const ReadableGraphStorage> loadedGS = loaded.getGraphStorage(ComponentType::POINTING, "test", "dep");
+  ASSERT_TRUE(loadedGS != nullptr);
+  EXPECT_TRUE(std::dynamic_pointer_cast<const CSRStorage>(loadedGS) != nullptr);
+  EXPECT_EQ(6, loadedGS->numberOfEdges());
+  EXPECT_TRUE(loadedGS->isConnected({5, 3}));
+  EXPECT_EQ("n4", loaded.getNodeName(4));
+
+  boost::filesystem::remove_all(dir);
+}
+
+TEST_F(CSRStorageTest, ImplHeuristics)
+{
+  GraphStorageRegistry registry;
+  GraphStatistic stats = orig.getStatistics();
+  ASSERT_TRUE(stats.valid);
+  ASSERT_TRUE(stats.cyclic);
+
+  EXPECT_EQ(GraphStorageRegistry::csr, registry.getOptimizedImpl({ComponentType::POINTING, "test", "dep"}, stats));
+  // token and coverage related components need the inverse edges of the adjacency list
+  EXPECT_EQ(GraphStorageRegistry::adjacencylist,
+            registry.getOptimizedImpl({ComponentType::COVERAGE, annis_ns, ""}, stats));
+
+  stats.maxDepth = 1;
+  EXPECT_EQ(GraphStorageRegistry::csr, registry.getOptimizedImpl({ComponentType::POINTING, "test", "dep"}, stats));
+  EXPECT_EQ(GraphStorageRegistry::adjacencylist,
+            registry.getOptimizedImpl({ComponentType::LEFT_TOKEN, annis_ns, ""}, stats));
+}
+
+TEST_F(CSRStorageTest, DBParallelLoad)
+{
+  for(int i=0; i < 6; i++)
+  {
+    std::shared_ptr<WriteableGraphStorage> gs = db.createWritableGraphStorage(ComponentType::POINTING, "test",
+                                                                              "dep" + std::to_string(i));
+    gs->copy(db, orig);
+    // make the components distinguishable
+    gs->addEdge({6, static_cast<nodeid_t>(i + 1)});
+    gs->calculateStatistics(db.strings);
+  }
+  db.optimizeAll();
+
+  boost::filesystem::path dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("annis-db-%%%%-%%%%");
+  ASSERT_TRUE(db.save(dir.string()));
+
+  DB sequential;
+  sequential.setNumOfLoadingThreads(1);
+  ASSERT_TRUE(sequential.load(dir.string(), true));
+
+  // a shared pool with less workers than loading threads
+  DB parallel;
+  parallel.setNumOfLoadingThreads(4);
+  parallel.setLoadingThreadPool(std::make_shared<ThreadPool>(2));
+  ASSERT_TRUE(parallel.load(dir.string(), true));
+
+  ASSERT_TRUE(sequential.allGraphStoragesLoaded());
+  ASSERT_TRUE(parallel.allGraphStoragesLoaded());
+  std::vector<Component> components = sequential.getAllComponents();
+  ASSERT_EQ(6u, components.size());
+  EXPECT_EQ(components.size(), parallel.getAllComponents().size());
+  for(const Component& c : components)
+  {
+    std::shared_ptr<const ReadableGraphStorage> gsSequential = sequential.getGraphStorage(c.type, c.layer, c.name);
+    std::shared_ptr<const ReadableGraphStorage> gsParallel = parallel.getGraphStorage(c.type, c.layer, c.name);
+    ASSERT_TRUE(gsSequential && gsParallel);
+    EXPECT_EQ(gsSequential->numberOfEdges(), gsParallel->numberOfEdges());
+    for(nodeid_t n=1; n <= 6; n++)
+    {
+      EXPECT_EQ(gsSequential->getOutgoingEdges(n), gsParallel->getOutgoingEdges(n));
+    }
+  }
+
+  // the loading thread must neither wait for helpers which never start nor execute foreign tasks of the pool
+  std::shared_ptr<ThreadPool> busyPool = std::make_shared<ThreadPool>(1);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::future<void> blockingTask = busyPool->enqueue([released]() {released.wait();});
+  std::atomic<bool> foreignTaskExecuted(false);
+  std::future<void> foreignTask = busyPool->enqueue([&foreignTaskExecuted]() {foreignTaskExecuted = true;});
+
+  DB busy;
+  busy.setNumOfLoadingThreads(4);
+  busy.setLoadingThreadPool(busyPool);
+  ASSERT_TRUE(busy.load(dir.string(), true));
+  EXPECT_TRUE(busy.allGraphStoragesLoaded());
+  EXPECT_EQ(components.size(), busy.getAllComponents().size());
+  EXPECT_FALSE(foreignTaskExecuted.load());
+
+  release.set_value();
+  blockingTask.wait();
+  foreignTask.wait();
+  EXPECT_TRUE(foreignTaskExecuted.load());
+
+  boost::filesystem::remove_all(dir);
+}
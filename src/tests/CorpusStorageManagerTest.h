@@ -20,10 +20,13 @@
 #include <annis/db.h>
 #include <annis/api/graphupdate.h>
 #include <annis/api/corpusstoragemanager.h>
+#include <annis/resultcache.h>
 
 #include <annis/annosearch/exactannokeysearch.h>
 
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <boost/filesystem.hpp>
 
 #include "testlogger.h"
@@ -209,6 +212,27 @@ TEST_F(CorpusStorageManagerTest, DeleteEdgeLabel) {
   ASSERT_EQ(0, depEdgesWithAnno);
 }
 
+TEST_F(CorpusStorageManagerTest, RegexNodeLabel) {
+
+  api::GraphUpdate updateInsert;
+  updateInsert.addNode("n1");
+  updateInsert.addNodeLabel("n1", "test", "anno", "Stadt");
+  updateInsert.addNode("n2");
+  updateInsert.addNodeLabel("n2", "test", "anno", "Stadtteil");
+  updateInsert.addNode("n3");
+  updateInsert.addNodeLabel("n3", "test", "anno", "Land");
+
+  storageEmpty->applyUpdate("testCorpus", updateInsert);
+
+  auto numOfMatches = storageEmpty->count({"testCorpus"},
+                                  "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"test\",\"name\":\"anno\",\"value\":\"Stadt.*\",\"textMatching\":\"REGEXP_EQUAL\",\"qualifiedName\":\"test:anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}");
+  ASSERT_EQ(2, numOfMatches);
+
+  auto numOfUnboundMatches = storageEmpty->count({"testCorpus"},
+                                  "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"name\":\"anno\",\"value\":\".*a.*\",\"textMatching\":\"REGEXP_EQUAL\",\"qualifiedName\":\"anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}");
+  ASSERT_EQ(3, numOfUnboundMatches);
+}
+
 TEST_F(CorpusStorageManagerTest, ReloadWithLog) {
 
   api::GraphUpdate updateInsert;
@@ -241,6 +265,226 @@ TEST_F(CorpusStorageManagerTest, ReloadWithLog) {
 
 }
 
+TEST_F(CorpusStorageManagerTest, MultipleCorpora) {
+
+  // create three corpora with a different number of matches, "corpusB" has none
+  const std::vector<std::pair<std::string, int>> corpusSizes = {{"corpusC", 5}, {"corpusA", 3}, {"corpusB", 0}, {"corpusD", 4}};
+  for(const auto& c : corpusSizes)
+  {
+    api::GraphUpdate updateInsert;
+    updateInsert.addNode(c.first + "/doc#other");
+    for(int i=0; i < c.second; i++)
+    {
+      const std::string nodeName = c.first + "/doc#n" + std::to_string(i);
+      updateInsert.addNode(nodeName);
+      updateInsert.addNodeLabel(nodeName, "test", "anno", "testVal");
+    }
+    storageEmpty->applyUpdate(c.first, updateInsert);
+  }
+
+  const std::vector<std::string> corpora = {"corpusD", "corpusB", "corpusC", "corpusA"};
+  const std::string query = "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"test\",\"name\":\"anno\",\"value\":\"testVal\",\"textMatching\":\"EXACT_EQUAL\",\"qualifiedName\":\"test:anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}";
+
+  ASSERT_EQ(12, storageEmpty->count(corpora, query));
+  ASSERT_EQ(12, storageEmpty->countExtra(corpora, query).matchCount);
+
+  // the results are sorted by the corpus name
+  std::vector<std::string> all = storageEmpty->find(corpora, query);
+  ASSERT_EQ(12, all.size());
+  EXPECT_NE(std::string::npos, all[0].find("salt:/corpusA/"));
+  EXPECT_NE(std::string::npos, all[3].find("salt:/corpusC/"));
+  EXPECT_NE(std::string::npos, all[8].find("salt:/corpusD/"));
+
+  // each page must be the same as the corresponding part of all results
+  for(long long offset=0; offset <= 12; offset++)
+  {
+    for(long long limit=1; limit <= 5; limit++)
+    {
+      std::vector<std::string> page = storageEmpty->find(corpora, query, offset, limit);
+      const size_t expectedSize = std::min<size_t>(limit, 12 - offset);
+      ASSERT_EQ(expectedSize, page.size());
+      for(size_t i=0; i < page.size(); i++)
+      {
+        EXPECT_EQ(all[offset + i], page[i]);
+      }
+    }
+    EXPECT_EQ(12 - offset, storageEmpty->find(corpora, query, offset).size());
+  }
+}
+
+TEST_F(CorpusStorageManagerTest, FindCursor) {
+
+  const std::vector<std::pair<std::string, int>> corpusSizes = {{"corpusA", 3}, {"corpusB", 0}, {"corpusC", 5}};
+  api::GraphUpdate updateLimited;
+  for(const auto& c : corpusSizes)
+  {
+    api::GraphUpdate updateInsert;
+    for(int i=0; i < c.second; i++)
+    {
+      const std::string nodeName = c.first + "/doc#n" + std::to_string(i);
+      updateInsert.addNode(nodeName);
+      updateInsert.addNodeLabel(nodeName, "test", "anno", "testVal");
+    }
+    storageEmpty->applyUpdate(c.first, updateInsert);
+    if(c.first == "corpusA")
+    {
+      updateLimited = updateInsert;
+    }
+  }
+
+  const std::vector<std::string> corpora = {"corpusC", "corpusB", "corpusA"};
+  const std::string query = "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"test\",\"name\":\"anno\",\"value\":\"testVal\",\"textMatching\":\"EXACT_EQUAL\",\"qualifiedName\":\"test:anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}";
+  std::vector<std::string> all = storageEmpty->find(corpora, query);
+  ASSERT_EQ(8, all.size());
+
+  // fetch the pages, each one continues where the last one stopped
+  long long cursor = storageEmpty->openFindCursor(corpora, query);
+  std::vector<std::string> paged;
+  for(int i=0; i < 3; i++)
+  {
+    api::CorpusStorageManager::CursorPage page = storageEmpty->findNext(cursor, 3);
+    ASSERT_TRUE(page.valid);
+    EXPECT_EQ(i < 2 ? 3 : 2, page.matches.size());
+    paged.insert(paged.end(), page.matches.begin(), page.matches.end());
+  }
+  EXPECT_EQ(all, paged);
+  api::CorpusStorageManager::CursorPage lastPage = storageEmpty->findNext(cursor, 3);
+  EXPECT_TRUE(lastPage.valid);
+  EXPECT_TRUE(lastPage.matches.empty());
+
+  storageEmpty->closeFindCursor(cursor);
+  EXPECT_FALSE(storageEmpty->findNext(cursor, 3).valid);
+
+  // changing the corpus of the current page invalidates the cursor
+  cursor = storageEmpty->openFindCursor(corpora, query);
+  ASSERT_EQ(2, storageEmpty->findNext(cursor, 2).matches.size());
+  api::GraphUpdate update;
+  update.addNode("corpusA/doc#new");
+  update.addNodeLabel("corpusA/doc#new", "test", "anno", "testVal");
+  storageEmpty->applyUpdate("corpusA", update);
+  EXPECT_FALSE(storageEmpty->findNext(cursor, 2).valid);
+  EXPECT_FALSE(storageEmpty->findNext(cursor, 2).valid);
+
+  // the least recently used cursors are closed when there are too many of them
+  // (use another directory, the background writers of the first storage might still be active)
+  boost::filesystem::path limitedDBPath = tmpDBPath / "limited";
+  boost::filesystem::create_directories(limitedDBPath);
+  api::CorpusStorageManager limitedStorage(limitedDBPath.string(), 1073741824, 2);
+  limitedStorage.applyUpdate("corpusA", updateLimited);
+  long long c1 = limitedStorage.openFindCursor({"corpusA"}, query);
+  long long c2 = limitedStorage.openFindCursor({"corpusA"}, query);
+  EXPECT_TRUE(limitedStorage.findNext(c1, 1).valid);
+  long long c3 = limitedStorage.openFindCursor({"corpusA"}, query);
+  EXPECT_TRUE(limitedStorage.findNext(c1, 1).valid);
+  EXPECT_FALSE(limitedStorage.findNext(c2, 1).valid);
+  EXPECT_TRUE(limitedStorage.findNext(c3, 1).valid);
+}
+
+TEST_F(CorpusStorageManagerTest, FindCursorTimeout) {
+
+  api::GraphUpdate updateInsert;
+  for(int i=0; i < 5; i++)
+  {
+    const std::string nodeName = "testCorpus/doc#n" + std::to_string(i);
+    updateInsert.addNode(nodeName);
+    updateInsert.addNodeLabel(nodeName, "test", "anno", "testVal");
+  }
+
+  boost::filesystem::path timeoutDBPath = tmpDBPath / "timeout";
+  boost::filesystem::create_directories(timeoutDBPath);
+  api::CorpusStorageManager timeoutStorage(timeoutDBPath.string(), 1073741824, 100, 1);
+  timeoutStorage.applyUpdate("testCorpus", updateInsert);
+
+  const std::string query = "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"test\",\"name\":\"anno\",\"value\":\"testVal\",\"textMatching\":\"EXACT_EQUAL\",\"qualifiedName\":\"test:anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}";
+  long long usedCursor = timeoutStorage.openFindCursor({"testCorpus"}, query);
+  long long unusedCursor = timeoutStorage.openFindCursor({"testCorpus"}, query);
+
+  // each page resets the timeout of the cursor
+  for(int i=0; i < 3; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    EXPECT_TRUE(timeoutStorage.findNext(usedCursor, 1).valid);
+  }
+  EXPECT_FALSE(timeoutStorage.findNext(unusedCursor, 1).valid);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  EXPECT_FALSE(timeoutStorage.findNext(usedCursor, 1).valid);
+}
+
+TEST_F(CorpusStorageManagerTest, FindCursorImport) {
+
+  // create two versions of the corpus with the same change ID
+  boost::filesystem::path sourceDBPath = tmpDBPath / "source";
+  boost::filesystem::create_directories(sourceDBPath);
+  api::CorpusStorageManager sourceStorage(sourceDBPath.string());
+  for(const std::string& sourceCorpus : {"sourceA", "sourceB"})
+  {
+    api::GraphUpdate updateInsert;
+    for(int i=0; i < 5; i++)
+    {
+      const std::string nodeName = sourceCorpus + "/doc#n" + std::to_string(i);
+      updateInsert.addNode(nodeName);
+      updateInsert.addNodeLabel(nodeName, "test", "anno", "testVal");
+    }
+    sourceStorage.applyUpdate(sourceCorpus, updateInsert);
+    sourceStorage.exportCorpus(sourceCorpus, (tmpDBPath / "export" / sourceCorpus).string());
+  }
+
+  storageEmpty->importCorpus((tmpDBPath / "export" / "sourceA").string(), "testCorpus");
+
+  const std::string query = "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"test\",\"name\":\"anno\",\"value\":\"testVal\",\"textMatching\":\"EXACT_EQUAL\",\"qualifiedName\":\"test:anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}";
+  long long cursor = storageEmpty->openFindCursor({"testCorpus"}, query);
+  ASSERT_EQ(2, storageEmpty->findNext(cursor, 2).matches.size());
+
+  // importing over the corpus replaces the data the query of the cursor refers to
+  storageEmpty->importCorpus((tmpDBPath / "export" / "sourceB").string(), "testCorpus");
+
+  api::CorpusStorageManager::CursorPage page = storageEmpty->findNext(cursor, 0);
+  ASSERT_TRUE(page.valid);
+  ASSERT_EQ(3, page.matches.size());
+  for(const std::string& m : page.matches)
+  {
+    EXPECT_NE(std::string::npos, m.find("sourceB/doc#n")) << m;
+  }
+}
+
+TEST_F(CorpusStorageManagerTest, ResultCache) {
+
+  api::GraphUpdate updateInsert;
+  for(int i=0; i < 5; i++)
+  {
+    const std::string nodeName = "testCorpus/doc#n" + std::to_string(i);
+    updateInsert.addNode(nodeName);
+    updateInsert.addNodeLabel(nodeName, "test", "anno", "testVal");
+  }
+  storageEmpty->applyUpdate("testCorpus", updateInsert);
+
+  const std::vector<std::string> corpora = {"testCorpus"};
+  const std::string query = "{\"alternatives\":[{\"nodes\":{\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"test\",\"name\":\"anno\",\"value\":\"testVal\",\"textMatching\":\"EXACT_EQUAL\",\"qualifiedName\":\"test:anno\"}],\"root\":false,\"token\":false,\"variable\":\"1\"}},\"joins\":[]}]}";
+  // same query with a different formatting and order of the keys
+  const std::string reorderedQuery = "{ \"alternatives\" : [ { \"joins\" : [], \"nodes\" : { \"1\" : { \"variable\" : \"1\", \"token\" : false, \"root\" : false, \"nodeAnnotations\" : [ { \"qualifiedName\" : \"test:anno\", \"textMatching\" : \"EXACT_EQUAL\", \"value\" : \"testVal\", \"name\" : \"anno\", \"namespace\" : \"test\" } ], \"id\" : 1 } } } ] }";
+  EXPECT_EQ(ResultCache::canonicalQuery(query), ResultCache::canonicalQuery(reorderedQuery));
+
+  EXPECT_EQ(5, storageEmpty->count(corpora, query));
+  EXPECT_EQ(5, storageEmpty->count(corpora, reorderedQuery));
+
+  std::vector<std::string> all = storageEmpty->find(corpora, query, 0, 10);
+  ASSERT_EQ(5, all.size());
+  // the pages are answered from the cached matches
+  std::vector<std::string> page = storageEmpty->find(corpora, reorderedQuery, 2, 2);
+  EXPECT_EQ(std::vector<std::string>(all.begin() + 2, all.begin() + 4), page);
+  EXPECT_EQ(all, storageEmpty->find(corpora, query, 0, 10));
+
+  // updating the corpus must not return the old results
+  api::GraphUpdate update;
+  update.addNode("testCorpus/doc#new");
+  update.addNodeLabel("testCorpus/doc#new", "test", "anno", "testVal");
+  storageEmpty->applyUpdate("testCorpus", update);
+
+  EXPECT_EQ(6, storageEmpty->count(corpora, query));
+  EXPECT_EQ(6, storageEmpty->find(corpora, query, 0, 10).size());
+}
+
 TEST_F(CorpusStorageManagerTest, SubgraphGUMSingle) {
 
   std::vector<std::string> ids;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+using namespace annis;
+
+class CountTest : public TokenSequenceTest
+{
+};
+
+TEST_F(CountTest, Searches)
+{
+  std::shared_ptr<ExactAnnoKeySearch> keySearch = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  ASSERT_TRUE(keySearch->countFromIndex().is_initialized());
+  EXPECT_EQ(numOfToken, *keySearch->countFromIndex());
+
+  std::shared_ptr<ExactAnnoValueSearch> valueSearch = std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t3");
+  ASSERT_TRUE(valueSearch->countFromIndex().is_initialized());
+  EXPECT_EQ(numOfToken / 10, *valueSearch->countFromIndex());
+
+  // the output filter can only be applied to the actual matches
+  valueSearch->setOutputFilter({[](const Match& m) {return m.node % 20 == 3;}});
+  EXPECT_FALSE(valueSearch->countFromIndex().is_initialized());
+  EXPECT_EQ(numOfToken / 20, valueSearch->count());
+}
+
+TEST_F(CountTest, JoinsAndAlternatives)
+{
+  EXPECT_EQ(2*numOfToken - 3, createJoin(false)->count());
+  EXPECT_EQ(numOfToken - 1, createJoin(true)->count());
+
+  // overlapping alternatives must still be filtered for duplicates
+  EXPECT_EQ(3 * numOfToken / 10, createDisjunction(QueryConfig())->count());
+}
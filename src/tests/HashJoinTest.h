@@ -0,0 +1,85 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/join/hashjoin.h>
+#include <annis/join/nestedloop.h>
+#include <annis/operators/identicalcoverage.h>
+#include <annis/util/plan.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class HashJoinTest : public TokenSequenceTest
+{
+protected:
+  virtual void SetUp() override
+  {
+    TokenSequenceTest::SetUp();
+    db.nodeAnnos.calculateStatistics(db.strings);
+    // the selectivity of the operators depends on the statistics of the token components
+    for(ComponentType type : {ComponentType::ORDERING, ComponentType::COVERAGE})
+    {
+      db.createWritableGraphStorage(type, annis_ns, "")->calculateStatistics(db.strings);
+    }
+  }
+};
+
+TEST_F(HashJoinTest, SameResultAsNestedLoop)
+{
+  // the hash join must return the same tuples as the nested loop join with either side as build side
+  std::shared_ptr<Operator> op = std::make_shared<IdenticalCoverage>(db, db.f_getGraphStorage);
+  std::vector<std::vector<Match>> expected = collectTuples(std::make_shared<NestedLoopJoin>(op,
+    std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"),
+    std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_node_name), 0, 0));
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(numOfToken / 10, expected.size());
+  for(bool leftIsBuild : {true, false})
+  {
+    std::shared_ptr<Iterator> join = std::make_shared<HashJoin>(op,
+      std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"),
+      std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_node_name), 0, 0, leftIsBuild);
+    std::vector<std::vector<Match>> result = collectTuples(join);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+
+    // the hash table is re-used after a reset
+    join->reset();
+    result = collectTuples(join);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST_F(HashJoinTest, ChosenByPlanner)
+{
+  // both operands are already joined, the hash join replaces the nested loop join
+  auto createQuery = [this](const QueryConfig& config)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    q->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"));
+    q->addNode(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok));
+    q->addNode(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_node_name));
+    q->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t5"));
+    q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), 0, 1);
+    q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), 2, 3);
+    q->addOperator(std::make_shared<IdenticalCoverage>(db, db.f_getGraphStorage), 1, 2);
+    return q;
+  };
+  QueryConfig config;
+  config.optimize_join_order = false;
+  std::shared_ptr<SingleAlternativeQuery> q = createQuery(config);
+  EXPECT_NE(std::string::npos, q->getBestPlan()->debugString().find("hash_join"));
+
+  // the token "t3" between "t1" and "t5" is bound to both #2 and #3
+  std::vector<std::vector<nodeid_t>> expected;
+  for(const std::vector<nodeid_t>& s : sequenceTuples(1, 5))
+  {
+    expected.push_back({s[0], s[2], s[2], s[4]});
+  }
+  ASSERT_EQ(numOfToken / 10, expected.size());
+  EXPECT_EQ(expected, collectNodeTuples(q));
+}
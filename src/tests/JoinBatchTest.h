@@ -0,0 +1,71 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+using namespace annis;
+
+class JoinBatchTest : public TokenSequenceTest
+{
+protected:
+  static std::vector<std::vector<Match>> collectBatches(std::shared_ptr<Iterator> it)
+  {
+    std::vector<std::vector<Match>> result;
+    MatchBatch batch;
+    while(it->nextBatch(batch))
+    {
+      EXPECT_LE(batch.size(), static_cast<size_t>(MatchBatch::defaultCapacity));
+      std::vector<Match> tuple;
+      for(size_t row=0; row < batch.size(); row++)
+      {
+        batch.get(row, tuple);
+        result.push_back(tuple);
+      }
+    }
+    return result;
+  }
+};
+
+TEST_F(JoinBatchTest, IndexJoin)
+{
+  std::vector<std::vector<Match>> tuples = collectTuples(createJoin(false));
+  std::vector<std::vector<Match>> batches = collectBatches(createJoin(false));
+
+  // each token except the last ones precede the next two token
+  ASSERT_EQ(2*numOfToken - 3, tuples.size());
+  ASSERT_EQ(tuples.size(), batches.size());
+  for(size_t i=0; i < tuples.size(); i++)
+  {
+    ASSERT_EQ(2, batches[i].size());
+    EXPECT_EQ(tuples[i][0].node, batches[i][0].node);
+    EXPECT_EQ(tuples[i][1].node, batches[i][1].node);
+    EXPECT_EQ(tuples[i][1].anno.val, batches[i][1].anno.val);
+  }
+}
+
+TEST_F(JoinBatchTest, BinaryFilter)
+{
+  std::vector<std::vector<Match>> tuples = collectTuples(createJoin(true));
+  std::vector<std::vector<Match>> batches = collectBatches(createJoin(true));
+
+  ASSERT_EQ(numOfToken - 1, tuples.size());
+  ASSERT_EQ(tuples.size(), batches.size());
+  for(size_t i=0; i < tuples.size(); i++)
+  {
+    EXPECT_EQ(tuples[i][0].node + 1, tuples[i][1].node);
+    EXPECT_EQ(tuples[i][0].node, batches[i][0].node);
+    EXPECT_EQ(tuples[i][1].node, batches[i][1].node);
+  }
+}
+
+TEST_F(JoinBatchTest, ResetAfterPartialBatch)
+{
+  std::shared_ptr<Iterator> join = createJoin(false);
+  std::vector<Match> tuple;
+  ASSERT_TRUE(join->next(tuple));
+  ASSERT_TRUE(join->next(tuple));
+
+  join->reset();
+  EXPECT_EQ(2*numOfToken - 3, collectBatches(join).size());
+}
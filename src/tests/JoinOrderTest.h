@@ -0,0 +1,51 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/util/plan.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class JoinOrderTest : public TokenSequenceTest
+{
+};
+
+TEST_F(JoinOrderTest, DynamicProgramming)
+{
+  // the optimizer needs the statistics for estimating the costs
+  db.nodeAnnos.calculateStatistics(db.strings);
+
+  auto createSequence = [this](const QueryConfig& config)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    for(size_t i=0; i < 8; i++)
+    {
+      q->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t" + std::to_string(i+1)));
+    }
+    for(size_t i=1; i < 8; i++)
+    {
+      q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1), i-1, i);
+    }
+    return q;
+  };
+  // each "t1" token starts a sequence of the token "t1" to "t8"
+  const std::vector<std::vector<nodeid_t>> expected = sequenceTuples(1, 8);
+  ASSERT_EQ(numOfToken / 10, expected.size());
+
+  QueryConfig configRandom;
+  configRandom.dp_join_order_max_nodes = 0;
+  std::shared_ptr<SingleAlternativeQuery> queryRandom = createSequence(configRandom);
+  EXPECT_EQ(expected, collectNodeTuples(queryRandom));
+
+  std::shared_ptr<SingleAlternativeQuery> queryDP = createSequence(QueryConfig());
+  EXPECT_EQ(expected, collectNodeTuples(queryDP));
+
+  // the dynamic programming finds the optimal plan, which can't be more expensive than the randomly optimized one
+  Plan planRandom(*queryRandom->getBestPlan());
+  Plan planDP(*queryDP->getBestPlan());
+  EXPECT_LE(planDP.getCost(), planRandom.getCost());
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/join/multiwayjoin.h>
+#include <annis/util/plan.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class MultiwayJoinTest : public TokenSequenceTest
+{
+protected:
+  virtual void SetUp() override
+  {
+    TokenSequenceTest::SetUp();
+    db.nodeAnnos.calculateStatistics(db.strings);
+    db.createWritableGraphStorage(ComponentType::ORDERING, annis_ns, "")->calculateStatistics(db.strings);
+    db.updateTokenIndex();
+  }
+};
+
+TEST_F(MultiwayJoinTest, CyclicQuery)
+{
+  // #1 .1,5 #2 & #2 .1,5 #3 & #1 .1,5 #3 is a triangle over all token: a join tree creates each path from #1 over #2
+  // to #3 before the closing operator can filter it, the multiway join only keeps the candidates reachable from both
+  auto createQuery = [this](const QueryConfig& config)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    for(size_t i=0; i < 3; i++)
+    {
+      q->addNode(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok));
+    }
+    q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 5), 0, 1);
+    q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 5), 1, 2);
+    q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 5), 0, 2);
+    return q;
+  };
+  auto getCost = [](std::shared_ptr<SingleAlternativeQuery> q)
+  {
+    return Plan::estimateTupleSize(q->getBestPlan()->getRoot())->intermediateSum;
+  };
+
+  QueryConfig configWithout;
+  configWithout.enableMultiwayJoin = false;
+  std::shared_ptr<SingleAlternativeQuery> qWithout = createQuery(configWithout);
+  EXPECT_EQ(std::string::npos, qWithout->getBestPlan()->debugString().find("multiway_join"));
+  const std::uint64_t costWithout = getCost(qWithout);
+  // #2 and #3 are two of the five token following #1, except at the end of the text
+  std::vector<std::vector<nodeid_t>> expected;
+  for(nodeid_t n=1; n <= numOfToken; n++)
+  {
+    for(nodeid_t second=n+1; second <= std::min<nodeid_t>(n+4, numOfToken); second++)
+    {
+      for(nodeid_t third=second+1; third <= std::min<nodeid_t>(n+5, numOfToken); third++)
+      {
+        expected.push_back({n, second, third});
+      }
+    }
+  }
+  ASSERT_EQ(10 * (numOfToken - 5) + 6 + 3 + 1, expected.size());
+  EXPECT_EQ(expected, collectNodeTuples(qWithout));
+
+  std::shared_ptr<SingleAlternativeQuery> q = createQuery(QueryConfig());
+  EXPECT_NE(std::string::npos, q->getBestPlan()->debugString().find("multiway_join"));
+  EXPECT_LT(getCost(q), costWithout);
+  EXPECT_EQ(expected, collectNodeTuples(q));
+  EXPECT_EQ(expected.size(), createQuery(QueryConfig())->count());
+}
+
+TEST_F(MultiwayJoinTest, LazyBaseSearches)
+{
+  // the base searches of the nodes with a generating operator are never executed, their candidates are only checked
+  std::shared_ptr<ExactAnnoValueSearch> t1Search = std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1");
+  std::shared_ptr<ExactAnnoKeySearch> tokSearch = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  std::vector<MultiwayJoin::Relation> relations =
+  {
+    {std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), 0, 1},
+    {std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1), 2, 1},
+    {std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 3), 0, 2},
+  };
+  MultiwayJoin join({t1Search, nullptr, nullptr},
+                    {Plan::createSearchFilter(db, t1Search), Plan::createSearchFilter(db, tokSearch),
+                     Plan::createSearchFilter(db, tokSearch)},
+                    {numOfToken / 10, numOfToken, numOfToken}, relations);
+  ASSERT_EQ(3u, join.getOrder().size());
+  EXPECT_EQ(0u, join.getOrder()[0]);
+  EXPECT_FALSE(join.hasGenerator(0));
+  EXPECT_TRUE(join.hasGenerator(1));
+  EXPECT_TRUE(join.hasGenerator(2));
+
+  // only the token two positions after each "t1" token fits all operators
+  size_t numOfResults = 0;
+  std::vector<Match> tuple;
+  while(join.next(tuple))
+  {
+    ASSERT_EQ(3u, tuple.size());
+    EXPECT_EQ(1u, tuple[0].node % 10);
+    EXPECT_EQ(tuple[0].node + 2, tuple[1].node);
+    EXPECT_EQ(tuple[0].node + 1, tuple[2].node);
+    numOfResults++;
+  }
+  EXPECT_EQ(numOfToken / 10, numOfResults);
+
+  // the join can be executed again without the base searches
+  join.reset();
+  numOfResults = 0;
+  while(join.next(tuple))
+  {
+    numOfResults++;
+  }
+  EXPECT_EQ(numOfToken / 10, numOfResults);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/util/threadpool.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace annis;
+
+class ParallelAlternativesTest : public TokenSequenceTest
+{
+};
+
+TEST_F(ParallelAlternativesTest, SameResult)
+{
+  std::vector<nodeid_t> expected = collectNodes(createDisjunction(QueryConfig()));
+  ASSERT_EQ(3 * numOfToken / 10, expected.size());
+
+  QueryConfig config;
+  config.enableParallelAlternatives = true;
+  std::vector<nodeid_t> result = collectNodes(createDisjunction(config));
+
+  // use a pool which is shared with the joins and allows only two alternatives at the same time
+  config.threadPool = std::make_shared<ThreadPool>(3);
+  std::vector<nodeid_t> resultShared = collectNodes(createDisjunction(config));
+
+  config.orderedAlternatives = true;
+  std::vector<nodeid_t> resultOrdered = collectNodes(createDisjunction(config));
+
+  // the ordered mode has the same output as the sequential execution
+  EXPECT_EQ(expected, resultOrdered);
+
+  std::sort(expected.begin(), expected.end());
+  std::sort(result.begin(), result.end());
+  std::sort(resultShared.begin(), resultShared.end());
+  EXPECT_EQ(expected, result);
+  EXPECT_EQ(expected, resultShared);
+}
+
+TEST_F(ParallelAlternativesTest, OrderedWithThreadIndexJoin)
+{
+  // the statistics are needed to parallelize the joins
+  db.nodeAnnos.calculateStatistics(db.strings);
+  db.createWritableGraphStorage(ComponentType::ORDERING, annis_ns, "")->calculateStatistics(db.strings);
+
+  // tok="t1" . tok | tok="t2" . tok | tok="t3" . tok
+  auto createQuery = [&](const QueryConfig& config) -> std::shared_ptr<Query>
+  {
+    std::stringstream json;
+    json << "{\"alternatives\":[";
+    for(int i=1; i <= 3; i++)
+    {
+      json << (i > 1 ? "," : "") << "{\"nodes\":{"
+           << "\"1\":{\"id\":1,\"nodeAnnotations\":[{\"namespace\":\"annis\",\"name\":\"tok\",\"value\":\"t" << i
+           << "\",\"textMatching\":\"EXACT_EQUAL\"}],\"root\":false,\"token\":false},"
+           << "\"2\":{\"id\":2,\"nodeAnnotations\":[],\"root\":false,\"token\":true}},"
+           << "\"joins\":[{\"op\":\"Precedence\",\"minDistance\":1,\"maxDistance\":1,\"left\":1,\"right\":2}]}";
+    }
+    json << "]}";
+    return JSONQueryParser::parse(db, json, config);
+  };
+
+  std::vector<nodeid_t> expected = collectNodes(createQuery(QueryConfig()));
+  ASSERT_EQ(3 * numOfToken / 10, expected.size());
+
+  // The joins and the alternatives would need more workers than the pool has. Neither the alternatives nor
+  // the join tasks may block the workers while they wait for the consumer.
+  QueryConfig config;
+  config.enableParallelAlternatives = true;
+  config.orderedAlternatives = true;
+  config.numOfBackgroundTasks = 2;
+  config.enableThreadIndexJoin = true;
+  config.morselSize = 16;
+  config.threadPool = std::make_shared<ThreadPool>(2);
+  EXPECT_NE(std::string::npos, createQuery(config)->debugString().find("tasks: 2"));
+  std::sort(expected.begin(), expected.end());
+  for(int i=0; i < 5; i++)
+  {
+    std::vector<nodeid_t> result = collectNodes(createQuery(config));
+    // the parallel joins change the order inside an alternative, but not the order of the alternatives
+    for(size_t r=1; r < result.size(); r++)
+    {
+      ASSERT_LE(result[r-1] % 10, result[r] % 10);
+    }
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST_F(ParallelAlternativesTest, Abort)
+{
+  QueryConfig config;
+  config.enableParallelAlternatives = true;
+  config.threadPool = std::make_shared<ThreadPool>(2);
+  for(int i=0; i < 10; i++)
+  {
+    // destroying the query while the alternatives still produce results must not block
+    std::shared_ptr<Query> q = createDisjunction(config);
+    ASSERT_TRUE(q->next());
+  }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/annosearch/parallelsearch.h>
+#include <annis/util/comparefunctions.h>
+#include <annis/util/threadpool.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class ParallelSearchTest : public TokenSequenceTest
+{
+protected:
+  /**
+   * @brief Execute the search once sequentially and once in parallel and return both (sorted) results.
+   */
+  std::pair<std::vector<Match>, std::vector<Match>> searchBoth(std::function<std::shared_ptr<EstimatedSearch>()> createSearch)
+  {
+    std::pair<std::vector<Match>, std::vector<Match>> result;
+    Match m;
+
+    // the output filter is only applied to the tuples and batches
+    std::shared_ptr<EstimatedSearch> sequential = createSearch();
+    MatchBatch batch;
+    while(sequential->nextBatch(batch))
+    {
+      result.first.insert(result.first.end(), batch.column(0).begin(), batch.column(0).end());
+    }
+
+    std::shared_ptr<EstimatedSearch> base = createSearch();
+    EXPECT_FALSE(base->createMorsels(100).empty());
+    ParallelSearch parallel(base, 100, 4);
+    while(parallel.next(m))
+    {
+      result.second.push_back(m);
+    }
+
+    std::sort(result.first.begin(), result.first.end());
+    std::sort(result.second.begin(), result.second.end());
+    return result;
+  }
+
+  static void expectSameMatches(const std::pair<std::vector<Match>, std::vector<Match>>& result)
+  {
+    ASSERT_EQ(result.first.size(), result.second.size());
+    for(size_t i=0; i < result.first.size(); i++)
+    {
+      EXPECT_EQ(result.first[i].node, result.second[i].node);
+      EXPECT_TRUE(checkAnnotationEqual(result.first[i].anno, result.second[i].anno));
+    }
+  }
+};
+
+TEST_F(ParallelSearchTest, ExactAnnoKeySearch)
+{
+  std::pair<std::vector<Match>, std::vector<Match>> result = searchBoth([&]()
+  {
+    return std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  });
+  EXPECT_EQ(numOfToken, result.first.size());
+  expectSameMatches(result);
+}
+
+TEST_F(ParallelSearchTest, ExactAnnoValueSearch)
+{
+  std::pair<std::vector<Match>, std::vector<Match>> result = searchBoth([&]()
+  {
+    return std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t3");
+  });
+  EXPECT_EQ(numOfToken / 10, result.first.size());
+  expectSameMatches(result);
+}
+
+TEST_F(ParallelSearchTest, RegexAnnoSearch)
+{
+  std::pair<std::vector<Match>, std::vector<Match>> result = searchBoth([&]()
+  {
+    return std::make_shared<RegexAnnoSearch>(db, annis_ns, annis_node_name, "n1.*");
+  });
+  // n1, n10-n19, n100-n199 and n1000-n1999
+  EXPECT_EQ(1 + 10 + 100 + 1000, result.first.size());
+  expectSameMatches(result);
+}
+
+TEST_F(ParallelSearchTest, OutputFilter)
+{
+  std::pair<std::vector<Match>, std::vector<Match>> result = searchBoth([&]()
+  {
+    std::shared_ptr<EstimatedSearch> search = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+    search->setOutputFilter({[](const Match& m) {return m.node % 2 == 0;}});
+    return search;
+  });
+  EXPECT_EQ(numOfToken / 2, result.first.size());
+  expectSameMatches(result);
+}
+
+TEST_F(ParallelSearchTest, SingleWorker)
+{
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(1);
+  ParallelSearch search1(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 100, 2, pool);
+  ParallelSearch search2(std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 100, 2, pool);
+
+  // The tasks of the second search fill its queue while nobody consumes it. They must return the only worker,
+  // otherwise the first search could never produce a result.
+  Match m;
+  ASSERT_TRUE(search2.next(m));
+
+  size_t count1 = 0;
+  while(search1.next(m))
+  {
+    count1++;
+  }
+  EXPECT_EQ(numOfToken, count1);
+
+  size_t count2 = 1;
+  while(search2.next(m))
+  {
+    count2++;
+  }
+  EXPECT_EQ(numOfToken, count2);
+}
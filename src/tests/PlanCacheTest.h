@@ -0,0 +1,99 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/api/graphupdate.h>
+#include <annis/query/plancache.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class PlanCacheTest : public TokenSequenceTest
+{
+};
+
+TEST_F(PlanCacheTest, RebindLiterals)
+{
+  QueryConfig config;
+  config.planCache = std::make_shared<PlanCache>();
+
+  const std::vector<std::vector<nodeid_t>> expected = sequenceTuples(1, 3);
+  ASSERT_EQ(numOfToken / 10, expected.size());
+  for(int i=0; i < 2; i++)
+  {
+    EXPECT_EQ(expected, collectNodeTuples(parseSequence({"t1", "t2", "t3"}, config)));
+    EXPECT_EQ(1, config.planCache->size());
+  }
+
+  // other literal values re-use the plan of the same query shape
+  const std::vector<std::vector<nodeid_t>> expectedOther = sequenceTuples(5, 3);
+  EXPECT_EQ(expectedOther, collectNodeTuples(parseSequence({"t5", "t6", "t7"}, config)));
+  EXPECT_EQ(1, config.planCache->size());
+
+  config.planCacheRebindLiterals = false;
+  EXPECT_EQ(expectedOther, collectNodeTuples(parseSequence({"t5", "t6", "t7"}, config)));
+  EXPECT_EQ(2, config.planCache->size());
+}
+
+TEST_F(PlanCacheTest, LeastRecentlyUsed)
+{
+  PlanCache cache(2);
+  std::shared_ptr<const CachedPlan> plan = std::make_shared<CachedPlan>();
+  PlanCacheKey key1 = PlanCache::createKey(db, 0, "shape1", "a");
+  PlanCacheKey key2 = PlanCache::createKey(db, 0, "shape2", "a");
+  PlanCacheKey key3 = PlanCache::createKey(db, 0, "shape3", "a");
+
+  cache.put(key1, plan);
+  cache.put(key2, plan);
+  // using the first plan makes the second one the least recently used
+  EXPECT_EQ(plan, cache.get(key1, false));
+  cache.put(key3, plan);
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(plan, cache.get(key1, false));
+  EXPECT_FALSE(cache.get(key2, false));
+  EXPECT_EQ(plan, cache.get(key3, false));
+
+  cache.clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_FALSE(cache.get(key1, true));
+}
+
+TEST_F(PlanCacheTest, KeyDifferences)
+{
+  PlanCache cache;
+  std::shared_ptr<const CachedPlan> plan = std::make_shared<CachedPlan>();
+  cache.put(PlanCache::createKey(db, 0, "shape", "a"), plan);
+
+  // other literals only match if the literals may be re-bound
+  EXPECT_FALSE(cache.get(PlanCache::createKey(db, 0, "shape", "b"), false));
+  EXPECT_EQ(plan, cache.get(PlanCache::createKey(db, 0, "shape", "b"), true));
+  // the parallelization and the shape must always be the same
+  EXPECT_FALSE(cache.get(PlanCache::createKey(db, 2, "shape", "a"), true));
+  EXPECT_FALSE(cache.get(PlanCache::createKey(db, 0, "otherShape", "a"), true));
+
+  DB otherDB;
+  EXPECT_FALSE(cache.get(PlanCache::createKey(otherDB, 0, "shape", "a"), true));
+}
+
+TEST_F(PlanCacheTest, InvalidatedByUpdate)
+{
+  QueryConfig config;
+  config.planCache = std::make_shared<PlanCache>();
+  const std::vector<std::vector<nodeid_t>> expected = sequenceTuples(1, 3);
+  EXPECT_EQ(expected, collectNodeTuples(parseSequence({"t1", "t2", "t3"}, config)));
+  ASSERT_EQ(1, config.planCache->size());
+
+  api::GraphUpdate u;
+  u.addNode("new");
+  u.addNodeLabel("new", annis_ns, annis_tok, "t1");
+  u.finish();
+  db.update(u);
+
+  // the plan of the old version of the corpus is not used anymore, the query is planned again
+  EXPECT_EQ(expected, collectNodeTuples(parseSequence({"t1", "t2", "t3"}, config)));
+  EXPECT_EQ(2, config.planCache->size());
+}
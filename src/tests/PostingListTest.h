@@ -0,0 +1,132 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/util/postinglist.h>
+#include <annis/util/postingindex.h>
+#include <annis/types.h>
+
+#include <cereal/archives/binary.hpp>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace annis;
+
+TEST(PostingList, AddRemoveContains)
+{
+  PostingList l;
+  EXPECT_TRUE(l.add(10));
+  EXPECT_TRUE(l.add(500));
+  EXPECT_TRUE(l.add(100000));
+  // out of order and duplicate inserts
+  EXPECT_TRUE(l.add(3));
+  EXPECT_FALSE(l.add(500));
+
+  std::vector<std::uint32_t> expected = {3, 10, 500, 100000};
+  EXPECT_EQ(expected, l.decode());
+  EXPECT_TRUE(l.contains(500));
+  EXPECT_FALSE(l.contains(501));
+
+  EXPECT_TRUE(l.remove(10));
+  EXPECT_FALSE(l.remove(10));
+  expected = {3, 500, 100000};
+  EXPECT_EQ(expected, l.decode());
+}
+
+TEST(PostingList, BufferedChanges)
+{
+  PostingList l;
+  std::set<std::uint32_t> expected;
+  // the inserts are not ordered, which requires to merge the buffered IDs several times
+  for(std::uint32_t i=0; i < 20000; i++)
+  {
+    const std::uint32_t id = (i * 7919) % 20000;
+    EXPECT_TRUE(l.add(id));
+    expected.insert(id);
+  }
+  for(std::uint32_t id=0; id < 20000; id += 3)
+  {
+    EXPECT_TRUE(l.remove(id));
+    expected.erase(id);
+  }
+  // removed IDs can be added again before the changes are merged
+  EXPECT_TRUE(l.add(3));
+  expected.insert(3);
+  EXPECT_FALSE(l.add(4));
+
+  EXPECT_EQ(expected.size(), l.size());
+  EXPECT_EQ(std::vector<std::uint32_t>(expected.begin(), expected.end()), l.decode());
+  for(std::uint32_t id=0; id < 20010; id++)
+  {
+    EXPECT_EQ(expected.find(id) != expected.end(), l.contains(id)) << "ID " << id;
+  }
+
+  // the buffered changes are part of the serialized list
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive archive(ss);
+    archive(l);
+  }
+  PostingList loaded;
+  {
+    cereal::BinaryInputArchive archive(ss);
+    archive(loaded);
+  }
+  EXPECT_EQ(l.decode(), loaded.decode());
+  EXPECT_TRUE(loaded.contains(19999));
+  EXPECT_FALSE(loaded.contains(19998));
+}
+
+TEST(PostingList, IntersectUnite)
+{
+  PostingList a = PostingList::fromSorted({1, 2, 5, 300, 1000});
+  PostingList b = PostingList::fromSorted({2, 3, 300, 2000});
+
+  std::vector<std::uint32_t> intersection = {2, 300};
+  EXPECT_EQ(intersection, PostingList::intersect(a, b).decode());
+
+  std::vector<std::uint32_t> unionIDs = {1, 2, 3, 5, 300, 1000, 2000};
+  EXPECT_EQ(unionIDs, PostingList::unite(a, b).decode());
+
+  EXPECT_TRUE(PostingList::intersect(a, PostingList()).empty());
+}
+
+TEST(PostingIndex, IterateLikeMultimap)
+{
+  PostingIndex<Annotation> idx;
+  idx.insert({{1, 1, 10}, 5});
+  idx.insert({{1, 1, 10}, 2});
+  idx.insert({{1, 1, 11}, 7});
+  idx.insert({{1, 1, 12}, 1});
+  idx.insert({{1, 1, 12}, 9});
+  EXPECT_EQ(5, idx.size());
+
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> found;
+  for(auto it=idx.begin(); it != idx.end(); it++)
+  {
+    found.push_back({it->first.val, it->second});
+  }
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> expected = {{10, 2}, {10, 5}, {11, 7}, {12, 1}, {12, 9}};
+  EXPECT_EQ(expected, found);
+
+  auto range = idx.equal_range({1, 1, 11});
+  ASSERT_TRUE(range.first != range.second);
+  EXPECT_EQ(7, range.first->second);
+  range.first++;
+  EXPECT_TRUE(range.first == range.second);
+
+  EXPECT_TRUE(idx.find({1, 1, 13}) == idx.end());
+  EXPECT_EQ(2, idx.postings({1, 1, 12}).size());
+
+  EXPECT_EQ(2, idx.count({1, 1, 10}));
+  EXPECT_EQ(1, idx.count({1, 1, 11}));
+  EXPECT_EQ(0, idx.count({1, 1, 13}));
+  EXPECT_EQ(3, idx.count({1, 1, 11}, {1, 1, 12}));
+  EXPECT_EQ(5, idx.count({1, 1, 0}, {1, 1, 100}));
+
+  EXPECT_TRUE(idx.erase({1, 1, 10}, 5));
+  EXPECT_EQ(2, idx.erase({1, 1, 12}));
+  EXPECT_EQ(2, idx.size());
+  EXPECT_EQ(2, idx.begin()->second);
+}
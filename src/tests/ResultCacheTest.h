@@ -0,0 +1,94 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/resultcache.h>
+
+#include <atomic>
+#include <vector>
+
+using namespace annis;
+
+namespace
+{
+  std::vector<std::vector<Match>> createMatches(size_t numOfMatches)
+  {
+    std::vector<std::vector<Match>> result;
+    for(size_t i=0; i < numOfMatches; i++)
+    {
+      result.push_back({{static_cast<nodeid_t>(i), {0, 0, 0}}});
+    }
+    return result;
+  }
+}
+
+TEST(ResultCache, MatchRanges)
+{
+  ResultCache cache([]() -> size_t {return 1024*1024;});
+  const ResultCacheKey key = {"corpus", 1, "query"};
+
+  std::vector<std::vector<Match>> result;
+  EXPECT_FALSE(cache.getMatches(key, 0, 10, result));
+
+  cache.putMatches(key, createMatches(20), false);
+  ASSERT_TRUE(cache.getMatches(key, 5, 10, result));
+  ASSERT_EQ(10u, result.size());
+  EXPECT_EQ(5u, result[0][0].node);
+  // the range exceeds the first matches and the query was not complete
+  EXPECT_FALSE(cache.getMatches(key, 15, 10, result));
+  EXPECT_FALSE(cache.getMatches(key, 0, 0, result));
+  EXPECT_FALSE(cache.getCount(key).is_initialized());
+
+  cache.putMatches(key, createMatches(25), true);
+  ASSERT_TRUE(cache.getMatches(key, 15, 20, result));
+  EXPECT_EQ(10u, result.size());
+  ASSERT_TRUE(cache.getMatches(key, 30, 5, result));
+  EXPECT_TRUE(result.empty());
+  ASSERT_TRUE(cache.getCount(key).is_initialized());
+  EXPECT_EQ(25, *cache.getCount(key));
+
+  // a different change ID is a different entry
+  EXPECT_FALSE(cache.getMatches({"corpus", 2, "query"}, 0, 10, result));
+}
+
+TEST(ResultCache, Invalidate)
+{
+  ResultCache cache([]() -> size_t {return 1024*1024;});
+  cache.putCount({"a", 1, "q1"}, 10);
+  cache.putCount({"a", 2, "q2"}, 20);
+  cache.putCount({"b", 1, "q1"}, 30);
+  cache.putCount({"ab", 1, "q1"}, 40);
+
+  cache.invalidate("a");
+  EXPECT_FALSE(cache.getCount({"a", 1, "q1"}).is_initialized());
+  EXPECT_FALSE(cache.getCount({"a", 2, "q2"}).is_initialized());
+  EXPECT_EQ(30, *cache.getCount({"b", 1, "q1"}));
+  EXPECT_EQ(40, *cache.getCount({"ab", 1, "q1"}));
+}
+
+TEST(ResultCache, BudgetOnInsert)
+{
+  std::atomic<size_t> budget(1024*1024);
+  ResultCache cache([&budget]() -> size_t {return budget;});
+
+  cache.putMatches({"corpus", 1, "q1"}, createMatches(100), true);
+  cache.putMatches({"corpus", 1, "q2"}, createMatches(100), true);
+  const size_t sizeOfTwo = cache.estimateMemorySize();
+  ASSERT_GT(sizeOfTwo, 0u);
+  // mark q1 as the most recently used entry
+  EXPECT_TRUE(cache.getCount({"corpus", 1, "q1"}).is_initialized());
+
+  // The budget got smaller since the last insert, e.g. because a corpus was loaded.
+  // The next insert must not exceed it and removes the least recently used entries.
+  budget = sizeOfTwo;
+  cache.putMatches({"corpus", 1, "q3"}, createMatches(100), true);
+  EXPECT_LE(cache.estimateMemorySize(), budget.load());
+  EXPECT_TRUE(cache.getCount({"corpus", 1, "q3"}).is_initialized());
+  EXPECT_TRUE(cache.getCount({"corpus", 1, "q1"}).is_initialized());
+  EXPECT_FALSE(cache.getCount({"corpus", 1, "q2"}).is_initialized());
+
+  budget = 0;
+  cache.shrink();
+  EXPECT_EQ(0u, cache.estimateMemorySize());
+  EXPECT_FALSE(cache.getCount({"corpus", 1, "q1"}).is_initialized());
+}
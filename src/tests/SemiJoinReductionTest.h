@@ -0,0 +1,65 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+using namespace annis;
+
+class SemiJoinReductionTest : public TokenSequenceTest
+{
+};
+
+TEST_F(SemiJoinReductionTest, LargeOperand)
+{
+  db.nodeAnnos.calculateStatistics(db.strings);
+
+  // all token directly following a "t1" token
+  auto createQuery = [this](const QueryConfig& config, std::shared_ptr<EstimatedSearch> large, bool forceNestedLoop)
+  {
+    std::shared_ptr<SingleAlternativeQuery> q = std::make_shared<SingleAlternativeQuery>(db, config);
+    q->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"));
+    q->addNode(large);
+    q->addOperator(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1), 0, 1, forceNestedLoop);
+    return q;
+  };
+  const std::vector<std::vector<nodeid_t>> expected = sequenceTuples(1, 2);
+  ASSERT_EQ(numOfToken / 10, expected.size());
+
+  std::shared_ptr<EstimatedSearch> unfiltered = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  EXPECT_EQ(expected, collectNodeTuples(createQuery(QueryConfig(), unfiltered, true)));
+  EXPECT_FALSE(unfiltered->hasOutputFilter());
+
+  QueryConfig config;
+  config.semi_join_reduction = true;
+  config.enableHashJoin = false;
+  config.enableBandJoin = false;
+
+  // an index join never scans the large side, the filter would only evaluate the operator twice
+  std::shared_ptr<EstimatedSearch> innerSide = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  EXPECT_EQ(expected, collectNodeTuples(createQuery(config, innerSide, false)));
+  EXPECT_FALSE(innerSide->hasOutputFilter());
+
+  // the small side has more matches than allowed
+  QueryConfig configTooSmall = config;
+  configTooSmall.semi_join_max_size = numOfToken / 20;
+  std::shared_ptr<EstimatedSearch> notReduced = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  EXPECT_EQ(expected, collectNodeTuples(createQuery(configTooSmall, notReduced, true)));
+  EXPECT_FALSE(notReduced->hasOutputFilter());
+
+  // a nested loop scans both sides
+  std::shared_ptr<EstimatedSearch> filtered = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+  EXPECT_EQ(expected, collectNodeTuples(createQuery(config, filtered, true)));
+  EXPECT_TRUE(filtered->hasOutputFilter());
+
+  // only the token following the small operand are left in the large one
+  filtered->reset();
+  size_t numOfFiltered = 0;
+  std::vector<Match> tuple;
+  while(filtered->next(tuple))
+  {
+    EXPECT_EQ(db.strings.add("t2"), tuple[0].anno.val);
+    numOfFiltered++;
+  }
+  EXPECT_EQ(numOfToken / 10, numOfFiltered);
+}
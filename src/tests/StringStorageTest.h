@@ -0,0 +1,171 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/db.h>
+#include <annis/stringstorage.h>
+#include <annis/util/threadpool.h>
+
+#include <re2/re2.h>
+
+#include <cereal/archives/binary.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+
+using namespace annis;
+
+TEST(StringStorage, AddAndResolve)
+{
+  StringStorage strings;
+  std::uint32_t idA = strings.add("abc");
+  std::uint32_t idB = strings.add("");
+  std::uint32_t idC = strings.add("Stadt");
+
+  EXPECT_NE(STRING_STORAGE_ANY, idA);
+  EXPECT_EQ(idA, strings.add("abc"));
+  EXPECT_EQ(3, strings.size());
+
+  EXPECT_EQ("abc", strings.str(idA));
+  EXPECT_EQ("", strings.str(idB));
+  EXPECT_EQ("Stadt", strings.strRef(idC));
+  EXPECT_FALSE(strings.strOpt(STRING_STORAGE_ANY).is_initialized());
+  EXPECT_FALSE(strings.strOpt(1000).is_initialized());
+  EXPECT_FALSE(strings.strOpt(std::numeric_limits<std::uint32_t>::max()).is_initialized());
+
+  ASSERT_TRUE(strings.findID("Stadt").is_initialized());
+  EXPECT_EQ(idC, *strings.findID("Stadt"));
+  EXPECT_FALSE(strings.findID("Stad").is_initialized());
+
+  auto matches = strings.findRegex("St.*|abc");
+  EXPECT_EQ(2, matches.size());
+  EXPECT_EQ(1, matches.count(idA));
+  EXPECT_EQ(1, matches.count(idC));
+}
+
+TEST(StringStorage, SerializeAndImportLegacy)
+{
+  StringStorage orig;
+  orig.add("first");
+  orig.add("second");
+
+  std::stringstream ss;
+  {
+    cereal::BinaryOutputArchive ar(ss);
+    ar(orig);
+  }
+  StringStorage copy;
+  {
+    cereal::BinaryInputArchive ar(ss);
+    ar(copy);
+  }
+  ASSERT_EQ(2, copy.size());
+  EXPECT_EQ(*orig.findID("second"), *copy.findID("second"));
+
+  // the old format stored a map for each direction and could contain gaps in the IDs
+  std::unordered_map<std::uint32_t, std::string> legacyByID = {{1, "x"}, {5, "y"}};
+  btree::btree_map<std::string, std::uint32_t> legacyByValue;
+  legacyByValue.insert({"x", 1});
+  legacyByValue.insert({"y", 5});
+  std::stringstream legacy;
+  {
+    cereal::BinaryOutputArchive ar(legacy);
+    ar(legacyByID, legacyByValue);
+  }
+  StringStorage imported;
+  {
+    cereal::BinaryInputArchive ar(legacy);
+    imported.loadLegacy(ar);
+  }
+  ASSERT_EQ(2, imported.size());
+  EXPECT_EQ("y", imported.str(5));
+  EXPECT_FALSE(imported.strOpt(3).is_initialized());
+  EXPECT_EQ(6, imported.add("z"));
+}
+
+TEST(StringStorage, SaveAndLoadMapped)
+{
+  StringStorage orig;
+  std::uint32_t idA = orig.add("abc");
+  std::uint32_t idB = orig.add("Zebra");
+  std::uint32_t idC = orig.add("");
+
+  boost::filesystem::path path = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("annis-strings-%%%%-%%%%.annis");
+  ASSERT_TRUE(orig.saveMapped(path.string()));
+
+  StringStorage mapped;
+  ASSERT_TRUE(mapped.loadMapped(path.string()));
+  EXPECT_EQ(3, mapped.size());
+  EXPECT_EQ("abc", mapped.str(idA));
+  EXPECT_EQ("Zebra", mapped.str(idB));
+  EXPECT_EQ("", mapped.str(idC));
+  EXPECT_EQ(idB, *mapped.findID("Zebra"));
+
+  // adding new strings copies the mapped data first
+  std::uint32_t idD = mapped.add("xyz");
+  EXPECT_EQ("xyz", mapped.str(idD));
+  EXPECT_EQ("abc", mapped.str(idA));
+  EXPECT_EQ(idA, *mapped.findID("abc"));
+
+  boost::filesystem::remove(path);
+
+  StringStorage missing;
+  EXPECT_FALSE(missing.loadMapped(path.string()));
+}
+
+TEST(StringStorage, FindRegexIDs)
+{
+  StringStorage strings;
+  std::vector<std::uint32_t> expected;
+  for(size_t i=0; i < 5000; i++)
+  {
+    std::uint32_t id = strings.add("Stadt" + std::to_string(i));
+    if(i % 10 == 3)
+    {
+      expected.push_back(id);
+    }
+    strings.add("Land" + std::to_string(i));
+  }
+
+  RE2 prefixRegex("Stadt[0-9]*3");
+  EXPECT_EQ(expected, strings.findRegexIDs(prefixRegex));
+  EXPECT_EQ(100, strings.countRegexCandidates(prefixRegex, 100));
+
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(4);
+  EXPECT_EQ(expected, strings.findRegexIDs(prefixRegex, pool, 4));
+
+  // a pattern without a fixed prefix must check all strings
+  RE2 unboundRegex(".*adt[0-9]*3");
+  EXPECT_EQ(expected, strings.findRegexIDs(unboundRegex, pool, 4));
+
+  // searching inside a task of the same pool must not wait for parts which can't be started
+  std::shared_ptr<ThreadPool> singlePool = std::make_shared<ThreadPool>(1);
+  std::future<std::vector<std::uint32_t>> nested = singlePool->enqueue([&strings, &prefixRegex, &singlePool]()
+  {
+    return strings.findRegexIDs(prefixRegex, singlePool, 4);
+  });
+  ASSERT_EQ(std::future_status::ready, nested.wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(expected, nested.get());
+}
+
+TEST(StringStorage, DBSaveFailure)
+{
+  boost::filesystem::path dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("annis-db-%%%%-%%%%");
+  boost::filesystem::path currentDir = dir / "current";
+  boost::filesystem::create_directories(currentDir);
+  {
+    std::ofstream legacy((currentDir / "strings.cereal").string());
+    legacy << "legacy";
+  }
+  // the strings can't be written if there is a (non-empty) directory with the same name
+  boost::filesystem::create_directories(currentDir / "strings.annis" / "blocked");
+
+  DB db;
+  EXPECT_FALSE(db.save(dir.string()));
+  // the strings in the older format must not be removed
+  EXPECT_TRUE(boost::filesystem::is_regular_file(currentDir / "strings.cereal"));
+
+  boost::filesystem::remove_all(dir);
+}
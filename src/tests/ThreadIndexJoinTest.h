@@ -0,0 +1,93 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/join/threadindexjoin.h>
+#include <annis/util/threadpool.h>
+
+#include <algorithm>
+
+using namespace annis;
+
+class ThreadIndexJoinTest : public TokenSequenceTest
+{
+};
+
+TEST_F(ThreadIndexJoinTest, SharedPool)
+{
+  std::vector<std::pair<nodeid_t, nodeid_t>> expected;
+  for(const std::vector<Match>& t : collectTuples(createJoin(false)))
+  {
+    expected.push_back({t[0].node, t[1].node});
+  }
+
+  // the pool is shared by two joins which are executed at the same time
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(4);
+  std::shared_ptr<Iterator> join1 = std::make_shared<ThreadIndexJoin>(
+        std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 0,
+        std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), tokenAnnos(), 3, pool);
+  std::shared_ptr<Iterator> join2 = std::make_shared<ThreadIndexJoin>(
+        std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 0,
+        std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), tokenAnnos(), 3, pool);
+
+  std::vector<std::pair<nodeid_t, nodeid_t>> result1;
+  std::vector<std::pair<nodeid_t, nodeid_t>> result2;
+  std::vector<Match> tuple;
+  bool hasNext1 = true;
+  bool hasNext2 = true;
+  while(hasNext1 || hasNext2)
+  {
+    if(hasNext1 && (hasNext1 = join1->next(tuple)))
+    {
+      result1.push_back({tuple[0].node, tuple[1].node});
+    }
+    if(hasNext2 && (hasNext2 = join2->next(tuple)))
+    {
+      result2.push_back({tuple[0].node, tuple[1].node});
+    }
+  }
+
+  std::sort(expected.begin(), expected.end());
+  std::sort(result1.begin(), result1.end());
+  std::sort(result2.begin(), result2.end());
+  EXPECT_EQ(expected, result1);
+  EXPECT_EQ(expected, result2);
+}
+
+TEST_F(ThreadIndexJoinTest, SingleWorker)
+{
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(1);
+  // small morsels produce more result batches than fit into the queue
+  std::shared_ptr<Iterator> join1 = std::make_shared<ThreadIndexJoin>(
+        std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 0,
+        std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), tokenAnnos(), 2, pool, 16);
+  std::shared_ptr<Iterator> join2 = std::make_shared<ThreadIndexJoin>(
+        std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 0,
+        std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), tokenAnnos(), 2, pool, 16);
+
+  // The tasks of the second join fill its queue while nobody consumes it. They must return the only worker,
+  // otherwise the first join could never produce a result.
+  std::vector<Match> tuple;
+  ASSERT_TRUE(join2->next(tuple));
+  EXPECT_EQ(2*numOfToken - 3, collectTuples(join1).size());
+  EXPECT_EQ(2*numOfToken - 4, collectTuples(join2).size());
+}
+
+TEST_F(ThreadIndexJoinTest, Abort)
+{
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(2);
+  for(int i=0; i < 10; i++)
+  {
+    // stop consuming while the tasks are still producing results, this must not block
+    std::shared_ptr<Iterator> join = std::make_shared<ThreadIndexJoin>(
+          std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok), 0,
+          std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2), tokenAnnos(), 2, pool);
+    std::vector<Match> tuple;
+    ASSERT_TRUE(join->next(tuple));
+
+    join->reset();
+    ASSERT_TRUE(join->next(tuple));
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "TokenSequenceTest.h"
+
+#include <annis/join/threadnestedloop.h>
+#include <annis/util/threadpool.h>
+
+using namespace annis;
+
+class ThreadNestedLoopTest : public TokenSequenceTest
+{
+};
+
+TEST_F(ThreadNestedLoopTest, SingleWorker)
+{
+  std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(1);
+  auto createJoin = [this, pool]() -> std::shared_ptr<Iterator>
+  {
+    return std::make_shared<ThreadNestedLoop>(std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2),
+                                              std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"),
+                                              std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok),
+                                              0, 0, true, 2, pool);
+  };
+  std::shared_ptr<Iterator> join1 = createJoin();
+  std::shared_ptr<Iterator> join2 = createJoin();
+
+  // The tasks of the second join fill its queue while nobody consumes it. They must return the only worker,
+  // otherwise the first join could never produce a result.
+  std::vector<Match> tuple;
+  ASSERT_TRUE(join2->next(tuple));
+  EXPECT_EQ(2 * numOfToken / 10, collectTuples(join1).size());
+  EXPECT_EQ(2 * numOfToken / 10 - 1, collectTuples(join2).size());
+
+  // the join can be executed again after a reset
+  join1->reset();
+  EXPECT_EQ(2 * numOfToken / 10, collectTuples(join1).size());
+}
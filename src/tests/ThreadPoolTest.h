@@ -0,0 +1,84 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/util/threadpool.h>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+using namespace annis;
+
+TEST(ThreadPool, NestedTasks)
+{
+  ThreadPool pool(2);
+
+  // each task waits for its own sub-tasks, which only works if the waiting worker executes them itself
+  std::vector<std::future<int>> results;
+  for(int i=0; i < 8; i++)
+  {
+    results.emplace_back(pool.enqueue([&pool, i]() -> int
+    {
+      std::vector<std::future<int>> sub;
+      for(int j=0; j < 4; j++)
+      {
+        sub.emplace_back(pool.enqueue([i, j]() {return i*4 + j;}));
+      }
+      int sum = 0;
+      for(auto& f : sub)
+      {
+        sum += pool.waitFor(f);
+      }
+      return sum;
+    }));
+  }
+
+  for(int i=0; i < 8; i++)
+  {
+    EXPECT_EQ(16*i + 6, pool.waitFor(results[i]));
+  }
+}
+
+TEST(ThreadPool, DestructorExecutesQueuedTasks)
+{
+  std::atomic<int> numOfExecuted(0);
+  std::vector<std::future<void>> results;
+  {
+    ThreadPool pool(1);
+    std::promise<void> blockWorker;
+    std::shared_future<void> blocked = blockWorker.get_future().share();
+    results.emplace_back(pool.enqueue([blocked, &numOfExecuted]()
+    {
+      blocked.wait();
+      numOfExecuted++;
+    }));
+    // the single worker is blocked, so these tasks are still queued when the pool is destroyed
+    for(int i=0; i < 10; i++)
+    {
+      results.emplace_back(pool.enqueue([&numOfExecuted]() {numOfExecuted++;}));
+    }
+    blockWorker.set_value();
+  }
+
+  EXPECT_EQ(11, numOfExecuted.load());
+  for(auto& f : results)
+  {
+    ASSERT_EQ(std::future_status::ready, f.wait_for(std::chrono::seconds(0)));
+    EXPECT_NO_THROW(f.get());
+  }
+}
+
+TEST(ThreadPool, NoWorker)
+{
+  std::future<int> result;
+  {
+    ThreadPool pool(0);
+    result = pool.enqueue([]() {return 42;});
+    // the waiting thread executes the task itself
+    std::future<int> other = pool.enqueue([]() {return 1;});
+    EXPECT_EQ(1, pool.waitFor(other));
+  }
+  ASSERT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds(0)));
+  EXPECT_EQ(42, result.get());
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/api/graphupdate.h>
+#include <annis/db.h>
+#include <annis/graphstorage/graphstorage.h>
+#include <annis/operators/inclusion.h>
+#include <annis/operators/overlap.h>
+#include <annis/operators/precedence.h>
+#include <annis/util/tokenindex.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+using namespace annis;
+
+class TokenIndexTest : public ::testing::Test
+{
+protected:
+  DB db;
+
+  virtual void SetUp() override
+  {
+    /*
+     * Two texts with the token 1 2 3 4 and 5 6, node 7 is a span covering 2-3 and
+     * node 8 a span covering 3-4.
+     */
+    for(nodeid_t n=1; n <= 8; n++)
+    {
+      db.nodeAnnos.addAnnotation(n, {db.getNodeNameStringID(), db.getNamespaceStringID(),
+                                     db.strings.add("n" + std::to_string(n))});
+      if(n <= 6)
+      {
+        db.nodeAnnos.addAnnotation(n, {db.getTokStringID(), db.getNamespaceStringID(),
+                                       db.strings.add("t" + std::to_string(n))});
+      }
+    }
+
+    auto order = db.createWritableGraphStorage(ComponentType::ORDERING, annis_ns, "");
+    order->addEdge({1, 2});
+    order->addEdge({2, 3});
+    order->addEdge({3, 4});
+    order->addEdge({5, 6});
+
+    auto cov = db.createWritableGraphStorage(ComponentType::COVERAGE, annis_ns, "");
+    auto invCov = db.createWritableGraphStorage(ComponentType::INVERSE_COVERAGE, annis_ns, "");
+    auto left = db.createWritableGraphStorage(ComponentType::LEFT_TOKEN, annis_ns, "");
+    auto right = db.createWritableGraphStorage(ComponentType::RIGHT_TOKEN, annis_ns, "");
+    for(const Edge& e : std::vector<Edge>{{7, 2}, {7, 3}, {8, 3}, {8, 4}})
+    {
+      cov->addEdge(e);
+      invCov->addEdge({e.target, e.source});
+    }
+    left->addEdge({7, 2});
+    right->addEdge({7, 3});
+    left->addEdge({8, 3});
+    right->addEdge({8, 4});
+  }
+};
+
+TEST_F(TokenIndexTest, TokenAndPositions)
+{
+  db.updateTokenIndex();
+  std::shared_ptr<const TokenIndex> index = db.getTokenIndex();
+  ASSERT_TRUE(index != nullptr);
+
+  EXPECT_TRUE(index->isToken(1));
+  EXPECT_TRUE(index->isToken(6));
+  EXPECT_FALSE(index->isToken(7));
+  EXPECT_EQ(2, index->left(7));
+  EXPECT_EQ(3, index->right(7));
+  EXPECT_EQ(4, index->left(4));
+
+  ASSERT_TRUE(index->hasPositions());
+  EXPECT_EQ(3, index->distance(1, 4));
+  EXPECT_EQ(0, index->distance(2, 2));
+  EXPECT_EQ(-1, index->distance(4, 1));
+  EXPECT_EQ(-1, index->distance(4, 5));
+  EXPECT_TRUE(index->isConnected(5, 6, 1, 1));
+  EXPECT_FALSE(index->isConnected(1, 4, 1, 2));
+}
+
+TEST_F(TokenIndexTest, OperatorsSameResultAsGraph)
+{
+  // create the operators once without and once with the index
+  db.setTokenIndexEnabled(false);
+  Precedence precGraph(db, db.f_getGraphStorage, 1, 2);
+  Overlap overlapGraph(db, db.f_getGraphStorage);
+  Inclusion inclusionGraph(db, db.f_getGraphStorage);
+
+  db.setTokenIndexEnabled(true);
+  Precedence precIndex(db, db.f_getGraphStorage, 1, 2);
+  Overlap overlapIndex(db, db.f_getGraphStorage);
+  Inclusion inclusionIndex(db, db.f_getGraphStorage);
+
+  Annotation anyAnno = {0, 0, 0};
+  for(nodeid_t lhs=1; lhs <= 8; lhs++)
+  {
+    for(nodeid_t rhs=1; rhs <= 8; rhs++)
+    {
+      Match m1 = {lhs, anyAnno};
+      Match m2 = {rhs, anyAnno};
+      EXPECT_EQ(precGraph.filter(m1, m2), precIndex.filter(m1, m2)) << lhs << " . " << rhs;
+      EXPECT_EQ(overlapGraph.filter(m1, m2), overlapIndex.filter(m1, m2)) << lhs << " _o_ " << rhs;
+      EXPECT_EQ(inclusionGraph.filter(m1, m2), inclusionIndex.filter(m1, m2)) << lhs << " _i_ " << rhs;
+    }
+  }
+}
+
+TEST_F(TokenIndexTest, IntervalIndex)
+{
+  // the inclusion operator searches the aligned nodes from the token, add the edges like the relANNIS import does
+  db.createWritableGraphStorage(ComponentType::LEFT_TOKEN, annis_ns, "")->addEdge({2, 7});
+  db.createWritableGraphStorage(ComponentType::RIGHT_TOKEN, annis_ns, "")->addEdge({3, 7});
+  db.createWritableGraphStorage(ComponentType::LEFT_TOKEN, annis_ns, "")->addEdge({3, 8});
+  db.createWritableGraphStorage(ComponentType::RIGHT_TOKEN, annis_ns, "")->addEdge({4, 8});
+
+  db.setTokenIndexEnabled(false);
+  Overlap overlapGraph(db, db.f_getGraphStorage);
+  Inclusion inclusionGraph(db, db.f_getGraphStorage);
+
+  db.setTokenIndexEnabled(true);
+  std::shared_ptr<const TokenIndex> index = db.getTokenIndex();
+  ASSERT_TRUE(index != nullptr);
+  Overlap overlapIndex(db, db.f_getGraphStorage);
+  Inclusion inclusionIndex(db, db.f_getGraphStorage);
+
+  std::vector<nodeid_t> result;
+  ASSERT_TRUE(index->findOverlapping(2, 2, result));
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(std::vector<nodeid_t>({2, 7}), result);
+
+  result.clear();
+  ASSERT_TRUE(index->findIncluded(2, 4, result));
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(std::vector<nodeid_t>({2, 3, 4, 7, 8}), result);
+
+  // ranges over different texts are not possible
+  result.clear();
+  EXPECT_FALSE(index->findIncluded(4, 5, result));
+
+  auto collect = [](std::unique_ptr<AnnoIt> it)
+  {
+    std::vector<nodeid_t> nodes;
+    Match m;
+    while(it && it->next(m))
+    {
+      nodes.push_back(m.node);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+  };
+
+  Annotation anyAnno = {0, 0, 0};
+  for(nodeid_t lhs=1; lhs <= 8; lhs++)
+  {
+    Match m = {lhs, anyAnno};
+    EXPECT_EQ(collect(overlapGraph.retrieveMatches(m)), collect(overlapIndex.retrieveMatches(m))) << lhs << " _o_";
+    EXPECT_EQ(collect(inclusionGraph.retrieveMatches(m)), collect(inclusionIndex.retrieveMatches(m))) << lhs << " _i_";
+  }
+}
+
+TEST_F(TokenIndexTest, RebuiltAfterUpdate)
+{
+  std::shared_ptr<const TokenIndex> index = db.getTokenIndex();
+  ASSERT_TRUE(index != nullptr);
+  // the index is built only once
+  EXPECT_EQ(index, db.getTokenIndex());
+  EXPECT_FALSE(index->contains(9));
+
+  api::GraphUpdate u;
+  u.addNode("n9");
+  u.addNodeLabel("n9", annis_ns, annis_tok, "t9");
+  u.addEdge("n6", "n9", annis_ns, "ORDERING", "");
+  u.finish();
+  db.update(u);
+
+  // the old index is not changed
+  EXPECT_FALSE(index->contains(9));
+
+  std::shared_ptr<const TokenIndex> updated = db.getTokenIndex();
+  ASSERT_TRUE(updated != nullptr);
+  EXPECT_NE(index, updated);
+  boost::optional<nodeid_t> newToken = db.getNodeID("n9");
+  ASSERT_TRUE(newToken.is_initialized());
+  EXPECT_TRUE(updated->isToken(*newToken));
+  EXPECT_EQ(2, updated->distance(5, *newToken));
+}
+
+TEST_F(TokenIndexTest, OnlyTokenComponentsLoaded)
+{
+  db.createWritableGraphStorage(ComponentType::POINTING, "test", "dep")->addEdge({7, 8});
+  boost::filesystem::path dir = boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("annis-db-%%%%-%%%%");
+  ASSERT_TRUE(db.save(dir.string()));
+
+  DB lazy;
+  ASSERT_TRUE(lazy.load(dir.string(), false));
+  ASSERT_FALSE(lazy.isGraphStorageLoaded(ComponentType::LEFT_TOKEN, annis_ns, ""));
+
+  // the index loads the token related components, but no other component
+  std::shared_ptr<const TokenIndex> index = lazy.getTokenIndex();
+  ASSERT_TRUE(index != nullptr);
+  for(ComponentType type : {ComponentType::COVERAGE, ComponentType::LEFT_TOKEN, ComponentType::RIGHT_TOKEN,
+                            ComponentType::ORDERING})
+  {
+    EXPECT_TRUE(lazy.isGraphStorageLoaded(type, annis_ns, ""));
+  }
+  EXPECT_FALSE(lazy.isGraphStorageLoaded(ComponentType::POINTING, "test", "dep"));
+  EXPECT_FALSE(lazy.allGraphStoragesLoaded());
+
+  EXPECT_TRUE(index->isToken(4));
+  EXPECT_EQ(3, index->left(8));
+  EXPECT_EQ(4, index->right(8));
+
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(TokenIndex, IntervalEdgeCases)
+{
+  DB db;
+  const nodeid_t numOfToken = 100;
+  auto order = db.createWritableGraphStorage(ComponentType::ORDERING, annis_ns, "");
+  auto left = db.createWritableGraphStorage(ComponentType::LEFT_TOKEN, annis_ns, "");
+  auto right = db.createWritableGraphStorage(ComponentType::RIGHT_TOKEN, annis_ns, "");
+  db.createWritableGraphStorage(ComponentType::COVERAGE, annis_ns, "");
+
+  for(nodeid_t t=1; t <= numOfToken; t++)
+  {
+    db.nodeAnnos.addAnnotation(t, {db.getNodeNameStringID(), db.getNamespaceStringID(),
+                                   db.strings.add("t" + std::to_string(t))});
+    db.nodeAnnos.addAnnotation(t, {db.getTokStringID(), db.getNamespaceStringID(), db.strings.add("tok")});
+    if(t > 1)
+    {
+      order->addEdge({t-1, t});
+    }
+  }
+
+  // a span over the whole text, spans with a single token, spans which touch each other and random spans
+  std::vector<std::pair<nodeid_t, nodeid_t>> spans = {{1, numOfToken}, {1, 1}, {numOfToken, numOfToken}, {50, 50},
+                                                      {10, 20}, {20, 30}, {21, 30}, {1, 99}, {2, numOfToken}};
+  std::uint32_t rand = 42;
+  for(int i=0; i < 200; i++)
+  {
+    rand = rand * 1103515245 + 12345;
+    const nodeid_t l = 1 + (rand >> 8) % numOfToken;
+    rand = rand * 1103515245 + 12345;
+    // mostly short spans, but some long ones
+    const nodeid_t length = (i % 10 == 0) ? (rand >> 8) % numOfToken : (rand >> 8) % 5;
+    spans.push_back({l, std::min(l + length, numOfToken)});
+  }
+  for(size_t i=0; i < spans.size(); i++)
+  {
+    const nodeid_t n = numOfToken + 1 + static_cast<nodeid_t>(i);
+    db.nodeAnnos.addAnnotation(n, {db.getNodeNameStringID(), db.getNamespaceStringID(),
+                                   db.strings.add("s" + std::to_string(i))});
+    left->addEdge({n, spans[i].first});
+    right->addEdge({n, spans[i].second});
+  }
+  for(nodeid_t t=1; t <= numOfToken; t++)
+  {
+    // each token is its own interval
+    spans.insert(spans.begin() + (t-1), {t, t});
+  }
+
+  std::shared_ptr<const TokenIndex> index = db.getTokenIndex();
+  ASSERT_TRUE(index != nullptr);
+  ASSERT_TRUE(index->hasPositions());
+
+  for(nodeid_t from=1; from <= numOfToken; from++)
+  {
+    for(nodeid_t to=from; to <= numOfToken; to++)
+    {
+      std::vector<nodeid_t> expectedOverlap;
+      std::vector<nodeid_t> expectedIncluded;
+      for(size_t i=0; i < spans.size(); i++)
+      {
+        // the token are the nodes 1 to numOfToken, the spans are the following ones
+        const nodeid_t n = static_cast<nodeid_t>(i + 1);
+        if(spans[i].first <= to && spans[i].second >= from)
+        {
+          expectedOverlap.push_back(n);
+        }
+        if(spans[i].first >= from && spans[i].second <= to)
+        {
+          expectedIncluded.push_back(n);
+        }
+      }
+
+      std::vector<nodeid_t> overlap;
+      ASSERT_TRUE(index->findOverlapping(from, to, overlap));
+      std::sort(overlap.begin(), overlap.end());
+      ASSERT_EQ(expectedOverlap, overlap) << from << "-" << to;
+
+      std::vector<nodeid_t> included;
+      ASSERT_TRUE(index->findIncluded(from, to, included));
+      std::sort(included.begin(), included.end());
+      ASSERT_EQ(expectedIncluded, included) << from << "-" << to;
+    }
+  }
+  // the range must not be reversed
+  std::vector<nodeid_t> result;
+  EXPECT_FALSE(index->findOverlapping(numOfToken, 1, result));
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <annis/db.h>
+#include <annis/annosearch/exactannokeysearch.h>
+#include <annis/annosearch/exactannovaluesearch.h>
+#include <annis/annosearch/regexannosearch.h>
+#include <annis/filter/binaryfilter.h>
+#include <annis/graphstorage/graphstorage.h>
+#include <annis/join/indexjoin.h>
+#include <annis/json/jsonqueryparser.h>
+#include <annis/operators/precedence.h>
+#include <annis/query/query.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace annis;
+
+/**
+ * @brief A sequence of token with the values t0 to t9, which is shared by the tests of the query execution.
+ */
+class TokenSequenceTest : public ::testing::Test
+{
+protected:
+  DB db;
+
+  /** More token than fit into a single batch */
+  const nodeid_t numOfToken = 3000;
+
+  virtual void SetUp() override
+  {
+    for(nodeid_t n=1; n <= numOfToken; n++)
+    {
+      db.nodeAnnos.addAnnotation(n, {db.getNodeNameStringID(), db.getNamespaceStringID(),
+                                     db.strings.add("n" + std::to_string(n))});
+      db.nodeAnnos.addAnnotation(n, {db.getTokStringID(), db.getNamespaceStringID(),
+                                     db.strings.add("t" + std::to_string(n % 10))});
+    }
+    auto order = db.createWritableGraphStorage(ComponentType::ORDERING, annis_ns, "");
+    for(nodeid_t n=1; n < numOfToken; n++)
+    {
+      order->addEdge({n, n+1});
+    }
+    db.createWritableGraphStorage(ComponentType::COVERAGE, annis_ns, "");
+    db.createWritableGraphStorage(ComponentType::LEFT_TOKEN, annis_ns, "");
+    db.createWritableGraphStorage(ComponentType::RIGHT_TOKEN, annis_ns, "");
+  }
+
+  std::function<std::list<Annotation>(nodeid_t)> tokenAnnos()
+  {
+    const DB& constDB = db;
+    return [&constDB](nodeid_t n) -> std::list<Annotation>
+    {
+      std::list<Annotation> result;
+      boost::optional<Annotation> anno =
+          constDB.nodeAnnos.getAnnotations(n, constDB.getNamespaceStringID(), constDB.getTokStringID());
+      if(anno)
+      {
+        result.push_back(*anno);
+      }
+      return result;
+    };
+  }
+
+  std::shared_ptr<Iterator> createJoin(bool withFilter)
+  {
+    std::shared_ptr<Iterator> lhs = std::make_shared<ExactAnnoKeySearch>(db, annis_ns, annis_tok);
+    std::shared_ptr<Operator> op = std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 2);
+    std::shared_ptr<Iterator> join = std::make_shared<IndexJoin>(db, op, lhs, 0, tokenAnnos(), true);
+    if(withFilter)
+    {
+      std::shared_ptr<Operator> direct = std::make_shared<Precedence>(db, db.f_getGraphStorage, 1, 1);
+      join = std::make_shared<BinaryFilter>(direct, join, 0, 1);
+    }
+    return join;
+  }
+
+  /**
+   * @brief Create the query tok="t1" | tok=/t[12]/ | tok="t3" which has overlapping alternatives.
+   */
+  std::shared_ptr<Query> createDisjunction(const QueryConfig& config)
+  {
+    std::vector<std::shared_ptr<SingleAlternativeQuery>> alternatives;
+
+    alternatives.push_back(std::make_shared<SingleAlternativeQuery>(db, config));
+    alternatives.back()->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t1"));
+
+    alternatives.push_back(std::make_shared<SingleAlternativeQuery>(db, config));
+    alternatives.back()->addNode(std::make_shared<RegexAnnoSearch>(db, annis_ns, annis_tok, "t[12]"));
+
+    alternatives.push_back(std::make_shared<SingleAlternativeQuery>(db, config));
+    alternatives.back()->addNode(std::make_shared<ExactAnnoValueSearch>(db, annis_ns, annis_tok, "t3"));
+
+    return std::make_shared<Query>(alternatives, config);
+  }
+
+  /**
+   * @brief Parse the query for a sequence of directly preceding token with the given values.
+   */
+  std::shared_ptr<Query> parseSequence(const std::vector<std::string>& values, const QueryConfig& config)
+  {
+    std::stringstream json;
+    json << "{\"alternatives\":[{\"nodes\":{";
+    for(size_t i=0; i < values.size(); i++)
+    {
+      json << (i > 0 ? "," : "") << "\"" << (i+1) << "\":{\"id\":" << (i+1)
+           << ",\"nodeAnnotations\":[{\"namespace\":\"annis\",\"name\":\"tok\",\"value\":\"" << values[i]
+           << "\",\"textMatching\":\"EXACT_EQUAL\"}],\"root\":false,\"token\":false}";
+    }
+    json << "},\"joins\":[";
+    for(size_t i=1; i < values.size(); i++)
+    {
+      json << (i > 1 ? "," : "") << "{\"op\":\"Precedence\",\"minDistance\":1,\"maxDistance\":1,"
+           << "\"left\":" << i << ",\"right\":" << (i+1) << "}";
+    }
+    json << "]}]}";
+    return JSONQueryParser::parse(db, json, config);
+  }
+
+  static std::vector<nodeid_t> collectNodes(std::shared_ptr<Query> q)
+  {
+    std::vector<nodeid_t> result;
+    while(q->next())
+    {
+      result.push_back(q->getCurrent()[0].node);
+    }
+    return result;
+  }
+
+  static std::vector<std::vector<Match>> collectTuples(std::shared_ptr<Iterator> it)
+  {
+    std::vector<std::vector<Match>> result;
+    std::vector<Match> tuple;
+    while(it->next(tuple))
+    {
+      result.push_back(tuple);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Return the node IDs of all sequences of directly preceding token which start with the token value
+   * "t<first>", sorted.
+   */
+  std::vector<std::vector<nodeid_t>> sequenceTuples(nodeid_t first, nodeid_t length) const
+  {
+    std::vector<std::vector<nodeid_t>> result;
+    for(nodeid_t n=1; n + length - 1 <= numOfToken; n++)
+    {
+      if(n % 10 == first % 10)
+      {
+        std::vector<nodeid_t> tuple;
+        for(nodeid_t i=0; i < length; i++)
+        {
+          tuple.push_back(n + i);
+        }
+        result.push_back(tuple);
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Return the node IDs of all result tuples of the query, sorted.
+   */
+  template<typename QueryType>
+  static std::vector<std::vector<nodeid_t>> collectNodeTuples(std::shared_ptr<QueryType> q)
+  {
+    std::vector<std::vector<nodeid_t>> result;
+    while(q->next())
+    {
+      std::vector<nodeid_t> tuple;
+      for(const Match& m : q->getCurrent())
+      {
+        tuple.push_back(m.node);
+      }
+      result.push_back(tuple);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+};
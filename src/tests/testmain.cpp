@@ -24,6 +24,27 @@
 #include "SearchTestGUM.h"
 #include "CorpusStorageManagerTest.h"
 #include "DFSTest.h"
+#include "StringStorageTest.h"
+#include "AnnoStorageTest.h"
+#include "PostingListTest.h"
+#include "CSRStorageTest.h"
+#include "TokenIndexTest.h"
+#include "JoinBatchTest.h"
+#include "ThreadIndexJoinTest.h"
+#include "ThreadNestedLoopTest.h"
+#include "ParallelSearchTest.h"
+#include "ParallelAlternativesTest.h"
+#include "CountTest.h"
+#include "PlanCacheTest.h"
+#include "JoinOrderTest.h"
+#include "AdaptiveReoptimizationTest.h"
+#include "SemiJoinReductionTest.h"
+#include "HashJoinTest.h"
+#include "BandJoinTest.h"
+#include "MultiwayJoinTest.h"
+#include "BoundedQueueTest.h"
+#include "ThreadPoolTest.h"
+#include "ResultCacheTest.h"
 
 int main(int argc, char **argv)
 {